@@ -0,0 +1,15 @@
+#!/usr/bin/env bash
+
+set -x
+
+mpirun ./rbc_validator_mpi --mode=none -rv -m2
+mpirun ./rbc_validator_mpi --mode=none -bv -m2
+
+[[ $(./rbc_validator_mpi --mode=none -rvca -m2 |& grep searched | cut -d' ' -f4) == 32897 ]]
+[[ $(./rbc_validator_mpi --mode=none -rvcaf -m2 |& grep searched | cut -d' ' -f4) == 32640 ]]
+
+[[ $(mpirun ./rbc_validator_mpi --mode=none -rvca -m2 |& grep searched | cut -d' ' -f4) == 32897 ]]
+[[ $(mpirun ./rbc_validator_mpi --mode=none -rvcaf -m2 |& grep searched | cut -d' ' -f4) == 32640 ]]
+
+# Crosses the 64-bit word boundaries
+[[ $(mpirun ./rbc_validator_mpi --mode=none -rvcaf -m3 -s130 |& grep searched | cut -d' ' -f4) == 357760 ]]
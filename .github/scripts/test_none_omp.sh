@@ -0,0 +1,16 @@
+#!/usr/bin/env bash
+
+set -x
+
+./rbc_validator --mode=none -rv -m2
+./rbc_validator --mode=none -bv -m2
+
+[[ $(./rbc_validator --mode=none -rvca -m2 -t1 |& grep searched | cut -d' ' -f4) == 32897 ]]
+[[ $(./rbc_validator --mode=none -rvcaf -m2 -t1 |& grep searched | cut -d' ' -f4) == 32640 ]]
+
+[[ $(./rbc_validator --mode=none -rvca -m2 |& grep searched | cut -d' ' -f4) == 32897 ]]
+[[ $(./rbc_validator --mode=none -rvcaf -m2 |& grep searched | cut -d' ' -f4) == 32640 ]]
+
+# Crosses the 64-bit word boundaries with an uneven split between threads
+[[ $(./rbc_validator --mode=none -rvcaf -m3 -s130 -t3 |& grep searched | cut -d' ' -f4) == 357760 ]]
+[[ $(./rbc_validator --mode=none -rvcaf -m256 -t2 |& grep searched | cut -d' ' -f4) == 1 ]]
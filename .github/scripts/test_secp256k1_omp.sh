@@ -0,0 +1,24 @@
+#!/usr/bin/env bash
+
+set -x
+
+./rbc_validator --mode=secp256k1 -rv -m2
+./rbc_validator --mode=secp256k1 -bv -m2
+
+# Compressed Form
+[[ $(./rbc_validator --mode=secp256k1 -v -m2 \
+    000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f \
+    02042f4a6ff316499cc2a40a8d911c1b5ccb19bfa2ce9b454960346d0044a95cff) == \
+  "100102030405060718090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f" ]]
+
+# Uncompressed Form
+[[ $(./rbc_validator --mode=secp256k1 -v -m2 \
+    000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f \
+    04042f4a6ff316499cc2a40a8d911c1b5ccb19bfa2ce9b454960346d0044a95cff79218e83c6838477fd8b82d4c1248b50439f1adab6f0be5ede9f2e56916c1c6e) == \
+  "100102030405060718090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f" ]]
+
+[[ $(./rbc_validator --mode=secp256k1 -rvca -m2 -t1 |& grep searched | cut -d' ' -f4) == 32897 ]]
+[[ $(./rbc_validator --mode=secp256k1 -rvcaf -m2 -t1 |& grep searched | cut -d' ' -f4) == 32640 ]]
+
+[[ $(./rbc_validator --mode=secp256k1 -rvca -m2 |& grep searched | cut -d' ' -f4) == 32897 ]]
+[[ $(./rbc_validator --mode=secp256k1 -rvcaf -m2 |& grep searched | cut -d' ' -f4) == 32640 ]]
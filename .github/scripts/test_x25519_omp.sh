@@ -0,0 +1,17 @@
+#!/usr/bin/env bash
+
+set -x
+
+./rbc_validator --mode=x25519 -rv -m2
+./rbc_validator --mode=x25519 -bv -m2
+
+[[ $(./rbc_validator --mode=x25519 -v -m2 \
+    000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f \
+    d6e778fad5b196d4d10750378d1d2d3484ab1ab32e2d37b3e9bcd9892d4d1c7c) == \
+  "100102030407060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f" ]]
+
+[[ $(./rbc_validator --mode=x25519 -rvca -m2 -t1 |& grep searched | cut -d' ' -f4) == 32897 ]]
+[[ $(./rbc_validator --mode=x25519 -rvcaf -m2 -t1 |& grep searched | cut -d' ' -f4) == 32640 ]]
+
+[[ $(./rbc_validator --mode=x25519 -rvca -m2 |& grep searched | cut -d' ' -f4) == 32897 ]]
+[[ $(./rbc_validator --mode=x25519 -rvcaf -m2 |& grep searched | cut -d' ' -f4) == 32640 ]]
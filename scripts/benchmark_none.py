@@ -0,0 +1,50 @@
+import re
+import subprocess
+import sys
+
+ITERATIONS = 5
+MAX_MISMATCHES = 4
+# Keep the search space small enough that the high mismatch runs stay in the order of seconds
+SUBKEY_SIZE = 128
+
+
+def do_run(executable: str, mismatches: int, threads: int) -> float:
+    # Only test the given mismatch through the entire search space so every run does the same
+    # amount of work, then pull the key rate out of the verbose output
+    validator_proc = subprocess.run([executable, "--mode=none", "-bvcaf", "-m", str(mismatches),
+                                     "-s", str(SUBKEY_SIZE), "-t", str(threads)],
+                                    stdout=subprocess.DEVNULL, stderr=subprocess.PIPE,
+                                    universal_newlines=True, check=True)
+
+    # Get the first line such that "Keys per second" is contained within it.
+    line = next(line for line in validator_proc.stderr.split('\n')
+                if re.search(r'Keys per second', line))
+
+    return float(line.split(' ')[4])
+
+
+if __name__ == "__main__":
+    # Pass in one or more rbc_validator builds to compare, e.g. one configured with
+    # -D ALWAYS_GMP_ITER=ON and one without
+    if len(sys.argv) < 2:
+        print("Usage: {} RBC_VALIDATOR... [THREADS]".format(sys.argv[0]), file=sys.stderr)
+        sys.exit(1)
+
+    executables = sys.argv[1:]
+    thread_count = 1
+
+    if len(executables) > 1 and executables[-1].isdigit():
+        thread_count = int(executables.pop())
+
+    print("Mismatches," + ",".join(executables))
+
+    for mismatches in range(1, MAX_MISMATCHES + 1):
+        print(mismatches, end="", flush=True)
+
+        for executable in executables:
+            # Print out the average key rate out of ITERATION number of runs
+            total = sum(do_run(executable, mismatches, thread_count) for _ in range(ITERATIONS))
+
+            print(",{:.0f}".format(total / ITERATIONS), end="", flush=True)
+
+        print(flush=True)
@@ -7,8 +7,17 @@
 #include <string.h>
 
 #include "crypto/aes256-ni_enc.h"
+#include "test_util.h"
 #include "util.h"
 
+#define AES256_MULTI_KEY_COUNT MULTI_KEY_COUNT(AES256_VAES_LANES, AES256_ECB_LANES)
+
+/// Encrypt a single block with aes256EcbEncrypt, the scalar path to check aes256EcbEncryptKeys
+/// against.
+static int aes256Ref(unsigned char* output, const unsigned char* key, void* args) {
+    return aes256EcbEncrypt(output, key, args, AES_BLOCK_SIZE) != 0;
+}
+
 int main() {
     const unsigned char key[] = {
             0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a,
@@ -23,7 +32,9 @@ int main() {
     };
 
     unsigned char cipher[AES_BLOCK_SIZE];
-    int status;
+    unsigned char keys[AES256_MULTI_KEY_COUNT * AES256_KEY_SIZE];
+    unsigned char ciphers[AES256_MULTI_KEY_COUNT * AES_BLOCK_SIZE];
+    int status, multi_status;
 
     if (aes256EcbEncrypt(cipher, key, (const unsigned char*)msg, strlen(msg))) {
         fprintf(stderr, "ERROR: evpEncrypt failed\n");
@@ -45,5 +56,27 @@ int main() {
     fprintHex(stdout, expected_cipher, sizeof(expected_cipher));
     printf("\n");
 
+    corruptKeys(keys, key, AES256_KEY_SIZE, AES256_MULTI_KEY_COUNT, AES256_KEY_SIZE);
+    aes256EcbEncryptKeys(ciphers, keys, AES256_MULTI_KEY_COUNT, (const unsigned char*)msg);
+
+    printf("Multi-Key Encryption (%s): Test ", aes256HasVaes() ? "VAES" : "AES-NI");
+    // The first key is the original, so its cipher is known ahead of time
+    multi_status = memcmp(ciphers, expected_cipher, AES_BLOCK_SIZE) != 0;
+    if (!multi_status) {
+        multi_status = checkKeys(ciphers, AES_BLOCK_SIZE, keys, AES256_KEY_SIZE,
+                                 AES256_MULTI_KEY_COUNT, aes256Ref, (void*)msg);
+    }
+
+    if (multi_status < 0) {
+        return EXIT_FAILURE;
+    }
+
+    if (multi_status) {
+        printf("Failed\n");
+        status = EXIT_FAILURE;
+    } else {
+        printf("Passed\n");
+    }
+
     return status;
 }
\ No newline at end of file
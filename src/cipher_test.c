@@ -4,14 +4,19 @@
 
 #include "crypto/cipher.h"
 
+#include <stdint.h>
+
 #include <memory.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "crypto/chacha20.h"
+#include "test_util.h"
 #include "util.h"
 
 #define TEST_SIZE 2
 #define MAX_CIPHER_SIZE 16
+#define CHACHA20_MULTI_KEY_COUNT MULTI_KEY_COUNT(CHACHA20_AVX512_LANES, CHACHA20_AVX2_LANES)
 
 int genericTest(const char* name, const EVP_CIPHER* evp_cipher, const unsigned char* key,
                 const unsigned char* msg, const unsigned char* expected_cipher, size_t msg_len,
@@ -49,6 +54,56 @@ int genericTest(const char* name, const EVP_CIPHER* evp_cipher, const unsigned c
     return status;
 }
 
+/// Get a key's first keystream block through EVP, the reference to check chacha20KeystreamKeys
+/// against.
+/// \param args The IV.
+static int chacha20Ref(unsigned char* output, const unsigned char* key, void* args) {
+    const unsigned char zeros[CHACHA20_BLOCK_SIZE] = {0};
+
+    // Encrypting zeros gives back the keystream itself
+    return evpEncrypt(output, NULL, EVP_chacha20(), key, zeros, sizeof(zeros), args) != 0;
+}
+
+/// Compare every keystream word chacha20KeystreamKeys produces against EVP's keystream for a set of
+/// different keys.
+/// \return Returns 0 if they all match, 1 if not.
+int chacha20MultiKeyTest(const unsigned char* key, const unsigned char* iv) {
+    unsigned char keys[CHACHA20_MULTI_KEY_COUNT * CHACHA20_KEY_SIZE];
+    uint32_t soa_keys[CHACHA20_MULTI_KEY_COUNT * CHACHA20_KEY_SIZE / sizeof(uint32_t)];
+    uint32_t keystreams[CHACHA20_MULTI_KEY_COUNT * CHACHA20_BLOCK_WORDS];
+    unsigned char aos_keystreams[CHACHA20_MULTI_KEY_COUNT * CHACHA20_BLOCK_SIZE];
+    int status;
+
+    corruptKeys(keys, key, CHACHA20_KEY_SIZE, CHACHA20_MULTI_KEY_COUNT, CHACHA20_KEY_SIZE);
+
+    // The kernel takes its keys transposed into 32-bit words
+    for (size_t i = 0; i < CHACHA20_MULTI_KEY_COUNT; i++) {
+        for (size_t w = 0; w < CHACHA20_KEY_SIZE / sizeof(uint32_t); w++) {
+            memcpy(&soa_keys[w * CHACHA20_MULTI_KEY_COUNT + i],
+                   keys + i * CHACHA20_KEY_SIZE + w * sizeof(uint32_t), sizeof(uint32_t));
+        }
+    }
+
+    chacha20KeystreamKeys(keystreams, CHACHA20_BLOCK_WORDS, soa_keys, CHACHA20_MULTI_KEY_COUNT, iv);
+
+    // And gives back its keystreams the same way, so transpose them back into one block per key
+    for (size_t i = 0; i < CHACHA20_MULTI_KEY_COUNT; i++) {
+        for (size_t w = 0; w < CHACHA20_BLOCK_WORDS; w++) {
+            memcpy(aos_keystreams + i * CHACHA20_BLOCK_SIZE + w * sizeof(uint32_t),
+                   &keystreams[w * CHACHA20_MULTI_KEY_COUNT + i], sizeof(uint32_t));
+        }
+    }
+
+    if ((status = checkKeys(aos_keystreams, CHACHA20_BLOCK_SIZE, keys, CHACHA20_KEY_SIZE,
+                            CHACHA20_MULTI_KEY_COUNT, chacha20Ref, (void*)iv)) < 0) {
+        return 1;
+    }
+
+    printf("ChaCha20 Multi-Key Keystream: Test %s\n", status ? "Failed" : "Passed");
+
+    return status;
+}
+
 int main() {
     const unsigned char key[] = {
             0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a,
@@ -92,5 +147,8 @@ int main() {
         }
     }
 
+    printf("\n");
+    status |= chacha20MultiKeyTest(key, chacha20_iv);
+
     return status ? EXIT_FAILURE : EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -25,9 +25,9 @@
 
 #include "cmdline_omp.h"
 
-const char *gengetopt_args_info_purpose = "\nGiven an HOST_SEED and either:\n1) an AES256 CLIENT_CIPHER and plaintext UUID;\n2) a ChaCha20 CLIENT_CIPHER, plaintext UUID, and IV;\n3) an ECC Secp256r1 CLIENT_PUB_KEY;\n4) a MD5, SHA1, SHA2-224, SHA2-256, SHA2-384, SHA2-512, SHA3-224, SHA3-256,\nSHA3-384, SHA3-512, SHAKE128, SHAKE256, or KangarooTwelve CLIENT_DIGEST;\nwhere CLIENT_* is from an unreliable source. Progressively corrupt the chosen\ncryptographic function by a certain number of bits until a matching client seed\nis found. The matching HOST_* will be sent to stdout, depending on the\ncryptographic function.\n\nThis implementation uses OpenMP.";
+const char *gengetopt_args_info_purpose = "\nGiven an HOST_SEED and either:\n1) an AES256 CLIENT_CIPHER and plaintext UUID;\n2) a ChaCha20 CLIENT_CIPHER, plaintext UUID, and IV;\n3) an ECC Secp256r1 or Secp256k1 CLIENT_PUB_KEY;\n4) an X25519 CLIENT_PUB_KEY;\n5) a MD5, SHA1, SHA2-224, SHA2-256, SHA2-384, SHA2-512, SHA3-224, SHA3-256,\nSHA3-384, SHA3-512, SHAKE128, SHAKE256, or KangarooTwelve CLIENT_DIGEST;\nwhere CLIENT_* is from an unreliable source. Progressively corrupt the chosen\ncryptographic function by a certain number of bits until a matching client seed\nis found. The matching HOST_* will be sent to stdout, depending on the\ncryptographic function.\n\nThis implementation uses OpenMP.";
 
-const char *gengetopt_args_info_usage = "Usage: rbc_validator [OPTIONS...] --mode=none HOST_SEED\n  or : rbc_validator [OPTIONS...] --mode=[aes,chacha20] HOST_SEED CLIENT_CIPHER\nUUID [IV]\n  or : rbc_validator [OPTIONS...] --mode=ecc HOST_SEED CLIENT_PUB_KEY\n  or : rbc_validator [OPTIONS...]\n--mode=[md5,sha1,sha224,sha256,sha384,sha512,sha3-224,sha3-256,sha3-384,sha3-512,shake128,shake256,kang12]\nHOST_SEED CLIENT_DIGEST [SALT]\n  or : rbc_validator [OPTIONS...] --mode=* -r/--random -m/--mismatches=value\n  or : rbc_validator [OPTIONS...] --mode=* -b/--benchmark -m/--mismatches=value\nTry `rbc_validator_mpi --help' for more information.";
+const char *gengetopt_args_info_usage = "Usage: rbc_validator [OPTIONS...] --mode=none HOST_SEED\n  or : rbc_validator [OPTIONS...] --mode=[aes,chacha20] HOST_SEED CLIENT_CIPHER\nUUID [IV]\n  or : rbc_validator [OPTIONS...] --mode=[ecc,secp256k1] HOST_SEED\nCLIENT_PUB_KEY\n  or : rbc_validator [OPTIONS...] --mode=x25519 HOST_SEED CLIENT_PUB_KEY\n  or : rbc_validator [OPTIONS...]\n--mode=[md5,sha1,sha224,sha256,sha384,sha512,sha3-224,sha3-256,sha3-384,sha3-512,shake128,shake256,kang12]\nHOST_SEED CLIENT_DIGEST [SALT]\n  or : rbc_validator [OPTIONS...] --mode=* -r/--random -m/--mismatches=value\n  or : rbc_validator [OPTIONS...] --mode=* -b/--benchmark -m/--mismatches=value\nTry `rbc_validator_mpi --help' for more information.";
 
 const char *gengetopt_args_info_versiontext = "Christopher Robert Philabaum <cp723@nau.edu>";
 
@@ -37,7 +37,7 @@ const char *gengetopt_args_info_help[] = {
   "  -h, --help              Print help and exit",
   "  -V, --version           Print version and exit",
   "      --usage             Give a short usage message",
-  "      --mode=ENUM         (REQUIRED) The cryptographic function to iterate\n                            against. If `none', then only perform\n                            seed iteration.  (possible values=\"none\",\n                            \"aes\", \"chacha20\", \"ecc\", \"md5\", \"sha1\",\n                            \"sha224\", \"sha256\", \"sha384\", \"sha512\",\n                            \"sha3-224\", \"sha3-256\", \"sha3-384\",\n                            \"sha3-512\", \"shake128\", \"shake256\",\n                            \"kang12\")",
+  "      --mode=ENUM         (REQUIRED) The cryptographic function to iterate\n                            against. If `none', then only perform\n                            seed iteration.  (possible values=\"none\",\n                            \"aes\", \"chacha20\", \"ecc\", \"secp256k1\",\n                            \"x25519\", \"md5\", \"sha1\", \"sha224\",\n                            \"sha256\", \"sha384\", \"sha512\", \"sha3-224\",\n                            \"sha3-256\", \"sha3-384\", \"sha3-512\",\n                            \"shake128\", \"shake256\", \"kang12\")",
   "  -m, --mismatches=value  The largest # of bits of corruption to test against,\n                            inclusively. Defaults to -1. If negative, then the\n                            size of key in bits will be the limit. If in random\n                            or benchmark mode, then this will also be used to\n                            corrupt the random key by the same # of bits; for\n                            this reason, it must be set and non-negative when\n                            in random or benchmark mode. Cannot be larger than\n                            what --subkey-size is set to.  (default=`-1')",
   "  -s, --subkey=value      How many of the first bits to corrupt and iterate\n                            over. Must be between 1 and 256. Defaults to 256.\n                            (default=`256')",
   "\n Mode: Random",
@@ -49,6 +49,7 @@ const char *gengetopt_args_info_help[] = {
   "  -f, --fixed             Only test the given mismatch, instead of progressing\n                            from 0 to --mismatches. This is only valid when\n                            --mismatches is set and non-negative.\n                            (default=off)",
   "  -v, --verbose           Produces verbose output and time taken to stderr.\n                            (default=off)",
   "  -t, --threads=count     How many worker threads to use. Defaults to 0. If set\n                            to 0, then the number of threads used will be\n                            detected by the system.  (default=`0')",
+  "      --ecc-memory=MiB    How many MiB the meet-in-the-middle table for\n                            --mode=[ecc,secp256k1] can take up, for each\n                            hamming distance of at least 2. If the table for a\n                            hamming distance doesn't fit, then every seed at\n                            that distance is checked instead. Defaults to 1024.\n                            If set to 0, then always check every seed.\n                            (default=`1024')",
     0
 };
 
@@ -68,7 +69,7 @@ cmdline_parser_internal (int argc, char **argv, struct gengetopt_args_info *args
                         struct cmdline_parser_params *params, const char *additional_error);
 
 
-const char *cmdline_parser_mode_values[] = {"none", "aes", "chacha20", "ecc", "md5", "sha1", "sha224", "sha256", "sha384", "sha512", "sha3-224", "sha3-256", "sha3-384", "sha3-512", "shake128", "shake256", "kang12", 0}; /*< Possible values for mode. */
+const char *cmdline_parser_mode_values[] = {"none", "aes", "chacha20", "ecc", "secp256k1", "x25519", "md5", "sha1", "sha224", "sha256", "sha384", "sha512", "sha3-224", "sha3-256", "sha3-384", "sha3-512", "shake128", "shake256", "kang12", 0}; /*< Possible values for mode. */
 
 static char *
 gengetopt_strdup (const char *s);
@@ -89,6 +90,7 @@ void clear_given (struct gengetopt_args_info *args_info)
   args_info->fixed_given = 0 ;
   args_info->verbose_given = 0 ;
   args_info->threads_given = 0 ;
+  args_info->ecc_memory_given = 0 ;
   args_info->Benchmark_mode_counter = 0 ;
   args_info->Random_mode_counter = 0 ;
 }
@@ -111,6 +113,8 @@ void clear_args (struct gengetopt_args_info *args_info)
   args_info->verbose_flag = 0;
   args_info->threads_arg = 0;
   args_info->threads_orig = NULL;
+  args_info->ecc_memory_arg = 1024;
+  args_info->ecc_memory_orig = NULL;
   
 }
 
@@ -132,6 +136,7 @@ void init_args_info(struct gengetopt_args_info *args_info)
   args_info->fixed_help = gengetopt_args_info_help[12] ;
   args_info->verbose_help = gengetopt_args_info_help[13] ;
   args_info->threads_help = gengetopt_args_info_help[14] ;
+  args_info->ecc_memory_help = gengetopt_args_info_help[15] ;
   
 }
 
@@ -228,6 +233,7 @@ cmdline_parser_release (struct gengetopt_args_info *args_info)
   free_string_field (&(args_info->mismatches_orig));
   free_string_field (&(args_info->subkey_orig));
   free_string_field (&(args_info->threads_orig));
+  free_string_field (&(args_info->ecc_memory_orig));
   
   
   for (i = 0; i < args_info->inputs_num; ++i)
@@ -330,6 +336,8 @@ cmdline_parser_dump(FILE *outfile, struct gengetopt_args_info *args_info)
     write_into_file(outfile, "verbose", 0, 0 );
   if (args_info->threads_given)
     write_into_file(outfile, "threads", args_info->threads_orig, 0);
+  if (args_info->ecc_memory_given)
+    write_into_file(outfile, "ecc-memory", args_info->ecc_memory_orig, 0);
   
 
   i = EXIT_SUCCESS;
@@ -619,6 +627,7 @@ cmdline_parser_internal (
         { "fixed",	0, NULL, 'f' },
         { "verbose",	0, NULL, 'v' },
         { "threads",	1, NULL, 't' },
+        { "ecc-memory",	1, NULL, 0 },
         { 0,  0, 0, 0 }
       };
 
@@ -766,6 +775,20 @@ cmdline_parser_internal (
                 additional_error))
               goto failure;
           
+          }
+          /* How many MiB the meet-in-the-middle table for --mode=[ecc,secp256k1] can take up, for each hamming distance of at least 2. If the table for a hamming distance doesn't fit, then every seed at that distance is checked instead. Defaults to 1024. If set to 0, then always check every seed..  */
+          else if (strcmp (long_options[option_index].name, "ecc-memory") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->ecc_memory_arg), 
+                 &(args_info->ecc_memory_orig), &(args_info->ecc_memory_given),
+                &(local_args_info.ecc_memory_given), optarg, 0, "1024", ARG_INT,
+                check_ambiguity, override, 0, 0,
+                "ecc-memory", '-',
+                additional_error))
+              goto failure;
+          
           }
           
           break;
@@ -34,7 +34,7 @@ extern "C" {
 #define CMDLINE_PARSER_VERSION "1.0.0"
 #endif
 
-enum enum_mode { mode__NULL = -1, mode_arg_none = 0, mode_arg_aes, mode_arg_chacha20, mode_arg_ecc, mode_arg_md5, mode_arg_sha1, mode_arg_sha224, mode_arg_sha256, mode_arg_sha384, mode_arg_sha512, mode_arg_sha3MINUS_224, mode_arg_sha3MINUS_256, mode_arg_sha3MINUS_384, mode_arg_sha3MINUS_512, mode_arg_shake128, mode_arg_shake256, mode_arg_kang12 };
+enum enum_mode { mode__NULL = -1, mode_arg_none = 0, mode_arg_aes, mode_arg_chacha20, mode_arg_ecc, mode_arg_secp256k1, mode_arg_x25519, mode_arg_md5, mode_arg_sha1, mode_arg_sha224, mode_arg_sha256, mode_arg_sha384, mode_arg_sha512, mode_arg_sha3MINUS_224, mode_arg_sha3MINUS_256, mode_arg_sha3MINUS_384, mode_arg_sha3MINUS_512, mode_arg_shake128, mode_arg_shake256, mode_arg_kang12 };
 
 /** @brief Where the command line options are stored */
 struct gengetopt_args_info
@@ -69,6 +69,9 @@ struct gengetopt_args_info
   int threads_arg;	/**< @brief How many worker threads to use. Defaults to 0. If set to 0, then the number of threads used will be detected by the system. (default='0').  */
   char * threads_orig;	/**< @brief How many worker threads to use. Defaults to 0. If set to 0, then the number of threads used will be detected by the system. original value given at command line.  */
   const char *threads_help; /**< @brief How many worker threads to use. Defaults to 0. If set to 0, then the number of threads used will be detected by the system. help description.  */
+  int ecc_memory_arg;	/**< @brief How many MiB the meet-in-the-middle table for --mode=[ecc,secp256k1] can take up, for each hamming distance of at least 2. If the table for a hamming distance doesn't fit, then every seed at that distance is checked instead. Defaults to 1024. If set to 0, then always check every seed. (default='1024').  */
+  char * ecc_memory_orig;	/**< @brief How many MiB the meet-in-the-middle table for --mode=[ecc,secp256k1] can take up, for each hamming distance of at least 2. If the table for a hamming distance doesn't fit, then every seed at that distance is checked instead. Defaults to 1024. If set to 0, then always check every seed. original value given at command line.  */
+  const char *ecc_memory_help; /**< @brief How many MiB the meet-in-the-middle table for --mode=[ecc,secp256k1] can take up, for each hamming distance of at least 2. If the table for a hamming distance doesn't fit, then every seed at that distance is checked instead. Defaults to 1024. If set to 0, then always check every seed. help description.  */
   
   unsigned int help_given ;	/**< @brief Whether help was given.  */
   unsigned int version_given ;	/**< @brief Whether version was given.  */
@@ -83,6 +86,7 @@ struct gengetopt_args_info
   unsigned int fixed_given ;	/**< @brief Whether fixed was given.  */
   unsigned int verbose_given ;	/**< @brief Whether verbose was given.  */
   unsigned int threads_given ;	/**< @brief Whether threads was given.  */
+  unsigned int ecc_memory_given ;	/**< @brief Whether ecc-memory was given.  */
 
   char **inputs ; /**< @brief unnamed options (options without names) */
   unsigned inputs_num ; /**< @brief unnamed options number */
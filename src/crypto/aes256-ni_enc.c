@@ -10,6 +10,14 @@
 
 #include <wmmintrin.h>
 
+#include "cpu_features.h"
+
+#ifdef RBC_HAVE_AVX512_TARGET
+#include <immintrin.h>
+
+#define AES256_VAES_TARGET __attribute__((target("avx512f,avx512bw,vaes")))
+#endif
+
 // How many rounds do for AES-256 encryption/decryption
 #define NUM_OF_ROUNDS 14
 
@@ -107,7 +115,7 @@ int aes256EcbEncrypt(unsigned char* cipher, const unsigned char* key, const unsi
     __m128i tmp;
     size_t block_count = msg_len / AES_BLOCK_SIZE;
 
-    __m128i scheduler[sizeof(__m128i) * (NUM_OF_ROUNDS + 1)];
+    __m128i scheduler[NUM_OF_ROUNDS + 1];
 
     if (msg_len % AES_BLOCK_SIZE) {
         return 1;
@@ -129,3 +137,152 @@ int aes256EcbEncrypt(unsigned char* cipher, const unsigned char* key, const unsi
 
     return 0;
 }
+
+// The aeskeygenassist equivalents for the multi-key kernel. aeskeygenassist has a far lower
+// throughput than aesenclast, and with the last column of the key broadcast to every column,
+// ShiftRows has no effect and aesenclast with a zero round key is just SubWord on each column.
+static inline __m128i subWordBroadcast(__m128i tmp) {
+    return _mm_aesenclast_si128(_mm_shuffle_epi32(tmp, 0xff), _mm_setzero_si128());
+}
+
+static inline __m128i rotSubWordBroadcast(__m128i tmp, int rcon) {
+    tmp = subWordBroadcast(tmp);
+    // RotWord on a little-endian column is a rotate right by 8 bits
+    tmp = _mm_or_si128(_mm_srli_epi32(tmp, 8), _mm_slli_epi32(tmp, 24));
+
+    return _mm_xor_si128(tmp, _mm_set1_epi32(rcon));
+}
+
+// Fold the previous round key into the broadcast word, as in key256Assist1 and key256Assist2
+static inline __m128i keyFold(__m128i key, __m128i word) {
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 0x4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 0x8));
+
+    return _mm_xor_si128(key, word);
+}
+
+/// Encrypt one block under a fixed number of keys at once, expanding each key schedule round by
+/// round alongside the encryption instead of storing it. Interleaving the lanes keeps several
+/// independent AES instructions in flight to hide their latency.
+static inline __attribute__((always_inline)) void aes256EcbEncryptLanes(
+        unsigned char* ciphers, const unsigned char* keys, __m128i block, size_t lanes) {
+    __m128i even_key[AES256_ECB_LANES], odd_key[AES256_ECB_LANES], state[AES256_ECB_LANES];
+    int rcon = 0x01;
+
+    for (size_t l = 0; l < lanes; ++l) {
+        even_key[l] = _mm_loadu_si128((const __m128i*)(keys + l * AES256_KEY_SIZE));
+        odd_key[l] = _mm_loadu_si128((const __m128i*)(keys + l * AES256_KEY_SIZE + 16));
+
+        state[l] = _mm_xor_si128(block, even_key[l]);
+        state[l] = _mm_aesenc_si128(state[l], odd_key[l]);
+    }
+
+    // Round keys 2 through 13 come in pairs
+    for (int round = 2; round < NUM_OF_ROUNDS; round += 2, rcon <<= 1) {
+        for (size_t l = 0; l < lanes; ++l) {
+            even_key[l] = keyFold(even_key[l], rotSubWordBroadcast(odd_key[l], rcon));
+            state[l] = _mm_aesenc_si128(state[l], even_key[l]);
+        }
+
+        for (size_t l = 0; l < lanes; ++l) {
+            odd_key[l] = keyFold(odd_key[l], subWordBroadcast(even_key[l]));
+            state[l] = _mm_aesenc_si128(state[l], odd_key[l]);
+        }
+    }
+
+    for (size_t l = 0; l < lanes; ++l) {
+        even_key[l] = keyFold(even_key[l], rotSubWordBroadcast(odd_key[l], rcon));
+        state[l] = _mm_aesenclast_si128(state[l], even_key[l]);
+
+        _mm_storeu_si128((__m128i*)(ciphers + l * AES_BLOCK_SIZE), state[l]);
+    }
+}
+
+#ifdef RBC_HAVE_AVX512_TARGET
+// The 512-bit counterparts of the helpers above, with each 128-bit lane a different key
+static inline AES256_VAES_TARGET __m512i subWordBroadcastVaes(__m512i tmp) {
+    return _mm512_aesenclast_epi128(_mm512_shuffle_epi32(tmp, _MM_PERM_DDDD),
+                                    _mm512_setzero_si512());
+}
+
+static inline AES256_VAES_TARGET __m512i rotSubWordBroadcastVaes(__m512i tmp, int rcon) {
+    tmp = _mm512_ror_epi32(subWordBroadcastVaes(tmp), 8);
+
+    return _mm512_xor_si512(tmp, _mm512_set1_epi32(rcon));
+}
+
+static inline AES256_VAES_TARGET __m512i keyFoldVaes(__m512i key, __m512i word) {
+    key = _mm512_xor_si512(key, _mm512_bslli_epi128(key, 0x4));
+    key = _mm512_xor_si512(key, _mm512_bslli_epi128(key, 0x8));
+
+    return _mm512_xor_si512(key, word);
+}
+
+/// The same as aes256EcbEncryptLanes, but over AES256_VAES_LANES keys held four to a register.
+static AES256_VAES_TARGET void aes256EcbEncryptVaes(unsigned char* ciphers,
+                                                    const unsigned char* keys, __m128i block) {
+    __m512i even_key[AES256_VAES_LANES / 4], odd_key[AES256_VAES_LANES / 4];
+    __m512i state[AES256_VAES_LANES / 4];
+    __m512i blocks = _mm512_broadcast_i32x4(block);
+    int rcon = 0x01;
+
+    for (size_t r = 0; r < AES256_VAES_LANES / 4; ++r) {
+        // Each load holds two whole keys, so gather their low and high halves from a pair of them
+        __m512i lo_pair = _mm512_loadu_si512(keys + r * 4 * AES256_KEY_SIZE);
+        __m512i hi_pair = _mm512_loadu_si512(keys + (r * 4 + 2) * AES256_KEY_SIZE);
+
+        even_key[r] = _mm512_shuffle_i64x2(lo_pair, hi_pair, _MM_SHUFFLE(2, 0, 2, 0));
+        odd_key[r] = _mm512_shuffle_i64x2(lo_pair, hi_pair, _MM_SHUFFLE(3, 1, 3, 1));
+
+        state[r] = _mm512_xor_si512(blocks, even_key[r]);
+        state[r] = _mm512_aesenc_epi128(state[r], odd_key[r]);
+    }
+
+    for (int round = 2; round < NUM_OF_ROUNDS; round += 2, rcon <<= 1) {
+        for (size_t r = 0; r < AES256_VAES_LANES / 4; ++r) {
+            even_key[r] = keyFoldVaes(even_key[r], rotSubWordBroadcastVaes(odd_key[r], rcon));
+            state[r] = _mm512_aesenc_epi128(state[r], even_key[r]);
+        }
+
+        for (size_t r = 0; r < AES256_VAES_LANES / 4; ++r) {
+            odd_key[r] = keyFoldVaes(odd_key[r], subWordBroadcastVaes(even_key[r]));
+            state[r] = _mm512_aesenc_epi128(state[r], odd_key[r]);
+        }
+    }
+
+    for (size_t r = 0; r < AES256_VAES_LANES / 4; ++r) {
+        even_key[r] = keyFoldVaes(even_key[r], rotSubWordBroadcastVaes(odd_key[r], rcon));
+        state[r] = _mm512_aesenclast_epi128(state[r], even_key[r]);
+
+        _mm512_storeu_si512(ciphers + r * 4 * AES_BLOCK_SIZE, state[r]);
+    }
+}
+#endif
+
+int aes256HasVaes(void) {
+    return cpuFeatures()->vaes;
+}
+
+void aes256EcbEncryptKeys(unsigned char* ciphers, const unsigned char* keys, size_t key_count,
+                          const unsigned char* msg) {
+    __m128i block = _mm_loadu_si128((const __m128i*)msg);
+    size_t i = 0;
+
+#ifdef RBC_HAVE_AVX512_TARGET
+    if (key_count >= AES256_VAES_LANES && cpuFeatures()->vaes) {
+        for (; i + AES256_VAES_LANES <= key_count; i += AES256_VAES_LANES) {
+            aes256EcbEncryptVaes(ciphers + i * AES_BLOCK_SIZE, keys + i * AES256_KEY_SIZE, block);
+        }
+    }
+#endif
+
+    for (; i + AES256_ECB_LANES <= key_count; i += AES256_ECB_LANES) {
+        aes256EcbEncryptLanes(ciphers + i * AES_BLOCK_SIZE, keys + i * AES256_KEY_SIZE, block,
+                              AES256_ECB_LANES);
+    }
+
+    // Finish off any remaining keys one at a time
+    for (; i < key_count; ++i) {
+        aes256EcbEncryptLanes(ciphers + i * AES_BLOCK_SIZE, keys + i * AES256_KEY_SIZE, block, 1);
+    }
+}
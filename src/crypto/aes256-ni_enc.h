@@ -9,6 +9,10 @@
 
 #define AES_BLOCK_SIZE 16
 #define AES256_KEY_SIZE 32
+// How many keys aes256EcbEncryptKeys interleaves at once
+#define AES256_ECB_LANES 8
+// How many keys aes256EcbEncryptKeys interleaves at once when it can use VAES
+#define AES256_VAES_LANES 16
 
 /// Encrypts some message data using AES-256-ECB without padding
 /// \param cipher The output encryption
@@ -20,4 +24,18 @@
 int aes256EcbEncrypt(unsigned char* cipher, const unsigned char* key, const unsigned char* msg,
                      size_t msg_len);
 
+/// Check whether the CPU supports the VAES kernel, which needs AVX-512F, AVX-512BW, and VAES.
+/// \return Returns 1 if so, or 0 otherwise.
+int aes256HasVaes(void);
+
+/// Encrypts a single block of message data under several keys using AES-256-ECB, interleaving the
+/// key expansion and rounds of AES256_VAES_LANES keys at a time if aes256HasVaes, or
+/// AES256_ECB_LANES keys at a time otherwise.
+/// \param ciphers The output encryptions, AES_BLOCK_SIZE bytes for each key in order.
+/// \param keys key_count keys of AES256_KEY_SIZE bytes each, back to back.
+/// \param key_count How many keys to encrypt with.
+/// \param msg The AES_BLOCK_SIZE byte block to encrypt.
+void aes256EcbEncryptKeys(unsigned char* ciphers, const unsigned char* keys, size_t key_count,
+                          const unsigned char* msg);
+
 #endif  // RBC_VALIDATOR_CRYPTO_AES256_NI_ENC_H_
@@ -0,0 +1,227 @@
+// A ChaCha20 keystream generator for many keys at once, following RFC 8439 with OpenSSL's
+// IV layout.
+
+#include "chacha20.h"
+
+#include "cpu_features.h"
+
+#ifdef RBC_HAVE_AVX512_TARGET
+#include <immintrin.h>
+
+#define CHACHA20_AVX2_TARGET   __attribute__((target("avx2")))
+#define CHACHA20_AVX512_TARGET __attribute__((target("avx512f")))
+#endif
+
+#define NUM_OF_DOUBLE_ROUNDS 10
+
+// "expand 32-byte k"
+static const uint32_t sigma[4] = {0x61707865, 0x3320646e, 0x79622d32, 0x6b206574};
+
+// Run the column round on a state of 16 words with the given quarter round
+#define CHACHA20_COLUMN_ROUND(QUARTER_ROUND, x)  \
+    do {                                         \
+        QUARTER_ROUND(x[0], x[4], x[8], x[12]);  \
+        QUARTER_ROUND(x[1], x[5], x[9], x[13]);  \
+        QUARTER_ROUND(x[2], x[6], x[10], x[14]); \
+        QUARTER_ROUND(x[3], x[7], x[11], x[15]); \
+    } while (0)
+
+// The same, but for the diagonal round
+#define CHACHA20_DIAGONAL_ROUND(QUARTER_ROUND, x) \
+    do {                                          \
+        QUARTER_ROUND(x[0], x[5], x[10], x[15]);  \
+        QUARTER_ROUND(x[1], x[6], x[11], x[12]);  \
+        QUARTER_ROUND(x[2], x[7], x[8], x[13]);   \
+        QUARTER_ROUND(x[3], x[4], x[9], x[14]);   \
+    } while (0)
+
+// Run both the column and diagonal rounds
+#define CHACHA20_DOUBLE_ROUND(QUARTER_ROUND, x)    \
+    do {                                           \
+        CHACHA20_COLUMN_ROUND(QUARTER_ROUND, x);   \
+        CHACHA20_DIAGONAL_ROUND(QUARTER_ROUND, x); \
+    } while (0)
+
+#define ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+
+#define QUARTER_ROUND(a, b, c, d) \
+    do {                          \
+        a += b;                   \
+        d = ROTL32(d ^ a, 16);    \
+        c += d;                   \
+        b = ROTL32(b ^ c, 12);    \
+        a += b;                   \
+        d = ROTL32(d ^ a, 8);     \
+        c += d;                   \
+        b = ROTL32(b ^ c, 7);     \
+    } while (0)
+
+static inline uint32_t loadLe32(const unsigned char* bytes) {
+    return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 |
+           (uint32_t)bytes[3] << 24;
+}
+
+/// The plain C fallback, for a single key.
+static void chacha20KeystreamLane(uint32_t* keystreams, size_t word_count, const uint32_t* keys,
+                                  size_t key_count, size_t lane, const uint32_t* iv_words) {
+    uint32_t input[CHACHA20_BLOCK_WORDS], x[CHACHA20_BLOCK_WORDS];
+
+    for (size_t i = 0; i < 4; ++i) {
+        input[i] = sigma[i];
+        input[12 + i] = iv_words[i];
+    }
+
+    for (size_t i = 0; i < CHACHA20_KEY_SIZE / sizeof(uint32_t); ++i) {
+        input[4 + i] = keys[i * key_count + lane];
+    }
+
+    for (size_t i = 0; i < CHACHA20_BLOCK_WORDS; ++i) {
+        x[i] = input[i];
+    }
+
+    CHACHA20_COLUMN_ROUND(QUARTER_ROUND, x);
+
+    CHACHA20_DIAGONAL_ROUND(QUARTER_ROUND, x);
+
+    for (int round = 1; round < NUM_OF_DOUBLE_ROUNDS; ++round) {
+        CHACHA20_DOUBLE_ROUND(QUARTER_ROUND, x);
+    }
+
+    for (size_t i = 0; i < word_count; ++i) {
+        keystreams[i * key_count + lane] = x[i] + input[i];
+    }
+}
+
+#ifdef RBC_HAVE_AVX512_TARGET
+// Rotations by a multiple of 8 bits are cheaper as byte shuffles
+#define ROTL32_AVX2(v, n) _mm256_or_si256(_mm256_slli_epi32(v, n), _mm256_srli_epi32(v, 32 - (n)))
+
+#define QUARTER_ROUND_AVX2(a, b, c, d)                                        \
+    do {                                                                      \
+        a = _mm256_add_epi32(a, b);                                           \
+        d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rot16);               \
+        c = _mm256_add_epi32(c, d);                                           \
+        b = _mm256_xor_si256(b, c);                                           \
+        b = ROTL32_AVX2(b, 12);                                               \
+        a = _mm256_add_epi32(a, b);                                           \
+        d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rot8);                \
+        c = _mm256_add_epi32(c, d);                                           \
+        b = _mm256_xor_si256(b, c);                                           \
+        b = ROTL32_AVX2(b, 7);                                                \
+    } while (0)
+
+/// The same as chacha20KeystreamLane, but over CHACHA20_AVX2_LANES keys starting from lane.
+static CHACHA20_AVX2_TARGET void chacha20KeystreamAvx2(uint32_t* keystreams, size_t word_count,
+                                                      const uint32_t* keys, size_t key_count,
+                                                      size_t lane, const uint32_t* iv_words) {
+    const __m256i rot16 = _mm256_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+                                          13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2);
+    const __m256i rot8 = _mm256_set_epi8(14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3,
+                                         14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3);
+    __m256i input[CHACHA20_BLOCK_WORDS], x[CHACHA20_BLOCK_WORDS];
+
+    for (size_t i = 0; i < 4; ++i) {
+        input[i] = _mm256_set1_epi32((int)sigma[i]);
+        input[12 + i] = _mm256_set1_epi32((int)iv_words[i]);
+    }
+
+    for (size_t i = 0; i < CHACHA20_KEY_SIZE / sizeof(uint32_t); ++i) {
+        input[4 + i] = _mm256_loadu_si256((const __m256i*)(keys + i * key_count + lane));
+    }
+
+    for (size_t i = 0; i < CHACHA20_BLOCK_WORDS; ++i) {
+        x[i] = input[i];
+    }
+
+    CHACHA20_COLUMN_ROUND(QUARTER_ROUND_AVX2, x);
+
+    CHACHA20_DIAGONAL_ROUND(QUARTER_ROUND_AVX2, x);
+
+    for (int round = 1; round < NUM_OF_DOUBLE_ROUNDS; ++round) {
+        CHACHA20_DOUBLE_ROUND(QUARTER_ROUND_AVX2, x);
+    }
+
+    for (size_t i = 0; i < word_count; ++i) {
+        _mm256_storeu_si256((__m256i*)(keystreams + i * key_count + lane),
+                            _mm256_add_epi32(x[i], input[i]));
+    }
+}
+
+#define QUARTER_ROUND_AVX512(a, b, c, d)                                    \
+    do {                                                                    \
+        a = _mm512_add_epi32(a, b);                                         \
+        d = _mm512_rol_epi32(_mm512_xor_si512(d, a), 16);                   \
+        c = _mm512_add_epi32(c, d);                                         \
+        b = _mm512_rol_epi32(_mm512_xor_si512(b, c), 12);                   \
+        a = _mm512_add_epi32(a, b);                                         \
+        d = _mm512_rol_epi32(_mm512_xor_si512(d, a), 8);                    \
+        c = _mm512_add_epi32(c, d);                                         \
+        b = _mm512_rol_epi32(_mm512_xor_si512(b, c), 7);                    \
+    } while (0)
+
+/// The same as chacha20KeystreamLane, but over CHACHA20_AVX512_LANES keys starting from lane.
+static CHACHA20_AVX512_TARGET void chacha20KeystreamAvx512(uint32_t* keystreams,
+                                                          size_t word_count, const uint32_t* keys,
+                                                          size_t key_count, size_t lane,
+                                                          const uint32_t* iv_words) {
+    __m512i input[CHACHA20_BLOCK_WORDS], x[CHACHA20_BLOCK_WORDS];
+
+    for (size_t i = 0; i < 4; ++i) {
+        input[i] = _mm512_set1_epi32((int)sigma[i]);
+        input[12 + i] = _mm512_set1_epi32((int)iv_words[i]);
+    }
+
+    for (size_t i = 0; i < CHACHA20_KEY_SIZE / sizeof(uint32_t); ++i) {
+        input[4 + i] = _mm512_loadu_si512(keys + i * key_count + lane);
+    }
+
+    for (size_t i = 0; i < CHACHA20_BLOCK_WORDS; ++i) {
+        x[i] = input[i];
+    }
+
+    CHACHA20_COLUMN_ROUND(QUARTER_ROUND_AVX512, x);
+
+    CHACHA20_DIAGONAL_ROUND(QUARTER_ROUND_AVX512, x);
+
+    for (int round = 1; round < NUM_OF_DOUBLE_ROUNDS; ++round) {
+        CHACHA20_DOUBLE_ROUND(QUARTER_ROUND_AVX512, x);
+    }
+
+    for (size_t i = 0; i < word_count; ++i) {
+        _mm512_storeu_si512(keystreams + i * key_count + lane, _mm512_add_epi32(x[i], input[i]));
+    }
+}
+#endif
+
+void chacha20KeystreamKeys(uint32_t* keystreams, size_t word_count, const uint32_t* keys,
+                           size_t key_count, const unsigned char* iv) {
+    uint32_t iv_words[4];
+    size_t lane = 0;
+
+    for (size_t i = 0; i < 4; ++i) {
+        iv_words[i] = loadLe32(iv + i * sizeof(uint32_t));
+    }
+
+    if (word_count > CHACHA20_BLOCK_WORDS) {
+        word_count = CHACHA20_BLOCK_WORDS;
+    }
+
+#ifdef RBC_HAVE_AVX512_TARGET
+    if (key_count >= CHACHA20_AVX512_LANES && cpuFeatures()->avx512f) {
+        for (; lane + CHACHA20_AVX512_LANES <= key_count; lane += CHACHA20_AVX512_LANES) {
+            chacha20KeystreamAvx512(keystreams, word_count, keys, key_count, lane, iv_words);
+        }
+    }
+
+    if (key_count - lane >= CHACHA20_AVX2_LANES && cpuFeatures()->avx2) {
+        for (; lane + CHACHA20_AVX2_LANES <= key_count; lane += CHACHA20_AVX2_LANES) {
+            chacha20KeystreamAvx2(keystreams, word_count, keys, key_count, lane, iv_words);
+        }
+    }
+#endif
+
+    // Finish off any remaining keys one at a time
+    for (; lane < key_count; ++lane) {
+        chacha20KeystreamLane(keystreams, word_count, keys, key_count, lane, iv_words);
+    }
+}
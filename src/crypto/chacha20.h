@@ -0,0 +1,29 @@
+#ifndef RBC_VALIDATOR_CRYPTO_CHACHA20_H_
+#define RBC_VALIDATOR_CRYPTO_CHACHA20_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CHACHA20_KEY_SIZE 32
+// The IV as OpenSSL takes it, a 32-bit little-endian block counter followed by a 96-bit nonce
+#define CHACHA20_IV_SIZE 16
+#define CHACHA20_BLOCK_SIZE 64
+#define CHACHA20_BLOCK_WORDS (CHACHA20_BLOCK_SIZE / sizeof(uint32_t))
+// How many keys each kernel works on at once
+#define CHACHA20_AVX2_LANES 8
+#define CHACHA20_AVX512_LANES 16
+
+/// Computes the beginning of the first ChaCha20 keystream block for several keys at once, using
+/// AVX-512 or AVX2 if the CPU supports it and plain C otherwise.
+/// \param keystreams The output keystream words, laid out such that word i of key j is at
+/// keystreams[i * key_count + j].
+/// \param word_count How many 32-bit words of the keystream block to output, up to
+/// CHACHA20_BLOCK_WORDS.
+/// \param keys key_count keys of CHACHA20_KEY_SIZE bytes, laid out the same as keystreams with
+/// each word in little-endian (SEED_LAYOUT_SOA32).
+/// \param key_count How many keys to use.
+/// \param iv The CHACHA20_IV_SIZE byte IV shared by every key.
+void chacha20KeystreamKeys(uint32_t* keystreams, size_t word_count, const uint32_t* keys,
+                           size_t key_count, const unsigned char* iv);
+
+#endif  // RBC_VALIDATOR_CRYPTO_CHACHA20_H_
@@ -0,0 +1,35 @@
+#include "cpu_features.h"
+
+#ifdef RBC_HAVE_SHA_NI_TARGET
+#include <cpuid.h>
+#include <stddef.h>
+#endif
+
+static CpuFeatures features;
+
+__attribute__((constructor)) static void cpuFeaturesDetect(void) {
+#ifdef RBC_HAVE_AVX512_TARGET
+    // Constructors may run before the compiler's own CPU detection, so run it first
+    __builtin_cpu_init();
+    features.avx2 = __builtin_cpu_supports("avx2") != 0;
+    features.avx512f = __builtin_cpu_supports("avx512f") != 0;
+    features.vaes = features.avx512f && __builtin_cpu_supports("avx512bw") &&
+                    __builtin_cpu_supports("vaes");
+    features.avx512ifma = features.avx512f && __builtin_cpu_supports("avx512ifma");
+#endif
+
+#ifdef RBC_HAVE_SHA_NI_TARGET
+    unsigned int eax, ebx, ecx, edx;
+
+    // Not every compiler that can target the SHA extensions can detect them through
+    // __builtin_cpu_supports, so ask CPUID for them directly
+    if (__get_cpuid_max(0, NULL) >= 7) {
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        features.sha_ni = (ebx & bit_SHA) != 0;
+    }
+#endif
+}
+
+const CpuFeatures* cpuFeatures(void) {
+    return &features;
+}
@@ -0,0 +1,35 @@
+#ifndef RBC_VALIDATOR_CPU_FEATURES_H_
+#define RBC_VALIDATOR_CPU_FEATURES_H_
+
+// Defined if the compiler can both build a function for AVX-512 and its extensions (VAES, IFMA)
+// through __attribute__((target)) and detect them at runtime through __builtin_cpu_supports. Older
+// compilers can do neither, so the kernels that need them are left out there.
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 8)
+#define RBC_HAVE_AVX512_TARGET
+#endif
+
+// Defined if the compiler can build a function for the SHA extensions through
+// __attribute__((target)), which it could long before AVX-512.
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5)
+#define RBC_HAVE_SHA_NI_TARGET
+#endif
+
+/// The instruction set extensions the kernels pick between at runtime. Each is only set if the CPU
+/// has it and the compiler could build the kernels that use it.
+typedef struct CpuFeatures {
+    int avx2;
+    int avx512f;
+    /// VAES along with AVX-512F and AVX-512BW, which the VAES kernel also uses.
+    int vaes;
+    /// AVX-512 IFMA along with AVX-512F.
+    int avx512ifma;
+    /// The SHA extensions.
+    int sha_ni;
+} CpuFeatures;
+
+/// Get the features of the CPU running the program, which are detected once before main rather
+/// than by every batch of keys.
+/// \return The features, which stay the same for the whole run.
+const CpuFeatures* cpuFeatures(void);
+
+#endif  // RBC_VALIDATOR_CPU_FEATURES_H_
@@ -6,6 +6,8 @@
 
 #include <ctype.h>
 #include <openssl/err.h>
+#include <stdlib.h>
+#include <string.h>
 
 void tolowerStr(char* str);
 
@@ -45,6 +47,207 @@ int getEcPublicKey(EC_POINT* point, BN_CTX* ctx, const EC_GROUP* group,
     return 0;
 }
 
+EcStep* EcStep_create(const EC_GROUP* group, size_t priv_key_size, size_t window_size) {
+    EcStep* step;
+    BN_CTX* ctx;
+    BIGNUM* lowest;
+    EC_POINT** powers;
+    size_t bits = window_size * 8;
+    int status;
+
+    if (group == NULL || window_size == 0 || window_size > priv_key_size ||
+        (step = calloc(1, sizeof(*step))) == NULL) {
+        return NULL;
+    }
+
+    step->group = group;
+    step->priv_key_size = priv_key_size;
+    step->window_size = window_size;
+
+    if ((step->points = calloc(bits * 2, sizeof(*step->points))) == NULL ||
+        (step->priv_key = malloc(priv_key_size)) == NULL ||
+        (step->base_key = malloc(priv_key_size)) == NULL ||
+        (step->base_point = EC_POINT_new(group)) == NULL) {
+        EcStep_destroy(step);
+
+        return NULL;
+    }
+
+    if ((powers = malloc(bits * sizeof(*powers))) == NULL || (ctx = BN_CTX_new()) == NULL) {
+        free(powers);
+        EcStep_destroy(step);
+
+        return NULL;
+    }
+
+    BN_CTX_start(ctx);
+    lowest = BN_CTX_get(ctx);
+    status = lowest == NULL;
+
+    // powers[i] is 2^i·G for the i-th lowest scalar bit of the window, which starts at the last
+    // byte of the window, and each is the doubling of the one below it
+    for (size_t i = 0; i < bits && !status; i++) {
+        if ((powers[i] = EC_POINT_new(group)) == NULL) {
+            status = 1;
+        } else if (i == 0) {
+            status = !BN_set_bit(lowest, (int)((priv_key_size - window_size) * 8)) ||
+                     !EC_POINT_mul(group, powers[i], lowest, NULL, NULL, ctx);
+        } else {
+            status = !EC_POINT_dbl(group, powers[i], powers[i - 1], ctx);
+        }
+
+        // Byte j of the window holds scalar bits 8 * (window_size - 1 - j) and up of it
+        step->points[2 * ((window_size - 1 - i / 8) * 8 + i % 8) + 1] = powers[i];
+    }
+
+    // Made affine to take the cheaper mixed addition, sharing a single inversion between them all
+    if (!status && !EC_POINTs_make_affine(group, bits, powers, ctx)) {
+        status = 1;
+    }
+
+    for (size_t j = 0; j < bits && !status; j++) {
+        if ((step->points[2 * j] = EC_POINT_dup(step->points[2 * j + 1], group)) == NULL ||
+            !EC_POINT_invert(group, step->points[2 * j], ctx)) {
+            status = 1;
+        }
+    }
+
+    BN_CTX_end(ctx);
+    BN_CTX_free(ctx);
+    free(powers);
+
+    if (status) {
+        EcStep_destroy(step);
+
+        return NULL;
+    }
+
+    return step;
+}
+
+void EcStep_destroy(EcStep* step) {
+    if (step == NULL) {
+        return;
+    }
+
+    if (step->points != NULL) {
+        for (size_t i = 0; i < step->window_size * 8 * 2; i++) {
+            EC_POINT_free(step->points[i]);
+        }
+
+        free(step->points);
+    }
+
+    EC_POINT_free(step->base_point);
+    free(step->base_key);
+    free(step->priv_key);
+    free(step);
+}
+
+int EcStep_setBase(EcStep* step, BN_CTX* ctx, const unsigned char* priv_key) {
+    step->has_base = 0;
+
+    if (getEcPublicKey(step->base_point, ctx, step->group, priv_key, step->priv_key_size)) {
+        return 1;
+    }
+
+    memcpy(step->base_key, priv_key, step->priv_key_size);
+    step->has_base = 1;
+
+    return 0;
+}
+
+/// Count how many bits two private keys differ by, as long as they only differ in the window.
+/// \return The count, or more than EC_STEP_MAX_FLIPS if the keys differ outside of the window or
+/// in more bits than that.
+static int countFlips(const EcStep* step, const unsigned char* from, const unsigned char* to) {
+    int flips = 0;
+
+    for (size_t i = 0; i < step->window_size && flips <= EC_STEP_MAX_FLIPS; i++) {
+        flips += __builtin_popcount(from[i] ^ to[i]);
+    }
+
+    if (memcmp(from + step->window_size, to + step->window_size,
+               step->priv_key_size - step->window_size) != 0) {
+        return EC_STEP_MAX_FLIPS + 1;
+    }
+
+    return flips;
+}
+
+int EcStep_get(EcStep* step, EC_POINT* point, BN_CTX* ctx, const unsigned char* priv_key) {
+    const unsigned char* from = NULL;
+    int flips = EC_STEP_MAX_FLIPS + 1, base_flips;
+
+    if (step->has_key) {
+        flips = countFlips(step, step->priv_key, priv_key);
+        from = step->priv_key;
+    }
+
+    if (step->has_base && (base_flips = countFlips(step, step->base_key, priv_key)) < flips) {
+        if (base_flips <= EC_STEP_MAX_FLIPS && !EC_POINT_copy(point, step->base_point)) {
+            return 1;
+        }
+
+        flips = base_flips;
+        from = step->base_key;
+    }
+
+    step->has_key = 0;
+
+    if (flips > EC_STEP_MAX_FLIPS) {
+        if (getEcPublicKey(point, ctx, step->group, priv_key, step->priv_key_size)) {
+            return 1;
+        }
+    } else {
+        for (size_t i = 0; i < step->window_size; i++) {
+            unsigned int flipped = from[i] ^ priv_key[i];
+
+            while (flipped) {
+                unsigned int bit = (unsigned int)__builtin_ctz(flipped);
+
+                if (!EC_POINT_add(step->group, point, point,
+                                  step->points[2 * (i * 8 + bit) + ((priv_key[i] >> bit) & 1)],
+                                  ctx)) {
+                    return 1;
+                }
+
+                flipped &= flipped - 1;
+            }
+        }
+    }
+
+    memcpy(step->priv_key, priv_key, step->priv_key_size);
+    step->has_key = 1;
+
+    return 0;
+}
+
+int getP256Affine(P256Affine* r, const EC_GROUP* group, const EC_POINT* point, BN_CTX* ctx) {
+    unsigned char oct[P256_UNCOMPRESSED_SIZE];
+
+    if (EC_GROUP_get_curve_name(group) != NID_X9_62_prime256v1 ||
+        EC_POINT_point2oct(group, point, POINT_CONVERSION_UNCOMPRESSED, oct, sizeof(oct), ctx) !=
+                sizeof(oct)) {
+        return 1;
+    }
+
+    return p256AffineFromBytes(r, oct);
+}
+
+int getSecp256k1Affine(Secp256k1Affine* r, const EC_GROUP* group, const EC_POINT* point,
+                       BN_CTX* ctx) {
+    unsigned char oct[SECP256K1_UNCOMPRESSED_SIZE];
+
+    if (EC_GROUP_get_curve_name(group) != NID_secp256k1 ||
+        EC_POINT_point2oct(group, point, POINT_CONVERSION_UNCOMPRESSED, oct, sizeof(oct), ctx) !=
+                sizeof(oct)) {
+        return 1;
+    }
+
+    return secp256k1AffineFromBytes(r, oct);
+}
+
 int fprintfEcPoint(FILE* stream, const EC_GROUP* group, const EC_POINT* point,
                    point_conversion_form_t form, BN_CTX* ctx) {
     char* hex;
@@ -9,8 +9,77 @@
 #include <openssl/ec.h>
 #include <openssl/obj_mac.h>
 
+#include "p256.h"
+#include "secp256k1.h"
+
+// The most bits two private keys can differ by for EcStep_get to still step from one public key
+// to the other, past which a single scalar multiplication is cheaper
+#define EC_STEP_MAX_FLIPS 16
+
+/// Works out the public keys of a run of private keys that each differ from the last in only a few
+/// bits. Flipping bit i of a private key adds or subtracts 2^i·G from its public key, so with
+/// those points worked out once, each public key only costs a point addition per flipped bit
+/// rather than a full scalar multiplication. Only the leading window_size bytes of the private
+/// keys may vary, the rest being a constant part that is never stepped over, and a base private
+/// key (such as the host seed) can be set to step from when the last key is too far away.
+typedef struct EcStep {
+    const EC_GROUP* group;
+    // points[2 * j + b] is what setting bit j % 8 of byte j / 8 of the private key to b adds to its
+    // public key, that is 2^i·G if b is 1 or -(2^i·G) if b is 0 for the scalar bit i it holds
+    EC_POINT** points;
+    size_t priv_key_size, window_size;
+    // The private key whose public key was worked out last, if has_key is set
+    unsigned char* priv_key;
+    int has_key;
+    // The base private key and its public key, if has_base is set
+    unsigned char* base_key;
+    EC_POINT* base_point;
+    int has_base;
+} EcStep;
+
 int getEcPublicKey(EC_POINT* point, BN_CTX* ctx, const EC_GROUP* group,
                    const unsigned char* priv_key, size_t priv_key_size);
+
+/// Precompute the points for stepping between the public keys of an EC group.
+/// \param group The EC group the private keys are scalars of.
+/// \param priv_key_size How many bytes every private key has, as a big-endian scalar.
+/// \param window_size How many of the leading bytes can differ between the private keys, up to
+/// priv_key_size. Keys that differ past them always start over from a multiplication.
+/// \return A new EcStep, or NULL on error.
+EcStep* EcStep_create(const EC_GROUP* group, size_t priv_key_size, size_t window_size);
+void EcStep_destroy(EcStep* step);
+
+/// Set the base private key, working out its public key once to step from whenever it is closer
+/// than the last private key.
+/// \param step The EcStep.
+/// \param ctx An optional BN_CTX to work with. NULL to allocate one as needed.
+/// \param priv_key The base private key of step's priv_key_size bytes.
+/// \return Returns 0 on success, or 1 on error.
+int EcStep_setBase(EcStep* step, BN_CTX* ctx, const unsigned char* priv_key);
+
+/// Work out the public key of a private key, stepping from the one worked out by the last call or
+/// from the base, whichever differs from it by fewer bits, if that is at most EC_STEP_MAX_FLIPS
+/// bits all within the window, or else using getEcPublicKey.
+/// \param step The EcStep, which remembers the private key for the next call.
+/// \param point The public key. Must be the same point passed to the last call, left as it was.
+/// \param ctx An optional BN_CTX to work with. NULL to allocate one as needed.
+/// \param priv_key The private key of step's priv_key_size bytes.
+/// \return Returns 0 on success, or 1 on error.
+int EcStep_get(EcStep* step, EC_POINT* point, BN_CTX* ctx, const unsigned char* priv_key);
+
+/// Convert an OpenSSL point on P-256 to the custom implementation's affine form.
+/// \param r The output point.
+/// \param group The EC group of the point, which must be P-256.
+/// \param point The point, which can't be at infinity.
+/// \param ctx An optional BN_CTX to work with.
+/// \return Returns 0 on success, or 1 on error.
+int getP256Affine(P256Affine* r, const EC_GROUP* group, const EC_POINT* point, BN_CTX* ctx);
+
+/// The same as getP256Affine, but for secp256k1.
+/// \param group The EC group of the point, which must be secp256k1.
+int getSecp256k1Affine(Secp256k1Affine* r, const EC_GROUP* group, const EC_POINT* point,
+                       BN_CTX* ctx);
+
 int fprintfEcPoint(FILE* stream, const EC_GROUP* group, const EC_POINT* point,
                    point_conversion_form_t form, BN_CTX* ctx);
 
@@ -223,8 +223,8 @@ int sha512Hash(unsigned char* digest, const unsigned char* msg, size_t msg_size,
     return 0;
 }
 
-int sha3224Hash(unsigned char* digest, const unsigned char* msg, size_t msg_size,
-                const unsigned char* salt, size_t salt_size) {
+int sha3_224Hash(unsigned char* digest, const unsigned char* msg, size_t msg_size,
+                 const unsigned char* salt, size_t salt_size) {
     Keccak_HashInstance inst;
 
     if (Keccak_HashInitialize_SHA3_224(&inst) == KECCAK_FAIL) {
@@ -282,7 +282,7 @@ int shake256Hash(unsigned char* digest, size_t digest_size, const unsigned char*
                  size_t msg_size, const unsigned char* salt, size_t salt_size) {
     Keccak_HashInstance inst;
 
-    if (Keccak_HashInitialize_SHAKE128(&inst) == KECCAK_FAIL) {
+    if (Keccak_HashInitialize_SHAKE256(&inst) == KECCAK_FAIL) {
         return 1;
     }
 
@@ -335,8 +335,8 @@ int keccakHash(unsigned char* digest, const size_t* digest_size, Keccak_HashInst
         return 1;
     }
 
-    // Perform an XOF
-    if (digest_size != NULL && Keccak_HashSqueeze(inst, digest, *digest_size) == KECCAK_FAIL) {
+    // Perform an XOF, whose output length is given in bits
+    if (digest_size != NULL && Keccak_HashSqueeze(inst, digest, *digest_size * 8) == KECCAK_FAIL) {
         OPENSSL_cleanse(inst, sizeof(*inst));
         return 1;
     }
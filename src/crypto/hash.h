@@ -95,8 +95,8 @@ int sha512Hash(unsigned char* digest, const unsigned char* msg, size_t msg_size,
 /// \param salt An additional, optional salt that will perform a secondary update after msg.
 /// \param salt_size How big the salt is. If salt is NULL, then this value is ignored.
 /// \return Returns a 0 on success and a 1 on failure.
-int sha3224Hash(unsigned char* digest, const unsigned char* msg, size_t msg_size,
-                const unsigned char* salt, size_t salt_size);
+int sha3_224Hash(unsigned char* digest, const unsigned char* msg, size_t msg_size,
+                 const unsigned char* salt, size_t salt_size);
 
 /// Perform SHA3-256 using XKCP's (potentially) faster low level functions.
 /// \param digest The output digest. It must be pre-allocated with at least 32 bytes.
@@ -0,0 +1,1505 @@
+#include "hash_mb.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu_features.h"
+
+#if defined(RBC_HAVE_AVX512_TARGET) || defined(RBC_HAVE_SHA_NI_TARGET)
+#include <immintrin.h>
+#endif
+
+#ifdef RBC_HAVE_AVX512_TARGET
+#define HASH_MB_AVX2_TARGET   __attribute__((target("avx2")))
+#define HASH_MB_AVX512_TARGET __attribute__((target("avx512f")))
+#endif
+
+#ifdef RBC_HAVE_SHA_NI_TARGET
+#define HASH_MB_SHA_NI_TARGET __attribute__((target("sha,sse4.1")))
+#endif
+
+#define MD5_ROUNDS 64
+#define MD5_STATE_WORDS 4
+#define SHA1_ROUNDS 80
+#define SHA1_STATE_WORDS 5
+// The rounds whose word every MD5 and SHA-1 target gives away, five from the end
+#define MD5_EARLY_ROUND (MD5_ROUNDS - 5)
+#define SHA1_EARLY_ROUND (SHA1_ROUNDS - 5)
+#define SHA256_ROUNDS 64
+#define SHA256_STATE_WORDS 8
+#define SHA224_DIGEST_WORDS 7
+#define SHA512_ROUNDS 80
+#define SHA512_STATE_WORDS 8
+#define SHA384_DIGEST_WORDS 6
+
+#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+#define ROTR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static const uint32_t sha256_k[SHA256_ROUNDS] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4,
+        0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe,
+        0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f,
+        0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+        0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+        0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+        0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116,
+        0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7,
+        0xc67178f2,
+};
+
+static const uint32_t sha256_iv[SHA256_STATE_WORDS] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+static const uint32_t sha224_iv[SHA256_STATE_WORDS] = {
+        0xc1059ed8, 0x367cd507, 0x3070dd17, 0xf70e5939,
+        0xffc00b31, 0x68581511, 0x64f98fa7, 0xbefa4fa4,
+};
+
+static const uint32_t sha1_iv[SHA1_STATE_WORDS] = {
+        0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0,
+};
+
+static inline uint32_t loadBe32(const unsigned char* bytes) {
+    return (uint32_t)bytes[0] << 24 | (uint32_t)bytes[1] << 16 | (uint32_t)bytes[2] << 8 |
+           (uint32_t)bytes[3];
+}
+
+static inline uint32_t loadLe32(const unsigned char* bytes) {
+    return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 |
+           (uint32_t)bytes[3] << 24;
+}
+
+int sha256MbTail(uint32_t* tail, const unsigned char* salt, size_t salt_size) {
+    unsigned char bytes[SHA256_MB_TAIL_WORDS * sizeof(uint32_t)] = {0};
+    uint64_t bit_length = (HASH_MB_KEY_SIZE + salt_size) * 8;
+
+    if (salt_size > SHA256_MB_MAX_SALT_SIZE || (salt == NULL && salt_size != 0)) {
+        return 1;
+    }
+
+    if (salt_size > 0) {
+        memcpy(bytes, salt, salt_size);
+    }
+    bytes[salt_size] = 0x80;
+
+    // The message length in bits ends the block as a big-endian 64-bit integer
+    for (size_t i = 0; i < sizeof(bit_length); ++i) {
+        bytes[sizeof(bytes) - 1 - i] = (unsigned char)(bit_length >> (i * 8));
+    }
+
+    for (size_t i = 0; i < SHA256_MB_TAIL_WORDS; ++i) {
+        tail[i] = loadBe32(bytes + i * sizeof(uint32_t));
+    }
+
+    return 0;
+}
+
+/// Run a single round of SHA-256 on a state in place.
+/// \param kw The round's constant plus its message word.
+static void sha256MbRound(uint32_t* state, uint32_t kw) {
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    uint32_t t1, t2;
+
+    t1 = h + (ROTR32(e, 6) ^ ROTR32(e, 11) ^ ROTR32(e, 25)) + ((e & f) ^ (~e & g)) + kw;
+    t2 = (ROTR32(a, 2) ^ ROTR32(a, 13) ^ ROTR32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+
+    state[0] = t1 + t2, state[1] = a, state[2] = b, state[3] = c;
+    state[4] = d + t1, state[5] = e, state[6] = f, state[7] = g;
+}
+
+#define SHA256_SIGMA0(x) (ROTR32(x, 7) ^ ROTR32(x, 18) ^ ((x) >> 3))
+#define SHA256_SIGMA1(x) (ROTR32(x, 17) ^ ROTR32(x, 19) ^ ((x) >> 10))
+
+// Whether message word i has any terms that come from the key, which is every word but the tail's
+#define SHA256_MB_KEYED(i) ((i) < (int)HASH_MB_KEY_WORDS || (i) >= 16)
+
+/// Fill a target for SHA-224 or SHA-256, working back from the state words of the digest.
+static void sha256MbTargetIv(HashMbTarget* target, const uint32_t* tail,
+                             const unsigned char* digest, const uint32_t* iv, size_t digest_words) {
+    // The word each round computes into a, of which the last four end up as a, b, c, and d
+    uint32_t a[SHA256_ROUNDS];
+    // The first 16 message words, leaving out the key's
+    uint32_t w[16] = {0};
+
+    for (size_t i = 0; i < SHA256_MB_TAIL_WORDS; ++i) {
+        w[HASH_MB_KEY_WORDS + i] = tail[i];
+        target->tail_k[i] = sha256_k[HASH_MB_KEY_WORDS + i] + tail[i];
+    }
+
+    // Each message word t after the first 16 is the sum of words t - 16 and t - 7 and the sigmas
+    // of words t - 15 and t - 2, so up to word 31 some of those terms are the tail's
+    for (int t = 16; t < 16 + SHA256_MB_TAIL_SCHEDULE_WORDS; ++t) {
+        uint32_t sum = 0;
+
+        if (!SHA256_MB_KEYED(t - 16)) {
+            sum += w[t - 16];
+        }
+        if (!SHA256_MB_KEYED(t - 15)) {
+            sum += SHA256_SIGMA0(w[t - 15]);
+        }
+        if (!SHA256_MB_KEYED(t - 7)) {
+            sum += w[t - 7];
+        }
+        if (!SHA256_MB_KEYED(t - 2)) {
+            sum += SHA256_SIGMA1(w[t - 2]);
+        }
+
+        target->tail_schedule[t - 16] = sum;
+    }
+
+    for (size_t i = 0; i < digest_words; ++i) {
+        target->words[i] = loadBe32(digest + i * sizeof(uint32_t));
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        a[SHA256_ROUNDS - 1 - i] = target->words[i] - iv[i];
+    }
+
+    target->word_count = digest_words;
+    target->early_round = SHA256_ROUNDS - 4;
+
+    // Round t computes e as a[t - 4] + t1 and a as t1 + t2, where t2 only depends on the three a
+    // words before it, so the e word it left in the digest gives away a[t - 4]
+    for (size_t i = 4; i < digest_words; ++i) {
+        int t = SHA256_ROUNDS + 3 - (int)i;
+        uint32_t x = a[t - 1], y = a[t - 2], z = a[t - 3];
+        uint32_t t2 = ROTR32(x, 2) ^ ROTR32(x, 13) ^ ROTR32(x, 22);
+
+        t2 += (x & y) ^ (x & z) ^ (y & z);
+
+        a[t - 4] = target->words[i] - iv[i] - (a[t] - t2);
+        target->early_round = t - 4;
+    }
+
+    target->early = a[target->early_round];
+}
+
+void sha256MbTarget(HashMbTarget* target, const uint32_t* tail, const unsigned char* digest) {
+    sha256MbTargetIv(target, tail, digest, sha256_iv, SHA256_STATE_WORDS);
+}
+
+void sha224MbTarget(HashMbTarget* target, const uint32_t* tail, const unsigned char* digest) {
+    sha256MbTargetIv(target, tail, digest, sha224_iv, SHA224_DIGEST_WORDS);
+}
+
+/// The plain C fallback, for a single key.
+/// \return Returns 1 if the key's digest matches target, or 0 if not.
+static int sha256MbLane(const uint32_t* keys, size_t key_count, size_t lane, const uint32_t* iv,
+                        const HashMbTarget* target) {
+    uint32_t w[16], state[SHA256_STATE_WORDS];
+
+    for (size_t i = 0; i < HASH_MB_KEY_WORDS; ++i) {
+        w[i] = __builtin_bswap32(keys[i * key_count + lane]);
+    }
+
+    memcpy(state, iv, sizeof(state));
+
+    for (int t = 0; t < (int)HASH_MB_KEY_WORDS; ++t) {
+        sha256MbRound(state, sha256_k[t] + w[t]);
+    }
+
+    // The tail's words come with their round constants already added
+    for (int t = HASH_MB_KEY_WORDS; t < 16; ++t) {
+        sha256MbRound(state, target->tail_k[t - HASH_MB_KEY_WORDS]);
+    }
+
+    // Expand the message schedule in place, 16 words at a time, only adding the terms from the key
+    // to those the target already summed up from the tail. Unrolled so that which terms those are
+    // is known ahead of time.
+#pragma GCC unroll 16
+    for (int t = 16; t < 32; ++t) {
+        uint32_t x = target->tail_schedule[t - 16];
+
+        if (SHA256_MB_KEYED(t - 16)) {
+            x += w[t & 15];
+        }
+        if (SHA256_MB_KEYED(t - 15)) {
+            x += SHA256_SIGMA0(w[(t - 15) & 15]);
+        }
+        if (SHA256_MB_KEYED(t - 7)) {
+            x += w[(t - 7) & 15];
+        }
+        if (SHA256_MB_KEYED(t - 2)) {
+            x += SHA256_SIGMA1(w[(t - 2) & 15]);
+        }
+
+        w[t & 15] = x;
+        sha256MbRound(state, sha256_k[t] + w[t & 15]);
+    }
+
+    for (int t = 32; t < SHA256_ROUNDS; ++t) {
+        w[t & 15] += SHA256_SIGMA1(w[(t - 2) & 15]) + w[(t - 7) & 15] +
+                     SHA256_SIGMA0(w[(t - 15) & 15]);
+        sha256MbRound(state, sha256_k[t] + w[t & 15]);
+
+        // Almost every key can already be rejected by the one word the target gives away early
+        if (t == target->early_round && state[0] != target->early) {
+            return 0;
+        }
+    }
+
+    for (size_t i = 0; i < target->word_count; ++i) {
+        if (state[i] + iv[i] != target->words[i]) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+#ifdef RBC_HAVE_AVX512_TARGET
+#define ROTR32_AVX2(x, n) _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - (n)))
+#define SHA256_SIGMA0_AVX2(x)                                                     \
+    _mm256_xor_si256(_mm256_xor_si256(ROTR32_AVX2(x, 7), ROTR32_AVX2(x, 18)), \
+                     _mm256_srli_epi32(x, 3))
+#define SHA256_SIGMA1_AVX2(x)                                                      \
+    _mm256_xor_si256(_mm256_xor_si256(ROTR32_AVX2(x, 17), ROTR32_AVX2(x, 19)), \
+                     _mm256_srli_epi32(x, 10))
+
+/// The same as sha256MbRound, but over HASH_MB_AVX2_LANES states.
+static inline HASH_MB_AVX2_TARGET __attribute__((always_inline)) void sha256MbAvx2Round(
+        __m256i* state, __m256i kw) {
+    __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+    __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+    __m256i t1, t2;
+
+    t1 = _mm256_xor_si256(_mm256_xor_si256(ROTR32_AVX2(e, 6), ROTR32_AVX2(e, 11)),
+                          ROTR32_AVX2(e, 25));
+    t1 = _mm256_add_epi32(_mm256_add_epi32(h, t1),
+                          _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g)));
+    t1 = _mm256_add_epi32(t1, kw);
+
+    t2 = _mm256_xor_si256(_mm256_xor_si256(ROTR32_AVX2(a, 2), ROTR32_AVX2(a, 13)),
+                          ROTR32_AVX2(a, 22));
+    t2 = _mm256_add_epi32(t2, _mm256_or_si256(_mm256_and_si256(a, b),
+                                              _mm256_and_si256(c, _mm256_or_si256(a, b))));
+
+    state[0] = _mm256_add_epi32(t1, t2), state[1] = a, state[2] = b, state[3] = c;
+    state[4] = _mm256_add_epi32(d, t1), state[5] = e, state[6] = f, state[7] = g;
+}
+
+/// The same as sha256MbLane, but over HASH_MB_AVX2_LANES keys starting from lane, and only up to
+/// the target's early round.
+/// \return A mask with bit j set if key lane + j passes the early check.
+static HASH_MB_AVX2_TARGET uint32_t sha256MbAvx2(const uint32_t* keys, size_t key_count,
+                                                 size_t lane, const uint32_t* iv,
+                                                 const HashMbTarget* target) {
+    const __m256i bswap = _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+                                          12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    __m256i w[16], state[SHA256_STATE_WORDS];
+
+    for (size_t i = 0; i < HASH_MB_KEY_WORDS; ++i) {
+        w[i] = _mm256_loadu_si256((const __m256i*)(keys + i * key_count + lane));
+        w[i] = _mm256_shuffle_epi8(w[i], bswap);
+    }
+
+    for (size_t i = 0; i < SHA256_STATE_WORDS; ++i) {
+        state[i] = _mm256_set1_epi32((int)iv[i]);
+    }
+
+    for (int t = 0; t < (int)HASH_MB_KEY_WORDS; ++t) {
+        sha256MbAvx2Round(state, _mm256_add_epi32(_mm256_set1_epi32((int)sha256_k[t]), w[t]));
+    }
+
+    for (int t = HASH_MB_KEY_WORDS; t < 16; ++t) {
+        sha256MbAvx2Round(state, _mm256_set1_epi32((int)target->tail_k[t - HASH_MB_KEY_WORDS]));
+    }
+
+    // The same as in sha256MbLane
+#pragma GCC unroll 16
+    for (int t = 16; t < 32; ++t) {
+        __m256i x = _mm256_set1_epi32((int)target->tail_schedule[t - 16]);
+
+        if (SHA256_MB_KEYED(t - 16)) {
+            x = _mm256_add_epi32(x, w[t & 15]);
+        }
+        if (SHA256_MB_KEYED(t - 15)) {
+            x = _mm256_add_epi32(x, SHA256_SIGMA0_AVX2(w[(t - 15) & 15]));
+        }
+        if (SHA256_MB_KEYED(t - 7)) {
+            x = _mm256_add_epi32(x, w[(t - 7) & 15]);
+        }
+        if (SHA256_MB_KEYED(t - 2)) {
+            x = _mm256_add_epi32(x, SHA256_SIGMA1_AVX2(w[(t - 2) & 15]));
+        }
+
+        w[t & 15] = x;
+        sha256MbAvx2Round(state, _mm256_add_epi32(_mm256_set1_epi32((int)sha256_k[t]), x));
+    }
+
+    for (int t = 32; t <= target->early_round; ++t) {
+        w[t & 15] = _mm256_add_epi32(
+                _mm256_add_epi32(w[t & 15], SHA256_SIGMA0_AVX2(w[(t - 15) & 15])),
+                _mm256_add_epi32(w[(t - 7) & 15], SHA256_SIGMA1_AVX2(w[(t - 2) & 15])));
+        sha256MbAvx2Round(state, _mm256_add_epi32(_mm256_set1_epi32((int)sha256_k[t]), w[t & 15]));
+    }
+
+    state[0] = _mm256_cmpeq_epi32(state[0], _mm256_set1_epi32((int)target->early));
+
+    return (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(state[0]));
+}
+
+// Selects bits from y where x is set and from z otherwise
+#define CH_AVX512(x, y, z)      _mm512_ternarylogic_epi32(x, y, z, 0xca)
+#define MAJ_AVX512(x, y, z)     _mm512_ternarylogic_epi32(x, y, z, 0xe8)
+#define XOR3_AVX512(x, y, z)    _mm512_ternarylogic_epi32(x, y, z, 0x96)
+
+#define SHA256_SIGMA0_AVX512(x) \
+    XOR3_AVX512(_mm512_ror_epi32(x, 7), _mm512_ror_epi32(x, 18), _mm512_srli_epi32(x, 3))
+#define SHA256_SIGMA1_AVX512(x) \
+    XOR3_AVX512(_mm512_ror_epi32(x, 17), _mm512_ror_epi32(x, 19), _mm512_srli_epi32(x, 10))
+
+/// The same as sha256MbRound, but over HASH_MB_AVX512_LANES states.
+static inline HASH_MB_AVX512_TARGET __attribute__((always_inline)) void sha256MbAvx512Round(
+        __m512i* state, __m512i kw) {
+    __m512i a = state[0], b = state[1], c = state[2], d = state[3];
+    __m512i e = state[4], f = state[5], g = state[6], h = state[7];
+    __m512i t1, t2;
+
+    t1 = XOR3_AVX512(_mm512_ror_epi32(e, 6), _mm512_ror_epi32(e, 11), _mm512_ror_epi32(e, 25));
+    t1 = _mm512_add_epi32(_mm512_add_epi32(h, t1), CH_AVX512(e, f, g));
+    t1 = _mm512_add_epi32(t1, kw);
+
+    t2 = XOR3_AVX512(_mm512_ror_epi32(a, 2), _mm512_ror_epi32(a, 13), _mm512_ror_epi32(a, 22));
+    t2 = _mm512_add_epi32(t2, MAJ_AVX512(a, b, c));
+
+    state[0] = _mm512_add_epi32(t1, t2), state[1] = a, state[2] = b, state[3] = c;
+    state[4] = _mm512_add_epi32(d, t1), state[5] = e, state[6] = f, state[7] = g;
+}
+
+/// The same as sha256MbAvx2, but over HASH_MB_AVX512_LANES keys.
+static HASH_MB_AVX512_TARGET uint32_t sha256MbAvx512(const uint32_t* keys, size_t key_count,
+                                                     size_t lane, const uint32_t* iv,
+                                                     const HashMbTarget* target) {
+    // Byte swap by rotating each word both ways and picking the right bytes from each
+    const __m512i byte_mask = _mm512_set1_epi32((int)0xff00ff00);
+    __m512i w[16], state[SHA256_STATE_WORDS];
+
+    for (size_t i = 0; i < HASH_MB_KEY_WORDS; ++i) {
+        w[i] = _mm512_loadu_si512(keys + i * key_count + lane);
+        w[i] = CH_AVX512(byte_mask, _mm512_ror_epi32(w[i], 8), _mm512_rol_epi32(w[i], 8));
+    }
+
+    for (size_t i = 0; i < SHA256_STATE_WORDS; ++i) {
+        state[i] = _mm512_set1_epi32((int)iv[i]);
+    }
+
+    for (int t = 0; t < (int)HASH_MB_KEY_WORDS; ++t) {
+        sha256MbAvx512Round(state, _mm512_add_epi32(_mm512_set1_epi32((int)sha256_k[t]), w[t]));
+    }
+
+    for (int t = HASH_MB_KEY_WORDS; t < 16; ++t) {
+        sha256MbAvx512Round(state, _mm512_set1_epi32((int)target->tail_k[t - HASH_MB_KEY_WORDS]));
+    }
+
+    // The same as in sha256MbLane
+#pragma GCC unroll 16
+    for (int t = 16; t < 32; ++t) {
+        __m512i x = _mm512_set1_epi32((int)target->tail_schedule[t - 16]);
+
+        if (SHA256_MB_KEYED(t - 16)) {
+            x = _mm512_add_epi32(x, w[t & 15]);
+        }
+        if (SHA256_MB_KEYED(t - 15)) {
+            x = _mm512_add_epi32(x, SHA256_SIGMA0_AVX512(w[(t - 15) & 15]));
+        }
+        if (SHA256_MB_KEYED(t - 7)) {
+            x = _mm512_add_epi32(x, w[(t - 7) & 15]);
+        }
+        if (SHA256_MB_KEYED(t - 2)) {
+            x = _mm512_add_epi32(x, SHA256_SIGMA1_AVX512(w[(t - 2) & 15]));
+        }
+
+        w[t & 15] = x;
+        sha256MbAvx512Round(state, _mm512_add_epi32(_mm512_set1_epi32((int)sha256_k[t]), x));
+    }
+
+    for (int t = 32; t <= target->early_round; ++t) {
+        w[t & 15] = _mm512_add_epi32(
+                _mm512_add_epi32(w[t & 15], SHA256_SIGMA0_AVX512(w[(t - 15) & 15])),
+                _mm512_add_epi32(w[(t - 7) & 15], SHA256_SIGMA1_AVX512(w[(t - 2) & 15])));
+        sha256MbAvx512Round(state,
+                            _mm512_add_epi32(_mm512_set1_epi32((int)sha256_k[t]), w[t & 15]));
+    }
+
+    return _mm512_cmpeq_epi32_mask(state[0], _mm512_set1_epi32((int)target->early));
+}
+#endif
+
+#ifdef RBC_HAVE_SHA_NI_TARGET
+// Reverses the bytes of each 32-bit word
+#define SHA_NI_BSWAP32 _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3)
+// Reverses all 16 bytes, which also puts the first word in the highest lane as SHA-1 expects
+#define SHA_NI_BSWAP128 _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)
+
+/// Hash up to SHA_NI_LANES keys using the SHA-256 extensions, interleaving the lanes to hide the
+/// latency of sha256rnds2. Always inlined, so that lanes becomes a constant.
+/// \param keys lanes keys of HASH_MB_KEY_SIZE bytes each, back to back.
+/// \param target The digest minus the IV as {A, B, E, F} and {C, D, G, H}, as the state is kept.
+/// \param cdgh_mask Which lanes of the {C, D, G, H} comparison must match.
+/// \return A mask with bit j set if key j matches.
+static inline HASH_MB_SHA_NI_TARGET __attribute__((always_inline)) uint32_t sha256NiLanes(
+        const unsigned char* keys, const uint32_t* tail, const uint32_t* iv,
+        const __m128i* target, int cdgh_mask, size_t lanes) {
+    __m128i abef[SHA_NI_LANES], cdgh[SHA_NI_LANES], msgs[SHA_NI_LANES][4];
+    uint32_t matches = 0;
+
+    for (size_t l = 0; l < lanes; ++l) {
+        const __m128i* key = (const __m128i*)(keys + l * HASH_MB_KEY_SIZE);
+
+        abef[l] = _mm_set_epi32((int)iv[0], (int)iv[1], (int)iv[4], (int)iv[5]);
+        cdgh[l] = _mm_set_epi32((int)iv[2], (int)iv[3], (int)iv[6], (int)iv[7]);
+
+        msgs[l][0] = _mm_shuffle_epi8(_mm_loadu_si128(key), SHA_NI_BSWAP32);
+        msgs[l][1] = _mm_shuffle_epi8(_mm_loadu_si128(key + 1), SHA_NI_BSWAP32);
+        msgs[l][2] = _mm_setr_epi32((int)tail[0], (int)tail[1], (int)tail[2], (int)tail[3]);
+        msgs[l][3] = _mm_setr_epi32((int)tail[4], (int)tail[5], (int)tail[6], (int)tail[7]);
+    }
+
+    // Four rounds at a time, expanding the schedule four words ahead of where it's needed. Fully
+    // unrolled so that the message words stay in registers.
+#pragma GCC unroll 16
+    for (int i = 0; i < SHA256_ROUNDS / 4; ++i) {
+        __m128i k = _mm_loadu_si128((const __m128i*)(sha256_k + i * 4));
+
+        for (size_t l = 0; l < lanes; ++l) {
+            __m128i* m = msgs[l];
+            __m128i msg = _mm_add_epi32(m[i & 3], k);
+
+            cdgh[l] = _mm_sha256rnds2_epu32(cdgh[l], abef[l], msg);
+
+            if (i >= 3 && i < 15) {
+                m[(i + 1) & 3] = _mm_add_epi32(m[(i + 1) & 3],
+                                               _mm_alignr_epi8(m[i & 3], m[(i + 3) & 3], 4));
+                m[(i + 1) & 3] = _mm_sha256msg2_epu32(m[(i + 1) & 3], m[i & 3]);
+            }
+
+            abef[l] = _mm_sha256rnds2_epu32(abef[l], cdgh[l], _mm_shuffle_epi32(msg, 0x0e));
+
+            if (i >= 1 && i < 13) {
+                m[(i + 3) & 3] = _mm_sha256msg1_epu32(m[(i + 3) & 3], m[i & 3]);
+            }
+        }
+    }
+
+    for (size_t l = 0; l < lanes; ++l) {
+        int equal = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(abef[l], target[0])));
+
+        if (equal == 0xf && (_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(
+                                     cdgh[l], target[1]))) & cdgh_mask) == cdgh_mask) {
+            matches |= UINT32_C(1) << l;
+        }
+    }
+
+    return matches;
+}
+
+// Run five groups of four SHA-1 rounds, all using round function f. The round function has to be
+// an immediate, hence the macro.
+#define SHA1_NI_ROUNDS(f)                                                      \
+    _Pragma("GCC unroll 5") for (int i = (f) * 5; i < ((f) + 1) * 5; ++i) {    \
+        for (size_t l = 0; l < lanes; ++l) {                                   \
+            __m128i* m = msgs[l];                                              \
+            __m128i e_next = abcd[l];                                          \
+                                                                               \
+            if (i == 0) {                                                      \
+                e[l] = _mm_add_epi32(e[l], m[0]);                              \
+            } else {                                                           \
+                e[l] = _mm_sha1nexte_epu32(e[l], m[i & 3]);                    \
+            }                                                                  \
+                                                                               \
+            if (i >= 3 && i < 19) {                                            \
+                m[(i + 1) & 3] = _mm_sha1msg2_epu32(m[(i + 1) & 3], m[i & 3]); \
+            }                                                                  \
+                                                                               \
+            abcd[l] = _mm_sha1rnds4_epu32(abcd[l], e[l], f);                   \
+            e[l] = e_next;                                                     \
+                                                                               \
+            if (i >= 1 && i < 17) {                                            \
+                m[(i + 3) & 3] = _mm_sha1msg1_epu32(m[(i + 3) & 3], m[i & 3]); \
+            }                                                                  \
+            if (i >= 2 && i < 18) {                                            \
+                m[(i + 2) & 3] = _mm_xor_si128(m[(i + 2) & 3], m[i & 3]);      \
+            }                                                                  \
+        }                                                                      \
+    }
+
+/// The same as sha256NiLanes, but for SHA-1.
+/// \param target The digest minus the IV as {A, B, C, D} and {E, 0, 0, 0}.
+static inline HASH_MB_SHA_NI_TARGET __attribute__((always_inline)) uint32_t sha1NiLanes(
+        const unsigned char* keys, const uint32_t* tail, const __m128i* target, size_t lanes) {
+    const __m128i e_iv = _mm_set_epi32((int)sha1_iv[4], 0, 0, 0);
+    __m128i abcd[SHA_NI_LANES], e[SHA_NI_LANES], msgs[SHA_NI_LANES][4];
+    uint32_t matches = 0;
+
+    for (size_t l = 0; l < lanes; ++l) {
+        const __m128i* key = (const __m128i*)(keys + l * HASH_MB_KEY_SIZE);
+
+        abcd[l] = _mm_set_epi32((int)sha1_iv[0], (int)sha1_iv[1], (int)sha1_iv[2],
+                                (int)sha1_iv[3]);
+        e[l] = e_iv;
+
+        msgs[l][0] = _mm_shuffle_epi8(_mm_loadu_si128(key), SHA_NI_BSWAP128);
+        msgs[l][1] = _mm_shuffle_epi8(_mm_loadu_si128(key + 1), SHA_NI_BSWAP128);
+        msgs[l][2] = _mm_set_epi32((int)tail[0], (int)tail[1], (int)tail[2], (int)tail[3]);
+        msgs[l][3] = _mm_set_epi32((int)tail[4], (int)tail[5], (int)tail[6], (int)tail[7]);
+    }
+
+    SHA1_NI_ROUNDS(0)
+    SHA1_NI_ROUNDS(1)
+    SHA1_NI_ROUNDS(2)
+    SHA1_NI_ROUNDS(3)
+
+    for (size_t l = 0; l < lanes; ++l) {
+        // E is only rotated into place by the next sha1nexte, so do that against the IV
+        __m128i e_final = _mm_sub_epi32(_mm_sha1nexte_epu32(e[l], e_iv), e_iv);
+        int equal = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(abcd[l], target[0])));
+
+        if (equal == 0xf && (_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(
+                                     e_final, target[1]))) & 0x8)) {
+            matches |= UINT32_C(1) << l;
+        }
+    }
+
+    return matches;
+}
+
+static HASH_MB_SHA_NI_TARGET uint32_t sha256NiMatchIv(const unsigned char* keys, size_t key_count,
+                                                      const uint32_t* tail, const uint32_t* iv,
+                                                      const unsigned char* digest,
+                                                      size_t digest_words) {
+    uint32_t t[SHA256_STATE_WORDS] = {0};
+    __m128i target[2];
+    uint32_t matches = 0;
+    size_t lane = 0;
+
+    for (size_t i = 0; i < digest_words; ++i) {
+        t[i] = loadBe32(digest + i * sizeof(uint32_t)) - iv[i];
+    }
+
+    target[0] = _mm_set_epi32((int)t[0], (int)t[1], (int)t[4], (int)t[5]);
+    target[1] = _mm_set_epi32((int)t[2], (int)t[3], (int)t[6], (int)t[7]);
+
+    // SHA-224 leaves out H, which is in the lowest lane
+    int cdgh_mask = digest_words == SHA256_STATE_WORDS ? 0xf : 0xe;
+
+    for (; lane + SHA_NI_LANES <= key_count; lane += SHA_NI_LANES) {
+        matches |= sha256NiLanes(keys + lane * HASH_MB_KEY_SIZE, tail, iv, target, cdgh_mask,
+                                 SHA_NI_LANES)
+                   << lane;
+    }
+
+    for (; lane < key_count; ++lane) {
+        matches |= sha256NiLanes(keys + lane * HASH_MB_KEY_SIZE, tail, iv, target, cdgh_mask, 1)
+                   << lane;
+    }
+
+    return matches;
+}
+#endif
+
+int hashMbHasShaNi(void) {
+    return cpuFeatures()->sha_ni;
+}
+
+int hashMbHasAvx512(void) {
+    return cpuFeatures()->avx512f;
+}
+
+uint32_t sha256NiMatch(const unsigned char* keys, size_t key_count, const uint32_t* tail,
+                       const unsigned char* digest) {
+#ifdef RBC_HAVE_SHA_NI_TARGET
+    if (key_count > HASH_MB_MAX_KEYS) {
+        key_count = HASH_MB_MAX_KEYS;
+    }
+
+    return sha256NiMatchIv(keys, key_count, tail, sha256_iv, digest, SHA256_STATE_WORDS);
+#else
+    // Unreachable, since hashMbHasShaNi is 0 when the SHA-NI kernels can't be built
+    abort();
+#endif
+}
+
+uint32_t sha224NiMatch(const unsigned char* keys, size_t key_count, const uint32_t* tail,
+                       const unsigned char* digest) {
+#ifdef RBC_HAVE_SHA_NI_TARGET
+    if (key_count > HASH_MB_MAX_KEYS) {
+        key_count = HASH_MB_MAX_KEYS;
+    }
+
+    return sha256NiMatchIv(keys, key_count, tail, sha224_iv, digest, SHA224_DIGEST_WORDS);
+#else
+    // Unreachable, since hashMbHasShaNi is 0 when the SHA-NI kernels can't be built
+    abort();
+#endif
+}
+
+#ifdef RBC_HAVE_SHA_NI_TARGET
+static HASH_MB_SHA_NI_TARGET uint32_t sha1NiMatchTarget(const unsigned char* keys,
+                                                        size_t key_count, const uint32_t* tail,
+                                                        const unsigned char* digest) {
+    uint32_t t[SHA1_STATE_WORDS];
+    __m128i target[2];
+    uint32_t matches = 0;
+    size_t lane = 0;
+
+    for (size_t i = 0; i < SHA1_STATE_WORDS; ++i) {
+        t[i] = loadBe32(digest + i * sizeof(uint32_t)) - sha1_iv[i];
+    }
+
+    target[0] = _mm_set_epi32((int)t[0], (int)t[1], (int)t[2], (int)t[3]);
+    target[1] = _mm_set_epi32((int)t[4], 0, 0, 0);
+
+    for (; lane + SHA_NI_LANES <= key_count; lane += SHA_NI_LANES) {
+        matches |= sha1NiLanes(keys + lane * HASH_MB_KEY_SIZE, tail, target, SHA_NI_LANES)
+                   << lane;
+    }
+
+    for (; lane < key_count; ++lane) {
+        matches |= sha1NiLanes(keys + lane * HASH_MB_KEY_SIZE, tail, target, 1) << lane;
+    }
+
+    return matches;
+}
+#endif
+
+uint32_t sha1NiMatch(const unsigned char* keys, size_t key_count, const uint32_t* tail,
+                     const unsigned char* digest) {
+#ifdef RBC_HAVE_SHA_NI_TARGET
+    if (key_count > HASH_MB_MAX_KEYS) {
+        key_count = HASH_MB_MAX_KEYS;
+    }
+
+    return sha1NiMatchTarget(keys, key_count, tail, digest);
+#else
+    // Unreachable, since hashMbHasShaNi is 0 when the SHA-NI kernels can't be built
+    abort();
+#endif
+}
+
+/// Run the widest kernel the CPU supports over as many keys as possible, then the narrower ones
+/// over whatever is left.
+static uint32_t sha256MbMatchIv(const uint32_t* keys, size_t key_count, const uint32_t* iv,
+                                const HashMbTarget* target) {
+    uint32_t matches = 0;
+    size_t lane = 0;
+
+    if (key_count > HASH_MB_MAX_KEYS) {
+        key_count = HASH_MB_MAX_KEYS;
+    }
+
+#ifdef RBC_HAVE_AVX512_TARGET
+    if (key_count >= HASH_MB_AVX512_LANES && cpuFeatures()->avx512f) {
+        for (; lane + HASH_MB_AVX512_LANES <= key_count; lane += HASH_MB_AVX512_LANES) {
+            matches |= sha256MbAvx512(keys, key_count, lane, iv, target) << lane;
+        }
+    }
+
+    if (key_count - lane >= HASH_MB_AVX2_LANES && cpuFeatures()->avx2) {
+        for (; lane + HASH_MB_AVX2_LANES <= key_count; lane += HASH_MB_AVX2_LANES) {
+            matches |= sha256MbAvx2(keys, key_count, lane, iv, target) << lane;
+        }
+    }
+
+    // The SIMD kernels stop at the target's early round, so the rare key that gets past it runs the
+    // rest of the rounds on its own to check its whole digest
+    for (uint32_t candidates = matches; candidates != 0; candidates &= candidates - 1) {
+        size_t j = (size_t)__builtin_ctz(candidates);
+
+        if (!sha256MbLane(keys, key_count, j, iv, target)) {
+            matches &= ~(UINT32_C(1) << j);
+        }
+    }
+#endif
+
+    // Finish off any remaining keys one at a time
+    for (; lane < key_count; ++lane) {
+        matches |= (uint32_t)sha256MbLane(keys, key_count, lane, iv, target) << lane;
+    }
+
+    return matches;
+}
+
+uint32_t sha256MbMatch(const uint32_t* keys, size_t key_count, const uint32_t* tail,
+                       const HashMbTarget* target) {
+    // Everything the kernels need from the tail is already in the target
+    (void)tail;
+
+    return sha256MbMatchIv(keys, key_count, sha256_iv, target);
+}
+
+uint32_t sha224MbMatch(const uint32_t* keys, size_t key_count, const uint32_t* tail,
+                       const HashMbTarget* target) {
+    (void)tail;
+
+    return sha256MbMatchIv(keys, key_count, sha224_iv, target);
+}
+
+static const uint32_t md5_k[MD5_ROUNDS] = {
+        0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613,
+        0xfd469501, 0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193,
+        0xa679438e, 0x49b40821, 0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d,
+        0x02441453, 0xd8a1e681, 0xe7d3fbc8, 0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed,
+        0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a, 0xfffa3942, 0x8771f681, 0x6d9d6122,
+        0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70, 0x289b7ec6, 0xeaa127fa,
+        0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665, 0xf4292244,
+        0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+        0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb,
+        0xeb86d391,
+};
+
+// How far each round rotates, repeating every four rounds within a group of 16
+static const int md5_shift[4][4] = {
+        {7, 12, 17, 22},
+        {5, 9, 14, 20},
+        {4, 11, 16, 23},
+        {6, 10, 15, 21},
+};
+
+// Which message word each round adds, which starts and steps by a different amount per group
+static const int md5_index_start[4] = {0, 1, 5, 0};
+static const int md5_index_step[4] = {1, 5, 3, 7};
+
+static const uint32_t md5_iv[MD5_STATE_WORDS] = {
+        0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476,
+};
+
+static const uint32_t sha1_k[4] = {0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6};
+
+int md5MbTail(uint32_t* tail, const unsigned char* salt, size_t salt_size) {
+    unsigned char bytes[MD5_MB_TAIL_WORDS * sizeof(uint32_t)] = {0};
+    uint64_t bit_length = (HASH_MB_KEY_SIZE + salt_size) * 8;
+
+    if (salt_size > MD5_MB_MAX_SALT_SIZE || (salt == NULL && salt_size != 0)) {
+        return 1;
+    }
+
+    if (salt_size > 0) {
+        memcpy(bytes, salt, salt_size);
+    }
+    bytes[salt_size] = 0x80;
+
+    // Unlike SHA, the message length in bits ends the block as a little-endian 64-bit integer
+    for (size_t i = 0; i < sizeof(bit_length); ++i) {
+        bytes[sizeof(bytes) - sizeof(bit_length) + i] = (unsigned char)(bit_length >> (i * 8));
+    }
+
+    for (size_t i = 0; i < MD5_MB_TAIL_WORDS; ++i) {
+        tail[i] = loadLe32(bytes + i * sizeof(uint32_t));
+    }
+
+    return 0;
+}
+
+// Which message word MD5 adds in round t
+#define MD5_INDEX(group, step) ((md5_index_start[group] + md5_index_step[group] * (step)) & 15)
+
+/// Run a single round of MD5 on a state in place.
+static void md5MbRound(uint32_t* state, int t, uint32_t w) {
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    int group = t / 16, step = t % 16;
+    uint32_t f;
+
+    switch (group) {
+        case 0:
+            f = (b & c) | (~b & d);
+            break;
+        case 1:
+            f = (d & b) | (~d & c);
+            break;
+        case 2:
+            f = b ^ c ^ d;
+            break;
+        default:
+            f = c ^ (b | ~d);
+            break;
+    }
+
+    f += a + md5_k[t] + w;
+    state[0] = d, state[1] = b + ROTL32(f, md5_shift[group][step % 4]), state[2] = b, state[3] = c;
+}
+
+void md5MbTarget(HashMbTarget* target, const uint32_t* tail, const unsigned char* digest) {
+    uint32_t a, b, c, d, f;
+
+    for (size_t i = 0; i < MD5_STATE_WORDS; ++i) {
+        target->words[i] = loadLe32(digest + i * sizeof(uint32_t));
+    }
+
+    // The words the last four rounds computed into b end up as a, d, c, and b, and the last round
+    // adds a message word from the tail, so it can be undone to get the word before them. Going
+    // into it, b, c, and d were the final c, d, and a.
+    a = target->words[0] - md5_iv[0], b = target->words[1] - md5_iv[1];
+    c = target->words[2] - md5_iv[2], d = target->words[3] - md5_iv[3];
+    f = d ^ (c | ~a);
+
+    target->word_count = MD5_STATE_WORDS;
+    target->early_round = MD5_EARLY_ROUND;
+    target->early = ROTR32(b - c, md5_shift[3][3]) - f - md5_k[MD5_ROUNDS - 1] -
+                    tail[MD5_INDEX(3, 15) - HASH_MB_KEY_WORDS];
+}
+
+/// The plain C fallback of MD5, for a single key.
+/// \return Returns 1 if the key's digest matches target, or 0 if not.
+static int md5MbLane(const uint32_t* keys, size_t key_count, size_t lane, const uint32_t* tail,
+                     const HashMbTarget* target) {
+    uint32_t w[16], state[MD5_STATE_WORDS];
+
+    for (size_t i = 0; i < HASH_MB_KEY_WORDS; ++i) {
+        w[i] = keys[i * key_count + lane];
+        w[8 + i] = tail[i];
+    }
+
+    memcpy(state, md5_iv, sizeof(state));
+
+    for (int t = 0; t < MD5_ROUNDS; ++t) {
+        md5MbRound(state, t, w[MD5_INDEX(t / 16, t % 16)]);
+
+        // Almost every key can already be rejected by the one word the target gives away early
+        if (t == target->early_round && state[1] != target->early) {
+            return 0;
+        }
+    }
+
+    for (size_t i = 0; i < MD5_STATE_WORDS; ++i) {
+        if (state[i] + md5_iv[i] != target->words[i]) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/// Run a single round of SHA-1 on a state in place.
+static void sha1MbRound(uint32_t* state, int t, uint32_t w) {
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+    uint32_t f;
+
+    if (t < 20) {
+        f = (b & c) | (~b & d);
+    } else if (t < 40 || t >= 60) {
+        f = b ^ c ^ d;
+    } else {
+        f = (b & c) | (b & d) | (c & d);
+    }
+
+    f += ROTL32(a, 5) + e + sha1_k[t / 20] + w;
+    state[0] = f, state[1] = a, state[2] = ROTL32(b, 30), state[3] = c, state[4] = d;
+}
+
+void sha1MbTarget(HashMbTarget* target, const uint32_t* tail, const unsigned char* digest) {
+    // Unlike MD5's, the target only undoes the rotation of the last round, which leaves out the
+    // message
+    (void)tail;
+
+    for (size_t i = 0; i < SHA1_STATE_WORDS; ++i) {
+        target->words[i] = loadBe32(digest + i * sizeof(uint32_t));
+    }
+
+    // The words the last five rounds computed into a end up as a, b, c, d, and e, rotated by 30
+    // past b. Every round before that adds a message word from the key, so it can't be undone.
+    target->word_count = SHA1_STATE_WORDS;
+    target->early_round = SHA1_EARLY_ROUND;
+    target->early = ROTR32(target->words[4] - sha1_iv[4], 30);
+}
+
+/// The plain C fallback of SHA-1, for a single key.
+/// \return Returns 1 if the key's digest matches target, or 0 if not.
+static int sha1MbLane(const uint32_t* keys, size_t key_count, size_t lane, const uint32_t* tail,
+                      const HashMbTarget* target) {
+    uint32_t w[16], state[SHA1_STATE_WORDS];
+
+    for (size_t i = 0; i < HASH_MB_KEY_WORDS; ++i) {
+        w[i] = __builtin_bswap32(keys[i * key_count + lane]);
+        w[8 + i] = tail[i];
+    }
+
+    memcpy(state, sha1_iv, sizeof(state));
+
+    for (int t = 0; t < SHA1_ROUNDS; ++t) {
+        if (t >= 16) {
+            w[t & 15] = ROTL32(w[(t - 3) & 15] ^ w[(t - 8) & 15] ^ w[(t - 14) & 15] ^ w[t & 15], 1);
+        }
+
+        sha1MbRound(state, t, w[t & 15]);
+
+        // Almost every key can already be rejected by the one word the target gives away early
+        if (t == target->early_round && state[0] != target->early) {
+            return 0;
+        }
+    }
+
+    for (size_t i = 0; i < SHA1_STATE_WORDS; ++i) {
+        if (state[i] + sha1_iv[i] != target->words[i]) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+#ifdef RBC_HAVE_AVX512_TARGET
+// The shift count doesn't have to be an immediate, as MD5's come from a table
+#define ROTLV32_AVX2(x, n)                                      \
+    _mm256_or_si256(_mm256_sllv_epi32(x, _mm256_set1_epi32(n)), \
+                    _mm256_srlv_epi32(x, _mm256_set1_epi32(32 - (n))))
+#define ROTL32_AVX2(x, n) _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - (n)))
+
+/// The same as md5MbLane, but over HASH_MB_AVX2_LANES keys starting from lane, and only up to
+/// MD5_EARLY_ROUND.
+/// \return A mask with bit j set if key lane + j passes the early check.
+static HASH_MB_AVX2_TARGET uint32_t md5MbAvx2(const uint32_t* keys, size_t key_count, size_t lane,
+                                              const uint32_t* tail, const HashMbTarget* target) {
+    const __m256i ones = _mm256_set1_epi32(-1);
+    __m256i w[16], a, b, c, d;
+
+    for (size_t i = 0; i < HASH_MB_KEY_WORDS; ++i) {
+        w[i] = _mm256_loadu_si256((const __m256i*)(keys + i * key_count + lane));
+        w[8 + i] = _mm256_set1_epi32((int)tail[i]);
+    }
+
+    a = _mm256_set1_epi32((int)md5_iv[0]), b = _mm256_set1_epi32((int)md5_iv[1]);
+    c = _mm256_set1_epi32((int)md5_iv[2]), d = _mm256_set1_epi32((int)md5_iv[3]);
+
+    for (int t = 0; t <= MD5_EARLY_ROUND; ++t) {
+        int group = t / 16, step = t % 16;
+        __m256i f;
+
+        switch (group) {
+            case 0:
+                f = _mm256_or_si256(_mm256_and_si256(b, c), _mm256_andnot_si256(b, d));
+                break;
+            case 1:
+                f = _mm256_or_si256(_mm256_and_si256(d, b), _mm256_andnot_si256(d, c));
+                break;
+            case 2:
+                f = _mm256_xor_si256(_mm256_xor_si256(b, c), d);
+                break;
+            default:
+                f = _mm256_xor_si256(c, _mm256_or_si256(b, _mm256_xor_si256(d, ones)));
+                break;
+        }
+
+        f = _mm256_add_epi32(_mm256_add_epi32(f, a), _mm256_set1_epi32((int)md5_k[t]));
+        f = _mm256_add_epi32(f, w[MD5_INDEX(group, step)]);
+        a = d, d = c, c = b;
+        b = _mm256_add_epi32(b, ROTLV32_AVX2(f, md5_shift[group][step % 4]));
+    }
+
+    b = _mm256_cmpeq_epi32(b, _mm256_set1_epi32((int)target->early));
+
+    return (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(b));
+}
+
+/// The same as sha1MbLane, but over HASH_MB_AVX2_LANES keys starting from lane, and only up to
+/// SHA1_EARLY_ROUND.
+/// \return A mask with bit j set if key lane + j passes the early check.
+static HASH_MB_AVX2_TARGET uint32_t sha1MbAvx2(const uint32_t* keys, size_t key_count,
+                                               size_t lane, const uint32_t* tail,
+                                               const HashMbTarget* target) {
+    const __m256i bswap = _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+                                          12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    __m256i w[16], a, b, c, d, e;
+
+    for (size_t i = 0; i < HASH_MB_KEY_WORDS; ++i) {
+        w[i] = _mm256_loadu_si256((const __m256i*)(keys + i * key_count + lane));
+        w[i] = _mm256_shuffle_epi8(w[i], bswap);
+        w[8 + i] = _mm256_set1_epi32((int)tail[i]);
+    }
+
+    a = _mm256_set1_epi32((int)sha1_iv[0]), b = _mm256_set1_epi32((int)sha1_iv[1]);
+    c = _mm256_set1_epi32((int)sha1_iv[2]), d = _mm256_set1_epi32((int)sha1_iv[3]);
+    e = _mm256_set1_epi32((int)sha1_iv[4]);
+
+    for (int t = 0; t <= SHA1_EARLY_ROUND; ++t) {
+        __m256i f;
+
+        if (t >= 16) {
+            f = _mm256_xor_si256(_mm256_xor_si256(w[(t - 3) & 15], w[(t - 8) & 15]),
+                                 _mm256_xor_si256(w[(t - 14) & 15], w[t & 15]));
+            w[t & 15] = ROTL32_AVX2(f, 1);
+        }
+
+        if (t < 20) {
+            f = _mm256_or_si256(_mm256_and_si256(b, c), _mm256_andnot_si256(b, d));
+        } else if (t < 40 || t >= 60) {
+            f = _mm256_xor_si256(_mm256_xor_si256(b, c), d);
+        } else {
+            f = _mm256_or_si256(_mm256_and_si256(b, c), _mm256_and_si256(d, _mm256_or_si256(b, c)));
+        }
+
+        f = _mm256_add_epi32(_mm256_add_epi32(f, ROTL32_AVX2(a, 5)), e);
+        f = _mm256_add_epi32(f, _mm256_add_epi32(_mm256_set1_epi32((int)sha1_k[t / 20]),
+                                                 w[t & 15]));
+        e = d, d = c, c = ROTL32_AVX2(b, 30), b = a, a = f;
+    }
+
+    a = _mm256_cmpeq_epi32(a, _mm256_set1_epi32((int)target->early));
+
+    return (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(a));
+}
+
+/// The same as md5MbAvx2, but over HASH_MB_AVX512_LANES keys.
+static HASH_MB_AVX512_TARGET uint32_t md5MbAvx512(const uint32_t* keys, size_t key_count,
+                                                  size_t lane, const uint32_t* tail,
+                                                  const HashMbTarget* target) {
+    __m512i w[16], a, b, c, d;
+
+    for (size_t i = 0; i < HASH_MB_KEY_WORDS; ++i) {
+        w[i] = _mm512_loadu_si512(keys + i * key_count + lane);
+        w[8 + i] = _mm512_set1_epi32((int)tail[i]);
+    }
+
+    a = _mm512_set1_epi32((int)md5_iv[0]), b = _mm512_set1_epi32((int)md5_iv[1]);
+    c = _mm512_set1_epi32((int)md5_iv[2]), d = _mm512_set1_epi32((int)md5_iv[3]);
+
+    for (int t = 0; t <= MD5_EARLY_ROUND; ++t) {
+        int group = t / 16, step = t % 16;
+        __m512i f;
+
+        switch (group) {
+            case 0:
+                f = CH_AVX512(b, c, d);
+                break;
+            case 1:
+                f = CH_AVX512(d, b, c);
+                break;
+            case 2:
+                f = XOR3_AVX512(b, c, d);
+                break;
+            default:
+                // c ^ (b | ~d)
+                f = _mm512_ternarylogic_epi32(b, c, d, 0x39);
+                break;
+        }
+
+        f = _mm512_add_epi32(_mm512_add_epi32(f, a), _mm512_set1_epi32((int)md5_k[t]));
+        f = _mm512_add_epi32(f, w[MD5_INDEX(group, step)]);
+        a = d, d = c, c = b;
+        f = _mm512_rolv_epi32(f, _mm512_set1_epi32(md5_shift[group][step % 4]));
+        b = _mm512_add_epi32(b, f);
+    }
+
+    return _mm512_cmpeq_epi32_mask(b, _mm512_set1_epi32((int)target->early));
+}
+
+/// The same as sha1MbAvx2, but over HASH_MB_AVX512_LANES keys.
+static HASH_MB_AVX512_TARGET uint32_t sha1MbAvx512(const uint32_t* keys, size_t key_count,
+                                                   size_t lane, const uint32_t* tail,
+                                                   const HashMbTarget* target) {
+    const __m512i byte_mask = _mm512_set1_epi32((int)0xff00ff00);
+    __m512i w[16], a, b, c, d, e;
+
+    for (size_t i = 0; i < HASH_MB_KEY_WORDS; ++i) {
+        w[i] = _mm512_loadu_si512(keys + i * key_count + lane);
+        w[i] = CH_AVX512(byte_mask, _mm512_ror_epi32(w[i], 8), _mm512_rol_epi32(w[i], 8));
+        w[8 + i] = _mm512_set1_epi32((int)tail[i]);
+    }
+
+    a = _mm512_set1_epi32((int)sha1_iv[0]), b = _mm512_set1_epi32((int)sha1_iv[1]);
+    c = _mm512_set1_epi32((int)sha1_iv[2]), d = _mm512_set1_epi32((int)sha1_iv[3]);
+    e = _mm512_set1_epi32((int)sha1_iv[4]);
+
+    for (int t = 0; t <= SHA1_EARLY_ROUND; ++t) {
+        __m512i f;
+
+        if (t >= 16) {
+            f = XOR3_AVX512(w[(t - 3) & 15], w[(t - 8) & 15], w[(t - 14) & 15]);
+            w[t & 15] = _mm512_rol_epi32(_mm512_xor_si512(f, w[t & 15]), 1);
+        }
+
+        if (t < 20) {
+            f = CH_AVX512(b, c, d);
+        } else if (t < 40 || t >= 60) {
+            f = XOR3_AVX512(b, c, d);
+        } else {
+            f = MAJ_AVX512(b, c, d);
+        }
+
+        f = _mm512_add_epi32(_mm512_add_epi32(f, _mm512_rol_epi32(a, 5)), e);
+        f = _mm512_add_epi32(f, _mm512_add_epi32(_mm512_set1_epi32((int)sha1_k[t / 20]),
+                                                 w[t & 15]));
+        e = d, d = c, c = _mm512_rol_epi32(b, 30), b = a, a = f;
+    }
+
+    return _mm512_cmpeq_epi32_mask(a, _mm512_set1_epi32((int)target->early));
+}
+#endif
+
+typedef int (*HashMbLaneFunc)(const uint32_t*, size_t, size_t, const uint32_t*,
+                              const HashMbTarget*);
+typedef uint32_t (*HashMbSimdFunc)(const uint32_t*, size_t, size_t, const uint32_t*,
+                                   const HashMbTarget*);
+
+/// The same as sha256MbMatchIv, but for any kernel that compares against the whole digest.
+/// Always inlined, so that the kernels are called directly.
+static inline __attribute__((always_inline)) uint32_t hashMbMatchTarget(
+        const uint32_t* keys, size_t key_count, const uint32_t* tail, const HashMbTarget* target,
+        HashMbLaneFunc lane_func, HashMbSimdFunc avx2_func, HashMbSimdFunc avx512_func) {
+    uint32_t matches = 0;
+    size_t lane = 0;
+
+    if (key_count > HASH_MB_MAX_KEYS) {
+        key_count = HASH_MB_MAX_KEYS;
+    }
+
+#ifdef RBC_HAVE_AVX512_TARGET
+    if (key_count >= HASH_MB_AVX512_LANES && cpuFeatures()->avx512f) {
+        for (; lane + HASH_MB_AVX512_LANES <= key_count; lane += HASH_MB_AVX512_LANES) {
+            matches |= avx512_func(keys, key_count, lane, tail, target) << lane;
+        }
+    }
+
+    if (key_count - lane >= HASH_MB_AVX2_LANES && cpuFeatures()->avx2) {
+        for (; lane + HASH_MB_AVX2_LANES <= key_count; lane += HASH_MB_AVX2_LANES) {
+            matches |= avx2_func(keys, key_count, lane, tail, target) << lane;
+        }
+    }
+
+    // The same as in sha256MbMatchIv
+    for (uint32_t candidates = matches; candidates != 0; candidates &= candidates - 1) {
+        size_t j = (size_t)__builtin_ctz(candidates);
+
+        if (!lane_func(keys, key_count, j, tail, target)) {
+            matches &= ~(UINT32_C(1) << j);
+        }
+    }
+#endif
+
+    // Finish off any remaining keys one at a time
+    for (; lane < key_count; ++lane) {
+        matches |= (uint32_t)lane_func(keys, key_count, lane, tail, target) << lane;
+    }
+
+    return matches;
+}
+
+// The AVX2 and AVX-512 kernels of a hash, if they were compiled in
+#ifdef RBC_HAVE_AVX512_TARGET
+#define HASH_MB_SIMD_KERNELS(name) name##MbAvx2, name##MbAvx512
+#else
+#define HASH_MB_SIMD_KERNELS(name) NULL, NULL
+#endif
+
+uint32_t md5MbMatch(const uint32_t* keys, size_t key_count, const uint32_t* tail,
+                    const HashMbTarget* target) {
+    return hashMbMatchTarget(keys, key_count, tail, target, md5MbLane,
+                             HASH_MB_SIMD_KERNELS(md5));
+}
+
+uint32_t sha1MbMatch(const uint32_t* keys, size_t key_count, const uint32_t* tail,
+                     const HashMbTarget* target) {
+    return hashMbMatchTarget(keys, key_count, tail, target, sha1MbLane,
+                             HASH_MB_SIMD_KERNELS(sha1));
+}
+
+static const uint64_t sha512_k[SHA512_ROUNDS] = {
+        UINT64_C(0x428a2f98d728ae22), UINT64_C(0x7137449123ef65cd), UINT64_C(0xb5c0fbcfec4d3b2f),
+        UINT64_C(0xe9b5dba58189dbbc), UINT64_C(0x3956c25bf348b538), UINT64_C(0x59f111f1b605d019),
+        UINT64_C(0x923f82a4af194f9b), UINT64_C(0xab1c5ed5da6d8118), UINT64_C(0xd807aa98a3030242),
+        UINT64_C(0x12835b0145706fbe), UINT64_C(0x243185be4ee4b28c), UINT64_C(0x550c7dc3d5ffb4e2),
+        UINT64_C(0x72be5d74f27b896f), UINT64_C(0x80deb1fe3b1696b1), UINT64_C(0x9bdc06a725c71235),
+        UINT64_C(0xc19bf174cf692694), UINT64_C(0xe49b69c19ef14ad2), UINT64_C(0xefbe4786384f25e3),
+        UINT64_C(0x0fc19dc68b8cd5b5), UINT64_C(0x240ca1cc77ac9c65), UINT64_C(0x2de92c6f592b0275),
+        UINT64_C(0x4a7484aa6ea6e483), UINT64_C(0x5cb0a9dcbd41fbd4), UINT64_C(0x76f988da831153b5),
+        UINT64_C(0x983e5152ee66dfab), UINT64_C(0xa831c66d2db43210), UINT64_C(0xb00327c898fb213f),
+        UINT64_C(0xbf597fc7beef0ee4), UINT64_C(0xc6e00bf33da88fc2), UINT64_C(0xd5a79147930aa725),
+        UINT64_C(0x06ca6351e003826f), UINT64_C(0x142929670a0e6e70), UINT64_C(0x27b70a8546d22ffc),
+        UINT64_C(0x2e1b21385c26c926), UINT64_C(0x4d2c6dfc5ac42aed), UINT64_C(0x53380d139d95b3df),
+        UINT64_C(0x650a73548baf63de), UINT64_C(0x766a0abb3c77b2a8), UINT64_C(0x81c2c92e47edaee6),
+        UINT64_C(0x92722c851482353b), UINT64_C(0xa2bfe8a14cf10364), UINT64_C(0xa81a664bbc423001),
+        UINT64_C(0xc24b8b70d0f89791), UINT64_C(0xc76c51a30654be30), UINT64_C(0xd192e819d6ef5218),
+        UINT64_C(0xd69906245565a910), UINT64_C(0xf40e35855771202a), UINT64_C(0x106aa07032bbd1b8),
+        UINT64_C(0x19a4c116b8d2d0c8), UINT64_C(0x1e376c085141ab53), UINT64_C(0x2748774cdf8eeb99),
+        UINT64_C(0x34b0bcb5e19b48a8), UINT64_C(0x391c0cb3c5c95a63), UINT64_C(0x4ed8aa4ae3418acb),
+        UINT64_C(0x5b9cca4f7763e373), UINT64_C(0x682e6ff3d6b2b8a3), UINT64_C(0x748f82ee5defb2fc),
+        UINT64_C(0x78a5636f43172f60), UINT64_C(0x84c87814a1f0ab72), UINT64_C(0x8cc702081a6439ec),
+        UINT64_C(0x90befffa23631e28), UINT64_C(0xa4506cebde82bde9), UINT64_C(0xbef9a3f7b2c67915),
+        UINT64_C(0xc67178f2e372532b), UINT64_C(0xca273eceea26619c), UINT64_C(0xd186b8c721c0c207),
+        UINT64_C(0xeada7dd6cde0eb1e), UINT64_C(0xf57d4f7fee6ed178), UINT64_C(0x06f067aa72176fba),
+        UINT64_C(0x0a637dc5a2c898a6), UINT64_C(0x113f9804bef90dae), UINT64_C(0x1b710b35131c471b),
+        UINT64_C(0x28db77f523047d84), UINT64_C(0x32caab7b40c72493), UINT64_C(0x3c9ebe0a15c9bebc),
+        UINT64_C(0x431d67c49c100d4c), UINT64_C(0x4cc5d4becb3e42b6), UINT64_C(0x597f299cfc657e2a),
+        UINT64_C(0x5fcb6fab3ad6faec), UINT64_C(0x6c44198c4a475817),
+};
+
+static const uint64_t sha512_iv[SHA512_STATE_WORDS] = {
+        UINT64_C(0x6a09e667f3bcc908), UINT64_C(0xbb67ae8584caa73b), UINT64_C(0x3c6ef372fe94f82b),
+        UINT64_C(0xa54ff53a5f1d36f1), UINT64_C(0x510e527fade682d1), UINT64_C(0x9b05688c2b3e6c1f),
+        UINT64_C(0x1f83d9abfb41bd6b), UINT64_C(0x5be0cd19137e2179),
+};
+
+static const uint64_t sha384_iv[SHA512_STATE_WORDS] = {
+        UINT64_C(0xcbbb9d5dc1059ed8), UINT64_C(0x629a292a367cd507), UINT64_C(0x9159015a3070dd17),
+        UINT64_C(0x152fecd8f70e5939), UINT64_C(0x67332667ffc00b31), UINT64_C(0x8eb44a8768581511),
+        UINT64_C(0xdb0c2e0d64f98fa7), UINT64_C(0x47b5481dbefa4fa4),
+};
+
+static inline uint64_t loadBe64(const unsigned char* bytes) {
+    return (uint64_t)loadBe32(bytes) << 32 | loadBe32(bytes + sizeof(uint32_t));
+}
+
+int sha512MbTail(uint64_t* tail, const unsigned char* salt, size_t salt_size) {
+    unsigned char bytes[SHA512_MB_TAIL_WORDS * sizeof(uint64_t)] = {0};
+    uint64_t bit_length = (HASH_MB_KEY_SIZE + salt_size) * 8;
+
+    if (salt_size > SHA512_MB_MAX_SALT_SIZE || (salt == NULL && salt_size != 0)) {
+        return 1;
+    }
+
+    if (salt_size > 0) {
+        memcpy(bytes, salt, salt_size);
+    }
+    bytes[salt_size] = 0x80;
+
+    // The message length in bits ends the block as a big-endian 128-bit integer, whose upper half
+    // is always zero here
+    for (size_t i = 0; i < sizeof(bit_length); ++i) {
+        bytes[sizeof(bytes) - 1 - i] = (unsigned char)(bit_length >> (i * 8));
+    }
+
+    for (size_t i = 0; i < SHA512_MB_TAIL_WORDS; ++i) {
+        tail[i] = loadBe64(bytes + i * sizeof(uint64_t));
+    }
+
+    return 0;
+}
+
+#define ROTR64(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+
+/// The plain C fallback of SHA-512, for a single key.
+/// \return Returns 1 if the key's digest matches the first target_words of target, or 0 if not.
+static int sha512MbLane(const uint64_t* keys, size_t key_count, size_t lane, const uint64_t* tail,
+                        const uint64_t* iv, const uint64_t* target, size_t target_words) {
+    uint64_t w[16], a, b, c, d, e, f, g, h;
+    uint64_t state[SHA512_STATE_WORDS];
+
+    for (size_t i = 0; i < HASH_MB_KEY_SIZE / sizeof(uint64_t); ++i) {
+        w[i] = __builtin_bswap64(keys[i * key_count + lane]);
+    }
+    for (size_t i = 0; i < SHA512_MB_TAIL_WORDS; ++i) {
+        w[HASH_MB_KEY_SIZE / sizeof(uint64_t) + i] = tail[i];
+    }
+
+    a = iv[0], b = iv[1], c = iv[2], d = iv[3], e = iv[4], f = iv[5], g = iv[6], h = iv[7];
+
+    for (int t = 0; t < SHA512_ROUNDS; ++t) {
+        uint64_t t1, t2;
+
+        if (t >= 16) {
+            uint64_t w2 = w[(t - 2) & 15], w15 = w[(t - 15) & 15];
+
+            w[t & 15] += (ROTR64(w2, 19) ^ ROTR64(w2, 61) ^ (w2 >> 6)) + w[(t - 7) & 15] +
+                         (ROTR64(w15, 1) ^ ROTR64(w15, 8) ^ (w15 >> 7));
+        }
+
+        t1 = h + (ROTR64(e, 14) ^ ROTR64(e, 18) ^ ROTR64(e, 41)) + ((e & f) ^ (~e & g)) +
+             sha512_k[t] + w[t & 15];
+        t2 = (ROTR64(a, 28) ^ ROTR64(a, 34) ^ ROTR64(a, 39)) + ((a & b) ^ (a & c) ^ (b & c));
+
+        h = g, g = f, f = e, e = d + t1, d = c, c = b, b = a, a = t1 + t2;
+    }
+
+    state[0] = a, state[1] = b, state[2] = c, state[3] = d;
+    state[4] = e, state[5] = f, state[6] = g, state[7] = h;
+
+    for (size_t i = 0; i < target_words; ++i) {
+        if (state[i] + iv[i] != target[i]) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+#ifdef RBC_HAVE_AVX512_TARGET
+#define ROTR64_AVX2(x, n) _mm256_or_si256(_mm256_srli_epi64(x, n), _mm256_slli_epi64(x, 64 - (n)))
+
+/// The same as sha512MbLane, but over SHA512_MB_AVX2_LANES keys starting from lane.
+/// \return A mask with bit j set if key lane + j matches.
+static HASH_MB_AVX2_TARGET uint32_t sha512MbAvx2(const uint64_t* keys, size_t key_count,
+                                                 size_t lane, const uint64_t* tail,
+                                                 const uint64_t* iv, const uint64_t* target,
+                                                 size_t target_words) {
+    const __m256i bswap = _mm256_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7,
+                                          8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i w[16], a, b, c, d, e, f, g, h;
+    __m256i state[SHA512_STATE_WORDS];
+    uint32_t matches = (1u << SHA512_MB_AVX2_LANES) - 1;
+
+    for (size_t i = 0; i < HASH_MB_KEY_SIZE / sizeof(uint64_t); ++i) {
+        w[i] = _mm256_loadu_si256((const __m256i*)(keys + i * key_count + lane));
+        w[i] = _mm256_shuffle_epi8(w[i], bswap);
+    }
+    for (size_t i = 0; i < SHA512_MB_TAIL_WORDS; ++i) {
+        w[HASH_MB_KEY_SIZE / sizeof(uint64_t) + i] = _mm256_set1_epi64x((long long)tail[i]);
+    }
+
+    a = _mm256_set1_epi64x((long long)iv[0]), b = _mm256_set1_epi64x((long long)iv[1]);
+    c = _mm256_set1_epi64x((long long)iv[2]), d = _mm256_set1_epi64x((long long)iv[3]);
+    e = _mm256_set1_epi64x((long long)iv[4]), f = _mm256_set1_epi64x((long long)iv[5]);
+    g = _mm256_set1_epi64x((long long)iv[6]), h = _mm256_set1_epi64x((long long)iv[7]);
+
+    for (int t = 0; t < SHA512_ROUNDS; ++t) {
+        __m256i t1, t2;
+
+        if (t >= 16) {
+            __m256i w2 = w[(t - 2) & 15], w15 = w[(t - 15) & 15];
+            __m256i s0 = _mm256_xor_si256(ROTR64_AVX2(w15, 1), ROTR64_AVX2(w15, 8));
+            __m256i s1 = _mm256_xor_si256(ROTR64_AVX2(w2, 19), ROTR64_AVX2(w2, 61));
+
+            s0 = _mm256_xor_si256(s0, _mm256_srli_epi64(w15, 7));
+            s1 = _mm256_xor_si256(s1, _mm256_srli_epi64(w2, 6));
+
+            w[t & 15] = _mm256_add_epi64(_mm256_add_epi64(w[t & 15], s0),
+                                         _mm256_add_epi64(w[(t - 7) & 15], s1));
+        }
+
+        t1 = _mm256_xor_si256(_mm256_xor_si256(ROTR64_AVX2(e, 14), ROTR64_AVX2(e, 18)),
+                              ROTR64_AVX2(e, 41));
+        t1 = _mm256_add_epi64(_mm256_add_epi64(h, t1),
+                              _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g)));
+        t1 = _mm256_add_epi64(
+                t1, _mm256_add_epi64(_mm256_set1_epi64x((long long)sha512_k[t]), w[t & 15]));
+
+        t2 = _mm256_xor_si256(_mm256_xor_si256(ROTR64_AVX2(a, 28), ROTR64_AVX2(a, 34)),
+                              ROTR64_AVX2(a, 39));
+        t2 = _mm256_add_epi64(t2, _mm256_or_si256(_mm256_and_si256(a, b),
+                                                  _mm256_and_si256(c, _mm256_or_si256(a, b))));
+
+        h = g, g = f, f = e, e = _mm256_add_epi64(d, t1), d = c, c = b, b = a;
+        a = _mm256_add_epi64(t1, t2);
+    }
+
+    state[0] = a, state[1] = b, state[2] = c, state[3] = d;
+    state[4] = e, state[5] = f, state[6] = g, state[7] = h;
+
+    for (size_t i = 0; i < target_words; ++i) {
+        __m256i digest = _mm256_add_epi64(state[i], _mm256_set1_epi64x((long long)iv[i]));
+        __m256i equal = _mm256_cmpeq_epi64(digest, _mm256_set1_epi64x((long long)target[i]));
+
+        matches &= (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(equal));
+    }
+
+    return matches;
+}
+
+// The bitwise CH_AVX512, MAJ_AVX512, and XOR3_AVX512 work just as well on 64-bit words
+/// The same as sha512MbLane, but over SHA512_MB_AVX512_LANES keys starting from lane.
+/// \return A mask with bit j set if key lane + j matches.
+static HASH_MB_AVX512_TARGET uint32_t sha512MbAvx512(const uint64_t* keys, size_t key_count,
+                                                     size_t lane, const uint64_t* tail,
+                                                     const uint64_t* iv, const uint64_t* target,
+                                                     size_t target_words) {
+    // Byte swap each half as in sha256MbAvx512, then swap the halves
+    const __m512i byte_mask = _mm512_set1_epi32((int)0xff00ff00);
+    __m512i w[16], a, b, c, d, e, f, g, h;
+    __m512i state[SHA512_STATE_WORDS];
+    __mmask8 matches = 0xff;
+
+    for (size_t i = 0; i < HASH_MB_KEY_SIZE / sizeof(uint64_t); ++i) {
+        w[i] = _mm512_loadu_si512(keys + i * key_count + lane);
+        w[i] = CH_AVX512(byte_mask, _mm512_ror_epi32(w[i], 8), _mm512_rol_epi32(w[i], 8));
+        w[i] = _mm512_ror_epi64(w[i], 32);
+    }
+    for (size_t i = 0; i < SHA512_MB_TAIL_WORDS; ++i) {
+        w[HASH_MB_KEY_SIZE / sizeof(uint64_t) + i] = _mm512_set1_epi64((long long)tail[i]);
+    }
+
+    a = _mm512_set1_epi64((long long)iv[0]), b = _mm512_set1_epi64((long long)iv[1]);
+    c = _mm512_set1_epi64((long long)iv[2]), d = _mm512_set1_epi64((long long)iv[3]);
+    e = _mm512_set1_epi64((long long)iv[4]), f = _mm512_set1_epi64((long long)iv[5]);
+    g = _mm512_set1_epi64((long long)iv[6]), h = _mm512_set1_epi64((long long)iv[7]);
+
+    for (int t = 0; t < SHA512_ROUNDS; ++t) {
+        __m512i t1, t2;
+
+        if (t >= 16) {
+            __m512i w2 = w[(t - 2) & 15], w15 = w[(t - 15) & 15];
+            __m512i s0 = XOR3_AVX512(_mm512_ror_epi64(w15, 1), _mm512_ror_epi64(w15, 8),
+                                     _mm512_srli_epi64(w15, 7));
+            __m512i s1 = XOR3_AVX512(_mm512_ror_epi64(w2, 19), _mm512_ror_epi64(w2, 61),
+                                     _mm512_srli_epi64(w2, 6));
+
+            w[t & 15] = _mm512_add_epi64(_mm512_add_epi64(w[t & 15], s0),
+                                         _mm512_add_epi64(w[(t - 7) & 15], s1));
+        }
+
+        t1 = XOR3_AVX512(_mm512_ror_epi64(e, 14), _mm512_ror_epi64(e, 18), _mm512_ror_epi64(e, 41));
+        t1 = _mm512_add_epi64(_mm512_add_epi64(h, t1), CH_AVX512(e, f, g));
+        t1 = _mm512_add_epi64(
+                t1, _mm512_add_epi64(_mm512_set1_epi64((long long)sha512_k[t]), w[t & 15]));
+
+        t2 = XOR3_AVX512(_mm512_ror_epi64(a, 28), _mm512_ror_epi64(a, 34), _mm512_ror_epi64(a, 39));
+        t2 = _mm512_add_epi64(t2, MAJ_AVX512(a, b, c));
+
+        h = g, g = f, f = e, e = _mm512_add_epi64(d, t1), d = c, c = b, b = a;
+        a = _mm512_add_epi64(t1, t2);
+    }
+
+    state[0] = a, state[1] = b, state[2] = c, state[3] = d;
+    state[4] = e, state[5] = f, state[6] = g, state[7] = h;
+
+    for (size_t i = 0; i < target_words; ++i) {
+        __m512i digest = _mm512_add_epi64(state[i], _mm512_set1_epi64((long long)iv[i]));
+
+        matches &= _mm512_cmpeq_epi64_mask(digest, _mm512_set1_epi64((long long)target[i]));
+    }
+
+    return matches;
+}
+#endif
+
+/// The same as sha256MbMatchIv, but for SHA-512 over 64-bit words.
+static uint32_t sha512MbMatchIv(const uint64_t* keys, size_t key_count, const uint64_t* tail,
+                                const uint64_t* iv, const unsigned char* digest,
+                                size_t digest_words) {
+    uint64_t target[SHA512_STATE_WORDS];
+    uint32_t matches = 0;
+    size_t lane = 0;
+
+    if (key_count > HASH_MB_MAX_KEYS) {
+        key_count = HASH_MB_MAX_KEYS;
+    }
+
+    for (size_t i = 0; i < digest_words; ++i) {
+        target[i] = loadBe64(digest + i * sizeof(uint64_t));
+    }
+
+#ifdef RBC_HAVE_AVX512_TARGET
+    if (key_count >= SHA512_MB_AVX512_LANES && cpuFeatures()->avx512f) {
+        for (; lane + SHA512_MB_AVX512_LANES <= key_count; lane += SHA512_MB_AVX512_LANES) {
+            matches |= sha512MbAvx512(keys, key_count, lane, tail, iv, target, digest_words)
+                       << lane;
+        }
+    }
+
+    if (key_count - lane >= SHA512_MB_AVX2_LANES && cpuFeatures()->avx2) {
+        for (; lane + SHA512_MB_AVX2_LANES <= key_count; lane += SHA512_MB_AVX2_LANES) {
+            matches |= sha512MbAvx2(keys, key_count, lane, tail, iv, target, digest_words) << lane;
+        }
+    }
+#endif
+
+    // Finish off any remaining keys one at a time
+    for (; lane < key_count; ++lane) {
+        matches |= (uint32_t)sha512MbLane(keys, key_count, lane, tail, iv, target, digest_words)
+                   << lane;
+    }
+
+    return matches;
+}
+
+uint32_t sha512MbMatch(const uint64_t* keys, size_t key_count, const uint64_t* tail,
+                       const unsigned char* digest) {
+    return sha512MbMatchIv(keys, key_count, tail, sha512_iv, digest, SHA512_STATE_WORDS);
+}
+
+uint32_t sha384MbMatch(const uint64_t* keys, size_t key_count, const uint64_t* tail,
+                       const unsigned char* digest) {
+    return sha512MbMatchIv(keys, key_count, tail, sha384_iv, digest, SHA384_DIGEST_WORDS);
+}
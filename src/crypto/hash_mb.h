@@ -0,0 +1,163 @@
+#ifndef RBC_VALIDATOR_CRYPTO_HASH_MB_H_
+#define RBC_VALIDATOR_CRYPTO_HASH_MB_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Multi-buffer hash kernels, which hash many 32-byte keys at once, one per SIMD lane. Each key
+// along with any salt and the padding must fit in a single block, so the rest of the block after
+// the key (the tail) is the same across every lane and is built once ahead of time.
+
+// How many keys each kernel works on at once
+#define HASH_MB_AVX2_LANES 8
+#define HASH_MB_AVX512_LANES 16
+// The most keys a single call can match, one per bit of the returned mask
+#define HASH_MB_MAX_KEYS 32
+
+// How many keys the SHA-NI kernels interleave at once
+#define SHA_NI_LANES 2
+
+#define HASH_MB_KEY_SIZE 32
+#define HASH_MB_KEY_WORDS (HASH_MB_KEY_SIZE / sizeof(uint32_t))
+// The largest state of the 32-bit hashes, which is SHA-256's
+#define HASH_MB_MAX_STATE_WORDS 8
+#define SHA256_MB_TAIL_WORDS 8
+// The message words after the first 16 that still take some of their terms from the tail
+#define SHA256_MB_TAIL_SCHEDULE_WORDS 16
+// The largest salt that still fits in the block, leaving room for the 0x80 byte and the length
+#define SHA256_MB_MAX_SALT_SIZE (64 - HASH_MB_KEY_SIZE - 1 - 8)
+// SHA-384/SHA-512 work on 64-bit words instead, in a 128 byte block ending in a 128-bit length
+#define SHA512_MB_AVX2_LANES 4
+#define SHA512_MB_AVX512_LANES 8
+#define SHA512_MB_TAIL_WORDS 12
+#define SHA512_MB_MAX_SALT_SIZE (128 - HASH_MB_KEY_SIZE - 1 - 16)
+// MD5 pads its 64 byte block the same way as SHA-256
+#define MD5_MB_TAIL_WORDS SHA256_MB_TAIL_WORDS
+#define MD5_MB_MAX_SALT_SIZE SHA256_MB_MAX_SALT_SIZE
+
+/// The digest a search compares against for one of the 32-bit multi-buffer kernels. The last few
+/// rounds of each hash can be undone from the digest alone, which gives away the word a matching
+/// key computes a few rounds early, so the kernels can reject almost every key without running the
+/// rest. Only built once per search, as it only depends on the digest and tail.
+typedef struct HashMbTarget {
+    // The digest as the hash's state words
+    uint32_t words[HASH_MB_MAX_STATE_WORDS];
+    size_t word_count;
+    // The word round early_round computes (a for SHA, b for MD5) if the key matches
+    uint32_t early;
+    int early_round;
+    // SHA-224/SHA-256 only: the tail's words with their round constants already added, and the
+    // sum of the terms of message words 16 to 31 that only come from the tail, so that the
+    // kernels only compute the terms that come from the key
+    uint32_t tail_k[SHA256_MB_TAIL_WORDS];
+    uint32_t tail_schedule[SHA256_MB_TAIL_SCHEDULE_WORDS];
+} HashMbTarget;
+
+/// Build the tail of a SHA-1/SHA-224/SHA-256 block holding a key followed by a salt. SHA-1 pads
+/// the same way as SHA-2.
+/// \param tail The output SHA256_MB_TAIL_WORDS message words after the key.
+/// \param salt An optional salt that follows the key. NULL if there is none.
+/// \param salt_size How big the salt is, up to SHA256_MB_MAX_SALT_SIZE.
+/// \return Returns 0 on success, or 1 if the salt doesn't fit.
+int sha256MbTail(uint32_t* tail, const unsigned char* salt, size_t salt_size);
+
+/// Work back from a SHA-256 digest to the target sha256MbMatch compares against.
+/// \param target The output target.
+/// \param tail The rest of the block as filled by sha256MbTail, whose part of the message schedule
+/// the target computes ahead of time. SHA-1 doesn't need it, but every hash takes it so that their
+/// targets are all built the same way.
+/// \param digest The 32 byte digest to compare against.
+void sha256MbTarget(HashMbTarget* target, const uint32_t* tail, const unsigned char* digest);
+
+/// The same as sha256MbTarget, but for a 28 byte SHA-224 digest.
+void sha224MbTarget(HashMbTarget* target, const uint32_t* tail, const unsigned char* digest);
+
+/// The same as sha256MbTarget, but for a 20 byte SHA-1 digest.
+void sha1MbTarget(HashMbTarget* target, const uint32_t* tail, const unsigned char* digest);
+
+/// Hash several keys using SHA-256 and compare each digest against a target, using AVX-512 or
+/// AVX2 if the CPU supports it and plain C otherwise. Only keys that pass the target's early check
+/// run the last rounds and have their whole digest compared.
+/// \param keys key_count keys of HASH_MB_KEY_SIZE bytes laid out such that 32-bit word i of key j
+/// is at keys[i * key_count + j] (SEED_LAYOUT_SOA32).
+/// \param key_count How many keys to hash, up to HASH_MB_MAX_KEYS.
+/// \param tail The rest of the block as filled by sha256MbTail.
+/// \param target The digest to compare against as filled by sha256MbTarget from the same tail.
+/// \return A mask with bit j set if key j's digest matches.
+uint32_t sha256MbMatch(const uint32_t* keys, size_t key_count, const uint32_t* tail,
+                       const HashMbTarget* target);
+
+/// The same as sha256MbMatch, but using SHA-224 and a target filled by sha224MbTarget.
+uint32_t sha224MbMatch(const uint32_t* keys, size_t key_count, const uint32_t* tail,
+                       const HashMbTarget* target);
+
+/// The same as sha256MbMatch, but using SHA-1 and a target filled by sha1MbTarget.
+uint32_t sha1MbMatch(const uint32_t* keys, size_t key_count, const uint32_t* tail,
+                     const HashMbTarget* target);
+
+/// Build the tail of an MD5 block holding a key followed by a salt, which differs from SHA only in
+/// being little-endian.
+/// \param tail The output MD5_MB_TAIL_WORDS message words after the key.
+/// \param salt An optional salt that follows the key. NULL if there is none.
+/// \param salt_size How big the salt is, up to MD5_MB_MAX_SALT_SIZE.
+/// \return Returns 0 on success, or 1 if the salt doesn't fit.
+int md5MbTail(uint32_t* tail, const unsigned char* salt, size_t salt_size);
+
+/// The same as sha256MbTarget, but for a 16 byte MD5 digest and a tail filled by md5MbTail.
+void md5MbTarget(HashMbTarget* target, const uint32_t* tail, const unsigned char* digest);
+
+/// The same as sha256MbMatch, but using MD5 with a tail filled by md5MbTail and a target filled by
+/// md5MbTarget.
+uint32_t md5MbMatch(const uint32_t* keys, size_t key_count, const uint32_t* tail,
+                    const HashMbTarget* target);
+
+/// Build the tail of a SHA-384/SHA-512 block holding a key followed by a salt.
+/// \param tail The output SHA512_MB_TAIL_WORDS message words after the key.
+/// \param salt An optional salt that follows the key. NULL if there is none.
+/// \param salt_size How big the salt is, up to SHA512_MB_MAX_SALT_SIZE.
+/// \return Returns 0 on success, or 1 if the salt doesn't fit.
+int sha512MbTail(uint64_t* tail, const unsigned char* salt, size_t salt_size);
+
+/// Hash several keys using SHA-512 and compare each digest against a target, using AVX-512 or
+/// AVX2 if the CPU supports it and plain C otherwise.
+/// \param keys key_count keys of HASH_MB_KEY_SIZE bytes laid out such that 64-bit word i of key j
+/// is at keys[i * key_count + j] (SEED_LAYOUT_SOA64).
+/// \param key_count How many keys to hash, up to HASH_MB_MAX_KEYS.
+/// \param tail The rest of the block as filled by sha512MbTail.
+/// \param digest The 64 byte digest to compare against.
+/// \return A mask with bit j set if key j's digest matches.
+uint32_t sha512MbMatch(const uint64_t* keys, size_t key_count, const uint64_t* tail,
+                       const unsigned char* digest);
+
+/// The same as sha512MbMatch, but using SHA-384 and comparing against a 48 byte digest.
+uint32_t sha384MbMatch(const uint64_t* keys, size_t key_count, const uint64_t* tail,
+                       const unsigned char* digest);
+
+/// Check whether the CPU supports the SHA extensions, which the *NiMatch kernels need.
+/// \return Returns 1 if so, or 0 otherwise.
+int hashMbHasShaNi(void);
+
+/// Check whether the CPU supports AVX-512, which lets the *MbMatch kernels work on
+/// HASH_MB_AVX512_LANES keys at once.
+/// \return Returns 1 if so, or 0 otherwise.
+int hashMbHasAvx512(void);
+
+/// Hash several keys using SHA-256 with the SHA extensions and compare each digest against a
+/// target, interleaving SHA_NI_LANES keys at a time. Only call it if hashMbHasShaNi.
+/// \param keys key_count keys of HASH_MB_KEY_SIZE bytes each, back to back (SEED_LAYOUT_AOS).
+/// \param key_count How many keys to hash, up to HASH_MB_MAX_KEYS.
+/// \param tail The rest of the block as filled by sha256MbTail.
+/// \param digest The 32 byte digest to compare against.
+/// \return A mask with bit j set if key j's digest matches.
+uint32_t sha256NiMatch(const unsigned char* keys, size_t key_count, const uint32_t* tail,
+                       const unsigned char* digest);
+
+/// The same as sha256NiMatch, but using SHA-224 and comparing against a 28 byte digest.
+uint32_t sha224NiMatch(const unsigned char* keys, size_t key_count, const uint32_t* tail,
+                       const unsigned char* digest);
+
+/// The same as sha256NiMatch, but using SHA-1 and comparing against a 20 byte digest.
+uint32_t sha1NiMatch(const unsigned char* keys, size_t key_count, const uint32_t* tail,
+                     const unsigned char* digest);
+
+#endif  // RBC_VALIDATOR_CRYPTO_HASH_MB_H_
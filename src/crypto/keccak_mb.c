@@ -0,0 +1,372 @@
+#include "keccak_mb.h"
+
+#include <XKCP/KeccakP-1600-times4-SnP.h>
+#include <XKCP/KeccakP-1600-times8-SnP.h>
+#include <stdalign.h>
+#include <string.h>
+
+#include "cpu_features.h"
+
+#ifdef RBC_HAVE_AVX512_TARGET
+#include <immintrin.h>
+
+#define KECCAK_MB_AVX2_TARGET   __attribute__((target("avx2")))
+#define KECCAK_MB_AVX512_TARGET __attribute__((target("avx512f")))
+#endif
+
+// Use Keccak-p[1600]×8 only if the XKCP target has a native implementation of it, since its
+// fallbacks just run Keccak-p[1600]×4 twice anyway
+#ifndef KeccakP1600times8_isFallback
+#define KECCAK_MB_LANES 8
+#define KECCAK_MB_SNP(func) KeccakP1600times8_##func
+#else
+#define KECCAK_MB_LANES 4
+#define KECCAK_MB_SNP(func) KeccakP1600times4_##func
+#endif
+
+#define KECCAK_MB_KEY_LANES (KECCAK_MB_KEY_SIZE / sizeof(uint64_t))
+// Pad the states up to a whole cache line in case the SnP needs less alignment than that
+#define KECCAK_MB_STATES_ALIGN 64
+
+#define KECCAK_ROUNDS 24
+// KangarooTwelve runs the last 12 rounds of Keccak-f[1600]
+#define KANG12_FIRST_ROUND (KECCAK_ROUNDS - 12)
+
+int keccakMbTail(uint64_t* tail, size_t rate, unsigned char suffix, const unsigned char* salt,
+                 size_t salt_size) {
+    unsigned char bytes[KECCAK_MB_TAIL_LANES * sizeof(uint64_t)] = {0};
+    size_t tail_size;
+
+    if (rate > SHAKE128_RATE || rate % sizeof(uint64_t) || rate <= KECCAK_MB_KEY_SIZE ||
+        salt_size > KECCAK_MB_MAX_SALT_SIZE(rate)) {
+        return 1;
+    }
+
+    tail_size = rate - KECCAK_MB_KEY_SIZE;
+
+    if (salt != NULL && salt_size > 0) {
+        memcpy(bytes, salt, salt_size);
+    }
+
+    // The suffix and the final padding bit share a byte if the salt fills the block
+    bytes[salt_size] = suffix;
+    bytes[tail_size - 1] |= 0x80;
+
+    memcpy(tail, bytes, tail_size);
+
+    return 0;
+}
+
+int keccakMbTarget(KeccakMbTarget* target, const uint64_t* tail, size_t rate,
+                   const unsigned char* digest, size_t digest_size) {
+    size_t rate_lanes = rate / sizeof(uint64_t);
+
+    if (rate > SHAKE128_RATE || rate % sizeof(uint64_t) || rate <= KECCAK_MB_KEY_SIZE ||
+        digest_size > rate) {
+        return 1;
+    }
+
+    // The block is absorbed into a zeroed state, so its lanes are the state's
+    memset(target->state, 0, sizeof(target->state));
+    memcpy(target->state + KECCAK_MB_KEY_LANES, tail,
+           (rate_lanes - KECCAK_MB_KEY_LANES) * sizeof(uint64_t));
+
+    for (size_t x = 0; x < 5; ++x) {
+        target->parities[x] = target->state[x] ^ target->state[x + 5] ^ target->state[x + 10] ^
+                              target->state[x + 15] ^ target->state[x + 20];
+    }
+
+    memset(target->digest, 0, sizeof(target->digest));
+    if (digest_size > 0) {
+        memcpy(target->digest, digest, digest_size);
+    }
+
+    target->digest_size = digest_size;
+    target->rate = rate;
+
+    return 0;
+}
+
+typedef void (*KeccakMbPermute)(void*);
+
+/// The XKCP fallback, which fills whole groups of KECCAK_MB_LANES states and compares their
+/// digests in full.
+static inline __attribute__((always_inline)) uint32_t keccakMbSnpMatch(
+        const unsigned char* keys, size_t key_count, const KeccakMbTarget* target,
+        KeccakMbPermute permute) {
+    alignas(KECCAK_MB_STATES_ALIGN) unsigned char states[KECCAK_MB_SNP(statesSizeInBytes)];
+    uint64_t blocks[KECCAK_MB_LANES * KECCAK_MB_RATE_LANES];
+    uint64_t digests[KECCAK_MB_LANES * KECCAK_MB_RATE_LANES];
+    size_t rate_lanes = target->rate / sizeof(uint64_t);
+    size_t digest_lanes = (target->digest_size + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    uint32_t matches = 0;
+
+    // Every state's block ends in the same tail, so only the keys need to be copied in per group
+    for (size_t i = 0; i < KECCAK_MB_LANES; ++i) {
+        memcpy(blocks + i * rate_lanes + KECCAK_MB_KEY_LANES,
+               target->state + KECCAK_MB_KEY_LANES,
+               (rate_lanes - KECCAK_MB_KEY_LANES) * sizeof(uint64_t));
+    }
+
+    for (size_t lane = 0; lane < key_count; lane += KECCAK_MB_LANES) {
+        for (size_t i = 0; i < KECCAK_MB_LANES; ++i) {
+            // Repeat the last key in any states past the end, whose results are then ignored
+            size_t key = lane + i < key_count ? lane + i : key_count - 1;
+
+            memcpy(blocks + i * rate_lanes, keys + key * KECCAK_MB_KEY_SIZE, KECCAK_MB_KEY_SIZE);
+        }
+
+        KECCAK_MB_SNP(InitializeAll)(states);
+        KECCAK_MB_SNP(AddLanesAll)(states, (const unsigned char*)blocks, (unsigned int)rate_lanes,
+                                   (unsigned int)rate_lanes);
+        permute(states);
+        KECCAK_MB_SNP(ExtractLanesAll)(states, (unsigned char*)digests,
+                                       (unsigned int)digest_lanes, (unsigned int)digest_lanes);
+
+        for (size_t i = 0; i < KECCAK_MB_LANES && lane + i < key_count; ++i) {
+            if (memcmp(digests + i * digest_lanes, target->digest, target->digest_size) == 0) {
+                matches |= UINT32_C(1) << (lane + i);
+            }
+        }
+    }
+
+    return matches;
+}
+
+#ifdef RBC_HAVE_AVX512_TARGET
+static const uint64_t keccak_rc[KECCAK_ROUNDS] = {
+        0x0000000000000001, 0x0000000000008082, 0x800000000000808a, 0x8000000080008000,
+        0x000000000000808b, 0x0000000080000001, 0x8000000080008081, 0x8000000000008009,
+        0x000000000000008a, 0x0000000000000088, 0x0000000080008009, 0x000000008000000a,
+        0x000000008000808b, 0x800000000000008b, 0x8000000000008089, 0x8000000000008003,
+        0x8000000000008002, 0x8000000000000080, 0x000000000000800a, 0x800000008000000a,
+        0x8000000080008081, 0x8000000000008080, 0x0000000080000001, 0x8000000080008008,
+};
+
+// How far rho rotates lane x + 5y, and where pi moves it to
+static const int keccak_rho[KECCAK_MB_STATE_LANES] = {
+        0,  1,  62, 28, 27, 36, 44, 6,  55, 20, 3,  10, 43,
+        25, 39, 41, 45, 15, 21, 8,  18, 2,  61, 56, 14,
+};
+static const int keccak_pi[KECCAK_MB_STATE_LANES] = {
+        0,  10, 20, 5,  15, 16, 1,  11, 21, 6,  7,  17, 2,
+        12, 22, 23, 8,  18, 3,  13, 14, 24, 9,  19, 4,
+};
+
+// The column parities c of the lanes a, which theta mixes into every lane of the next round
+#define KECCAK_MB_PARITIES(XOR5, a, c)                                    \
+    do {                                                                  \
+        for (size_t x = 0; x < 5; ++x) {                                  \
+            c[x] = XOR5(a[x], a[x + 5], a[x + 10], a[x + 15], a[x + 20]); \
+        }                                                                 \
+    } while (0)
+
+// Run theta, rho, pi, and chi on the lanes a of type T given their column parities c, using vector
+// operations for x ^ y, x rotated left by n, and x ^ (~y & z)
+#define KECCAK_MB_ROUND(T, XOR, ROL, CHI, a, c)                                   \
+    do {                                                                          \
+        T d[5], b[KECCAK_MB_STATE_LANES];                                         \
+                                                                                  \
+        for (size_t x = 0; x < 5; ++x) {                                          \
+            d[x] = XOR(c[(x + 4) % 5], ROL(c[(x + 1) % 5], 1));                   \
+        }                                                                         \
+        for (size_t i = 0; i < KECCAK_MB_STATE_LANES; ++i) {                      \
+            b[keccak_pi[i]] = ROL(XOR(a[i], d[i % 5]), keccak_rho[i]);            \
+        }                                                                         \
+        for (size_t y = 0; y < KECCAK_MB_STATE_LANES; y += 5) {                   \
+            for (size_t x = 0; x < 5; ++x) {                                      \
+                a[y + x] = CHI(b[y + x], b[y + (x + 1) % 5], b[y + (x + 2) % 5]); \
+            }                                                                     \
+        }                                                                         \
+    } while (0)
+
+// The first lane of the last round, which is all that's needed to rule out almost every key. Pi
+// moves lanes 0, 6, and 12 to the first three lanes of the first row, which chi combines into it.
+#define KECCAK_MB_FIRST_LANE(XOR, ROL, CHI, a, c)               \
+    CHI(XOR(a[0], XOR(c[4], ROL(c[1], 1))),                     \
+        ROL(XOR(a[6], XOR(c[0], ROL(c[2], 1))), keccak_rho[6]), \
+        ROL(XOR(a[12], XOR(c[1], ROL(c[3], 1))), keccak_rho[12]))
+
+#define XOR_AVX2(x, y) _mm256_xor_si256(x, y)
+#define XOR5_AVX2(v, w, x, y, z) \
+    _mm256_xor_si256(_mm256_xor_si256(_mm256_xor_si256(v, w), _mm256_xor_si256(x, y)), z)
+#define ROL_AVX2(x, n)                                           \
+    _mm256_or_si256(_mm256_sllv_epi64(x, _mm256_set1_epi64x(n)), \
+                    _mm256_srlv_epi64(x, _mm256_set1_epi64x(64 - (n))))
+#define CHI_AVX2(x, y, z) _mm256_xor_si256(x, _mm256_andnot_si256(y, z))
+
+/// Hash KECCAK_MB_AVX2_LANES keys starting from lane, running the rounds from first_round on, and
+/// compare the first lane of each digest.
+/// \return A mask with bit j set if key lane + j may match.
+static KECCAK_MB_AVX2_TARGET uint32_t keccakMbAvx2(const unsigned char* keys, size_t lane,
+                                                   const KeccakMbTarget* target, int first_round) {
+    const __m256i offsets = _mm256_set_epi64x(12, 8, 4, 0);
+    uint64_t mask = target->digest_size >= sizeof(uint64_t)
+                            ? UINT64_MAX
+                            : (UINT64_C(1) << (target->digest_size * 8)) - 1;
+    __m256i a[KECCAK_MB_STATE_LANES], c[5], first;
+
+    for (size_t i = 0; i < KECCAK_MB_STATE_LANES; ++i) {
+        a[i] = _mm256_set1_epi64x((long long)target->state[i]);
+    }
+
+    // Only the key lanes differ between the states, so they're all the first round's parities need
+    for (size_t x = 0; x < KECCAK_MB_KEY_LANES; ++x) {
+        a[x] = _mm256_i64gather_epi64(
+                (const long long*)(keys + lane * KECCAK_MB_KEY_SIZE + x * sizeof(uint64_t)),
+                offsets, sizeof(uint64_t));
+        c[x] = _mm256_xor_si256(a[x], _mm256_set1_epi64x((long long)target->parities[x]));
+    }
+
+    for (size_t x = KECCAK_MB_KEY_LANES; x < 5; ++x) {
+        c[x] = _mm256_set1_epi64x((long long)target->parities[x]);
+    }
+
+    for (int round = first_round; round < KECCAK_ROUNDS - 1; ++round) {
+        KECCAK_MB_ROUND(__m256i, XOR_AVX2, ROL_AVX2, CHI_AVX2, a, c);
+        a[0] = _mm256_xor_si256(a[0], _mm256_set1_epi64x((long long)keccak_rc[round]));
+        KECCAK_MB_PARITIES(XOR5_AVX2, a, c);
+    }
+
+    first = KECCAK_MB_FIRST_LANE(XOR_AVX2, ROL_AVX2, CHI_AVX2, a, c);
+    first = _mm256_xor_si256(first, _mm256_set1_epi64x((long long)keccak_rc[KECCAK_ROUNDS - 1]));
+    first = _mm256_and_si256(first, _mm256_set1_epi64x((long long)mask));
+
+    return (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(
+            _mm256_cmpeq_epi64(first, _mm256_set1_epi64x((long long)target->digest[0]))));
+}
+
+#define XOR_AVX512(x, y) _mm512_xor_si512(x, y)
+#define XOR5_AVX512(v, w, x, y, z) \
+    _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(v, w, x, 0x96), y, z, 0x96)
+#define ROL_AVX512(x, n) _mm512_rolv_epi64(x, _mm512_set1_epi64(n))
+#define CHI_AVX512(x, y, z) _mm512_ternarylogic_epi64(x, y, z, 0xD2)
+
+/// The same as keccakMbAvx2, but over KECCAK_MB_AVX512_LANES keys.
+static KECCAK_MB_AVX512_TARGET uint32_t keccakMbAvx512(const unsigned char* keys, size_t lane,
+                                                       const KeccakMbTarget* target,
+                                                       int first_round) {
+    const __m512i offsets = _mm512_set_epi64(28, 24, 20, 16, 12, 8, 4, 0);
+    uint64_t mask = target->digest_size >= sizeof(uint64_t)
+                            ? UINT64_MAX
+                            : (UINT64_C(1) << (target->digest_size * 8)) - 1;
+    __m512i a[KECCAK_MB_STATE_LANES], c[5], first;
+
+    for (size_t i = 0; i < KECCAK_MB_STATE_LANES; ++i) {
+        a[i] = _mm512_set1_epi64((long long)target->state[i]);
+    }
+
+    // Only the key lanes differ between the states, so they're all the first round's parities need
+    for (size_t x = 0; x < KECCAK_MB_KEY_LANES; ++x) {
+        a[x] = _mm512_i64gather_epi64(
+                offsets, keys + lane * KECCAK_MB_KEY_SIZE + x * sizeof(uint64_t),
+                sizeof(uint64_t));
+        c[x] = _mm512_xor_si512(a[x], _mm512_set1_epi64((long long)target->parities[x]));
+    }
+
+    for (size_t x = KECCAK_MB_KEY_LANES; x < 5; ++x) {
+        c[x] = _mm512_set1_epi64((long long)target->parities[x]);
+    }
+
+    for (int round = first_round; round < KECCAK_ROUNDS - 1; ++round) {
+        KECCAK_MB_ROUND(__m512i, XOR_AVX512, ROL_AVX512, CHI_AVX512, a, c);
+        a[0] = _mm512_xor_si512(a[0], _mm512_set1_epi64((long long)keccak_rc[round]));
+        KECCAK_MB_PARITIES(XOR5_AVX512, a, c);
+    }
+
+    first = KECCAK_MB_FIRST_LANE(XOR_AVX512, ROL_AVX512, CHI_AVX512, a, c);
+    first = _mm512_xor_si512(first, _mm512_set1_epi64((long long)keccak_rc[KECCAK_ROUNDS - 1]));
+
+    return _mm512_mask_cmpeq_epi64_mask(
+            0xFF, _mm512_and_si512(first, _mm512_set1_epi64((long long)mask)),
+            _mm512_set1_epi64((long long)target->digest[0]));
+}
+#endif
+
+/// The dispatcher shared by keccakMbMatch and kang12MbMatch, which only differ in how many rounds
+/// of the permutation they run.
+static inline __attribute__((always_inline)) uint32_t keccakMbMatchRounds(
+        const unsigned char* keys, size_t key_count, const KeccakMbTarget* target, int first_round,
+        KeccakMbPermute permute) {
+    uint32_t matches = 0;
+    size_t lane = 0;
+
+    if (key_count > KECCAK_MB_MAX_KEYS) {
+        key_count = KECCAK_MB_MAX_KEYS;
+    }
+
+#ifdef RBC_HAVE_AVX512_TARGET
+    uint32_t candidates = 0;
+
+    if (key_count >= KECCAK_MB_AVX512_LANES && cpuFeatures()->avx512f) {
+        for (; lane + KECCAK_MB_AVX512_LANES <= key_count; lane += KECCAK_MB_AVX512_LANES) {
+            candidates |= keccakMbAvx512(keys, lane, target, first_round) << lane;
+        }
+    }
+
+    if (key_count - lane >= KECCAK_MB_AVX2_LANES && cpuFeatures()->avx2) {
+        for (; lane + KECCAK_MB_AVX2_LANES <= key_count; lane += KECCAK_MB_AVX2_LANES) {
+            candidates |= keccakMbAvx2(keys, lane, target, first_round) << lane;
+        }
+    }
+
+    // Only the first lane of each digest was compared, so check the rest of any that got that far
+    for (; candidates; candidates &= candidates - 1) {
+        size_t j = (size_t)__builtin_ctz(candidates);
+
+        if (keccakMbSnpMatch(keys + j * KECCAK_MB_KEY_SIZE, 1, target, permute)) {
+            matches |= UINT32_C(1) << j;
+        }
+    }
+#else
+    (void)first_round;
+#endif
+
+    if (lane < key_count) {
+        matches |= keccakMbSnpMatch(keys + lane * KECCAK_MB_KEY_SIZE, key_count - lane, target,
+                                    permute)
+                   << lane;
+    }
+
+    return matches;
+}
+
+uint32_t keccakMbMatch(const unsigned char* keys, size_t key_count, const KeccakMbTarget* target) {
+    return keccakMbMatchRounds(keys, key_count, target, 0, KECCAK_MB_SNP(PermuteAll_24rounds));
+}
+
+int kang12MbTail(uint64_t* tail, const unsigned char* salt, size_t salt_size) {
+    unsigned char salt_encoded[KANG12_MB_MAX_SALT_SIZE + 1];
+
+    if (salt_size > KANG12_MB_MAX_SALT_SIZE) {
+        return 1;
+    }
+
+    if (salt != NULL && salt_size > 0) {
+        memcpy(salt_encoded, salt, salt_size);
+    }
+
+    // An empty customization string only adds its length_encode(0), a single zero byte
+    salt_encoded[salt_size] = 0x00;
+
+    return keccakMbTail(tail, KANG12_RATE, KANG12_SUFFIX, salt_encoded, salt_size + 1);
+}
+
+uint32_t kang12MbMatch(const unsigned char* keys, size_t key_count, const KeccakMbTarget* target) {
+    return keccakMbMatchRounds(keys, key_count, target, KANG12_FIRST_ROUND,
+                               KECCAK_MB_SNP(PermuteAll_12rounds));
+}
+
+size_t keccakMbLanes(void) {
+#ifdef RBC_HAVE_AVX512_TARGET
+    if (cpuFeatures()->avx512f) {
+        return KECCAK_MB_AVX512_LANES;
+    }
+
+    if (cpuFeatures()->avx2) {
+        return KECCAK_MB_AVX2_LANES;
+    }
+#endif
+
+    return KECCAK_MB_LANES;
+}
@@ -0,0 +1,110 @@
+#ifndef RBC_VALIDATOR_CRYPTO_KECCAK_MB_H_
+#define RBC_VALIDATOR_CRYPTO_KECCAK_MB_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Multi-buffer SHA-3, SHAKE, and KangarooTwelve, which absorb many 32-byte keys at once into
+// parallel Keccak-p[1600] states, either with AVX-512 or AVX2 or with XKCP's. Each key along with
+// any salt and the padding must fit in a single block of the rate, so the rest of the block after
+// the key (the tail) is the same across every state and is built once ahead of time.
+
+#define KECCAK_MB_KEY_SIZE 32
+// The most keys a single call can match, one per bit of the returned mask
+#define KECCAK_MB_MAX_KEYS 32
+// How many keys each SIMD kernel permutes at once
+#define KECCAK_MB_AVX2_LANES 4
+#define KECCAK_MB_AVX512_LANES 8
+
+#define KECCAK_MB_STATE_LANES 25
+
+// How many bytes each function absorbs per permutation
+#define SHA3_224_RATE 144
+#define SHA3_256_RATE 136
+#define SHA3_384_RATE 104
+#define SHA3_512_RATE 72
+#define SHAKE128_RATE 168
+#define SHAKE256_RATE 136
+
+// KangarooTwelve absorbs a single-node tree at the same rate as SHAKE128
+#define KANG12_RATE SHAKE128_RATE
+
+// The domain separation bits and first padding bit that follow the message
+#define SHA3_SUFFIX   0x06
+#define SHAKE_SUFFIX  0x1F
+#define KANG12_SUFFIX 0x07
+
+// The largest salt that still fits in a block of the given rate, leaving room for the suffix
+#define KECCAK_MB_MAX_SALT_SIZE(rate) ((rate) - KECCAK_MB_KEY_SIZE - 1)
+// KangarooTwelve also has to fit the encoded length of its customization string
+#define KANG12_MB_MAX_SALT_SIZE (KECCAK_MB_MAX_SALT_SIZE(KANG12_RATE) - 1)
+// How many 64-bit lanes are in the tail of the largest block
+#define KECCAK_MB_TAIL_LANES ((SHAKE128_RATE - KECCAK_MB_KEY_SIZE) / sizeof(uint64_t))
+// How many 64-bit lanes are in the largest block
+#define KECCAK_MB_RATE_LANES (SHAKE128_RATE / sizeof(uint64_t))
+
+/// Everything a search hashes its keys against, which only depends on the tail and the digest and
+/// so is only built once. The key lanes are the only ones that differ between the states, so the
+/// first round's theta column parities over all of the other lanes are worked out ahead of time,
+/// leaving each key to only add its own lanes into them.
+typedef struct KeccakMbTarget {
+    // The state after absorbing the block with the key lanes left zeroed
+    uint64_t state[KECCAK_MB_STATE_LANES];
+    // The column parities of that state
+    uint64_t parities[5];
+    // The digest as lanes, zero-padded past digest_size
+    uint64_t digest[KECCAK_MB_RATE_LANES];
+    size_t digest_size;
+    size_t rate;
+} KeccakMbTarget;
+
+/// Build the tail of a SHA-3 or SHAKE block holding a key followed by a salt.
+/// \param tail The output KECCAK_MB_TAIL_LANES lanes after the key, of which only the first
+/// (rate - KECCAK_MB_KEY_SIZE) / 8 are used.
+/// \param rate The rate of the function in bytes, such as SHA3_256_RATE.
+/// \param suffix Either SHA3_SUFFIX or SHAKE_SUFFIX.
+/// \param salt An optional salt that follows the key. NULL if there is none.
+/// \param salt_size How big the salt is, up to KECCAK_MB_MAX_SALT_SIZE(rate).
+/// \return Returns 0 on success, or 1 if the salt doesn't fit.
+int keccakMbTail(uint64_t* tail, size_t rate, unsigned char suffix, const unsigned char* salt,
+                 size_t salt_size);
+
+/// Absorb the tail into the constant part of the state and pair it with the digest to compare
+/// against.
+/// \param target The output target.
+/// \param tail The rest of the block as filled by keccakMbTail or kang12MbTail.
+/// \param rate The rate tail was built with.
+/// \param digest The digest to compare against.
+/// \param digest_size How big the digest is, up to rate bytes.
+/// \return Returns 0 on success, or 1 if the rate isn't supported or the digest doesn't fit in it.
+int keccakMbTarget(KeccakMbTarget* target, const uint64_t* tail, size_t rate,
+                   const unsigned char* digest, size_t digest_size);
+
+/// Hash several keys using SHA-3 or SHAKE and compare each digest against a target, using AVX-512
+/// or AVX2 if the CPU supports it and as many permutations in parallel as the XKCP build supports
+/// otherwise (see keccakMbLanes).
+/// \param keys key_count keys of KECCAK_MB_KEY_SIZE bytes each, back to back (SEED_LAYOUT_AOS).
+/// \param key_count How many keys to hash, up to KECCAK_MB_MAX_KEYS.
+/// \param target The digest to compare against as filled by keccakMbTarget.
+/// \return A mask with bit j set if key j's digest matches.
+uint32_t keccakMbMatch(const unsigned char* keys, size_t key_count, const KeccakMbTarget* target);
+
+/// Build the tail of a KangarooTwelve block holding a key followed by a salt, which along with the
+/// empty customization string makes a single-node tree.
+/// \param tail The output KECCAK_MB_TAIL_LANES lanes after the key.
+/// \param salt An optional salt that follows the key. NULL if there is none.
+/// \param salt_size How big the salt is, up to KANG12_MB_MAX_SALT_SIZE.
+/// \return Returns 0 on success, or 1 if the salt doesn't fit.
+int kang12MbTail(uint64_t* tail, const unsigned char* salt, size_t salt_size);
+
+/// The same as keccakMbMatch, but using KangarooTwelve's 12-round permutation and a target built
+/// from a tail filled by kang12MbTail.
+uint32_t kang12MbMatch(const unsigned char* keys, size_t key_count, const KeccakMbTarget* target);
+
+/// How many keys keccakMbMatch and kang12MbMatch permute at once, depending on the CPU and, without
+/// AVX2, on which XKCP target was built.
+/// \return Returns 8 with AVX-512 or if Keccak-p[1600]×8 has a native implementation, or 4
+/// otherwise.
+size_t keccakMbLanes(void);
+
+#endif  // RBC_VALIDATOR_CRYPTO_KECCAK_MB_H_
@@ -0,0 +1,1116 @@
+#include "p256.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu_features.h"
+
+#ifdef RBC_HAVE_AVX512_TARGET
+#include <immintrin.h>
+
+#define P256_IFMA_TARGET __attribute__((target("avx512f,avx512ifma")))
+#endif
+
+typedef unsigned __int128 uint128_t;
+
+// p = 2^256 - 2^224 + 2^192 + 2^96 - 1
+static const P256Fe kP = {{UINT64_C(0xffffffffffffffff), UINT64_C(0x00000000ffffffff),
+                           UINT64_C(0x0000000000000000), UINT64_C(0xffffffff00000001)}};
+// 1 and R^2 modulo p, where R = 2^256, the first being 1 in Montgomery form
+static const P256Fe kOne = {{UINT64_C(0x0000000000000001), UINT64_C(0xffffffff00000000),
+                             UINT64_C(0xffffffffffffffff), UINT64_C(0x00000000fffffffe)}};
+static const P256Fe kRR = {{UINT64_C(0x0000000000000003), UINT64_C(0xfffffffbffffffff),
+                            UINT64_C(0xfffffffffffffffe), UINT64_C(0x00000004fffffffd)}};
+// The curve's b and its generator, in Montgomery form
+static const P256Fe kB = {{UINT64_C(0xd89cdf6229c4bddf), UINT64_C(0xacf005cd78843090),
+                           UINT64_C(0xe5a220abf7212ed6), UINT64_C(0xdc30061d04874834)}};
+static const P256Affine kG = {
+        {{UINT64_C(0x79e730d418a9143c), UINT64_C(0x75ba95fc5fedb601),
+          UINT64_C(0x79fb732b77622510), UINT64_C(0x18905f76a53755c6)}},
+        {{UINT64_C(0xddf25357ce95560a), UINT64_C(0x8b4ab8e4ba19e45c),
+          UINT64_C(0xd2e88688dd21f325), UINT64_C(0x8571ff1825885d85)}}};
+
+/// Subtract p from a 257-bit value if it is at least p.
+static inline void feReduce(P256Fe* r, const uint64_t* t, uint64_t carry) {
+    uint64_t d[4], borrow = 0;
+
+    for (int i = 0; i < 4; i++) {
+        uint128_t x = (uint128_t)t[i] - kP.v[i] - borrow;
+
+        d[i] = (uint64_t)x;
+        borrow = (uint64_t)(x >> 64) & 1;
+    }
+
+    // Keep t if subtracting p borrowed past the carry
+    if (borrow > carry) {
+        memcpy(r->v, t, sizeof(r->v));
+    } else {
+        memcpy(r->v, d, sizeof(r->v));
+    }
+}
+
+static inline void feAdd(P256Fe* r, const P256Fe* a, const P256Fe* b) {
+    uint64_t t[4], carry = 0;
+
+    for (int i = 0; i < 4; i++) {
+        uint128_t x = (uint128_t)a->v[i] + b->v[i] + carry;
+
+        t[i] = (uint64_t)x;
+        carry = (uint64_t)(x >> 64);
+    }
+
+    feReduce(r, t, carry);
+}
+
+static inline void feSub(P256Fe* r, const P256Fe* a, const P256Fe* b) {
+    uint64_t t[4], borrow = 0, carry = 0;
+
+    for (int i = 0; i < 4; i++) {
+        uint128_t x = (uint128_t)a->v[i] - b->v[i] - borrow;
+
+        t[i] = (uint64_t)x;
+        borrow = (uint64_t)(x >> 64) & 1;
+    }
+
+    // Add p back if it went negative
+    if (borrow) {
+        for (int i = 0; i < 4; i++) {
+            uint128_t x = (uint128_t)t[i] + kP.v[i] + carry;
+
+            t[i] = (uint64_t)x;
+            carry = (uint64_t)(x >> 64);
+        }
+    }
+
+    memcpy(r->v, t, sizeof(r->v));
+}
+
+/// Montgomery multiplication, a * b / R mod p, interleaving each row of the product with a step of
+/// the reduction. Since p = -1 mod 2^64, each step's multiple of p is just the lowest limb.
+static inline void feMul(P256Fe* r, const P256Fe* a, const P256Fe* b) {
+    uint64_t t[5] = {0}, top = 0;
+
+    for (int i = 0; i < 4; i++) {
+        uint64_t carry = 0, m;
+        uint128_t x;
+
+        for (int j = 0; j < 4; j++) {
+            x = (uint128_t)a->v[j] * b->v[i] + t[j] + carry;
+            t[j] = (uint64_t)x;
+            carry = (uint64_t)(x >> 64);
+        }
+
+        x = (uint128_t)t[4] + carry;
+        t[4] = (uint64_t)x;
+        top = (uint64_t)(x >> 64);
+
+        // Adding m * p clears the lowest limb, which is then shifted out
+        m = t[0];
+        x = (uint128_t)m * kP.v[0] + t[0];
+        carry = (uint64_t)(x >> 64);
+
+        for (int j = 1; j < 4; j++) {
+            x = (uint128_t)m * kP.v[j] + t[j] + carry;
+            t[j - 1] = (uint64_t)x;
+            carry = (uint64_t)(x >> 64);
+        }
+
+        x = (uint128_t)t[4] + carry;
+        t[3] = (uint64_t)x;
+        t[4] = top + (uint64_t)(x >> 64);
+    }
+
+    feReduce(r, t, t[4]);
+}
+
+static inline void feSqr(P256Fe* r, const P256Fe* a) {
+    feMul(r, a, a);
+}
+
+static inline int feIsZero(const P256Fe* a) {
+    return (a->v[0] | a->v[1] | a->v[2] | a->v[3]) == 0;
+}
+
+static inline int feEqual(const P256Fe* a, const P256Fe* b) {
+    return ((a->v[0] ^ b->v[0]) | (a->v[1] ^ b->v[1]) | (a->v[2] ^ b->v[2]) |
+            (a->v[3] ^ b->v[3])) == 0;
+}
+
+/// Invert a field element as a^(p - 2), or leave 0 as 0.
+static void feInv(P256Fe* r, const P256Fe* a) {
+    P256Fe result = kOne;
+
+    // p - 2 from its most significant bit down
+    for (int i = 255; i >= 0; i--) {
+        uint64_t limb = kP.v[i / 64] - (i < 64 ? 2 : 0);
+
+        feSqr(&result, &result);
+
+        if ((limb >> (i % 64)) & 1) {
+            feMul(&result, &result, a);
+        }
+    }
+
+    *r = result;
+}
+
+static void feFromBytes(P256Fe* r, const unsigned char* bytes) {
+    P256Fe t;
+
+    for (int i = 0; i < 4; i++) {
+        t.v[i] = 0;
+
+        for (int j = 0; j < 8; j++) {
+            t.v[i] = (t.v[i] << 8) | bytes[(3 - i) * 8 + j];
+        }
+    }
+
+    // Converting to Montgomery form also reduces anything past p
+    feMul(r, &t, &kRR);
+}
+
+void p256FeGet(uint64_t* r, const P256Fe* a) {
+    const P256Fe one = {{1, 0, 0, 0}};
+    P256Fe t;
+
+    feMul(&t, a, &one);
+    memcpy(r, t.v, sizeof(t.v));
+}
+
+static void feToBytes(unsigned char* bytes, const P256Fe* a) {
+    uint64_t t[4];
+
+    p256FeGet(t, a);
+
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 8; j++) {
+            bytes[(3 - i) * 8 + j] = (unsigned char)(t[i] >> (56 - j * 8));
+        }
+    }
+}
+
+void p256PointDouble(P256Point* r, const P256Point* a) {
+    P256Fe delta, gamma, beta, alpha, t0, t1;
+
+    if (feIsZero(&(a->z))) {
+        *r = *a;
+
+        return;
+    }
+
+    // dbl-2001-b, for a = -3
+    feSqr(&delta, &(a->z));
+    feSqr(&gamma, &(a->y));
+    feMul(&beta, &(a->x), &gamma);
+
+    // alpha = 3 * (x - delta) * (x + delta)
+    feSub(&t0, &(a->x), &delta);
+    feAdd(&t1, &(a->x), &delta);
+    feMul(&alpha, &t0, &t1);
+    feAdd(&t0, &alpha, &alpha);
+    feAdd(&alpha, &t0, &alpha);
+
+    // z3 = (y + z)^2 - gamma - delta
+    feAdd(&t0, &(a->y), &(a->z));
+    feSqr(&t0, &t0);
+    feSub(&t0, &t0, &gamma);
+    feSub(&(r->z), &t0, &delta);
+
+    // x3 = alpha^2 - 8 * beta
+    feAdd(&beta, &beta, &beta);
+    feAdd(&beta, &beta, &beta);
+    feSqr(&t0, &alpha);
+    feAdd(&t1, &beta, &beta);
+    feSub(&(r->x), &t0, &t1);
+
+    // y3 = alpha * (4 * beta - x3) - 8 * gamma^2
+    feSub(&t0, &beta, &(r->x));
+    feMul(&t0, &alpha, &t0);
+    feSqr(&gamma, &gamma);
+    feAdd(&gamma, &gamma, &gamma);
+    feAdd(&gamma, &gamma, &gamma);
+    feAdd(&gamma, &gamma, &gamma);
+    feSub(&(r->y), &t0, &gamma);
+}
+
+void p256PointAddAffine(P256Point* r, const P256Point* a, const P256Affine* b) {
+    P256Fe z1z1, u2, s2, h, hh, i, j, rr, v, t0;
+
+    if (p256AffineIsInfinity(b)) {
+        *r = *a;
+
+        return;
+    }
+
+    if (feIsZero(&(a->z))) {
+        r->x = b->x;
+        r->y = b->y;
+        r->z = kOne;
+
+        return;
+    }
+
+    // madd-2007-bl
+    feSqr(&z1z1, &(a->z));
+    feMul(&u2, &(b->x), &z1z1);
+    feMul(&s2, &(a->z), &z1z1);
+    feMul(&s2, &(b->y), &s2);
+    feSub(&h, &u2, &(a->x));
+    feSub(&rr, &s2, &(a->y));
+
+    if (feIsZero(&h)) {
+        if (feIsZero(&rr)) {
+            p256PointDouble(r, a);
+        } else {
+            memset(r, 0, sizeof(*r));
+        }
+
+        return;
+    }
+
+    feAdd(&rr, &rr, &rr);
+    feSqr(&hh, &h);
+    feAdd(&i, &hh, &hh);
+    feAdd(&i, &i, &i);
+    feMul(&j, &h, &i);
+    feMul(&v, &(a->x), &i);
+
+    // z3 = (z1 + h)^2 - z1z1 - hh, worked out first since r may be a
+    feAdd(&t0, &(a->z), &h);
+    feSqr(&t0, &t0);
+    feSub(&t0, &t0, &z1z1);
+    feSub(&(r->z), &t0, &hh);
+
+    // y1 * j before x3 overwrites anything
+    feMul(&t0, &(a->y), &j);
+    feAdd(&t0, &t0, &t0);
+
+    // x3 = rr^2 - j - 2 * v
+    feSqr(&(r->x), &rr);
+    feSub(&(r->x), &(r->x), &j);
+    feSub(&(r->x), &(r->x), &v);
+    feSub(&(r->x), &(r->x), &v);
+
+    // y3 = rr * (v - x3) - 2 * y1 * j
+    feSub(&v, &v, &(r->x));
+    feMul(&v, &rr, &v);
+    feSub(&(r->y), &v, &t0);
+}
+
+void p256PointNegate(P256Point* r, const P256Point* a) {
+    const P256Fe zero = {{0}};
+
+    r->x = a->x;
+    feSub(&(r->y), &zero, &(a->y));
+    r->z = a->z;
+}
+
+int p256AffineIsInfinity(const P256Affine* a) {
+    return feIsZero(&(a->x)) && feIsZero(&(a->y));
+}
+
+void p256ScalarMulBase(P256Point* r, const unsigned char* scalar) {
+    P256Point result;
+
+    memset(&result, 0, sizeof(result));
+
+    for (int i = 0; i < P256_SCALAR_SIZE * 8; i++) {
+        p256PointDouble(&result, &result);
+
+        if ((scalar[i / 8] >> (7 - i % 8)) & 1) {
+            p256PointAddAffine(&result, &result, &kG);
+        }
+    }
+
+    *r = result;
+}
+
+void p256BatchToAffine(P256Affine* r, const P256Point* points, size_t count) {
+    P256Fe inv, z_inv, z_inv2;
+
+    if (count == 0) {
+        return;
+    }
+
+    // Montgomery's trick, with r[i].x holding the product of every z up to i, skipping infinity
+    for (size_t i = 0; i < count; i++) {
+        const P256Fe* prev = i > 0 ? &(r[i - 1].x) : &kOne;
+
+        if (feIsZero(&(points[i].z))) {
+            r[i].x = *prev;
+        } else {
+            feMul(&(r[i].x), prev, &(points[i].z));
+        }
+    }
+
+    feInv(&inv, &(r[count - 1].x));
+
+    for (size_t i = count; i-- > 0;) {
+        if (feIsZero(&(points[i].z))) {
+            memset(&(r[i]), 0, sizeof(r[i]));
+            continue;
+        }
+
+        // The inverse of this z is the inverse of the product up to it times the product before it
+        if (i > 0) {
+            feMul(&z_inv, &inv, &(r[i - 1].x));
+            feMul(&inv, &inv, &(points[i].z));
+        } else {
+            z_inv = inv;
+        }
+
+        feSqr(&z_inv2, &z_inv);
+        feMul(&(r[i].x), &(points[i].x), &z_inv2);
+        feMul(&z_inv2, &z_inv2, &z_inv);
+        feMul(&(r[i].y), &(points[i].y), &z_inv2);
+    }
+}
+
+int p256PointEqualsAffine(const P256Point* a, const P256Affine* b) {
+    P256Fe z2, t;
+
+    if (feIsZero(&(a->z))) {
+        return p256AffineIsInfinity(b);
+    }
+
+    // x = b.x * z^2, and only then y = b.y * z^3
+    feSqr(&z2, &(a->z));
+    feMul(&t, &(b->x), &z2);
+
+    if (!feEqual(&t, &(a->x))) {
+        return 0;
+    }
+
+    feMul(&z2, &z2, &(a->z));
+    feMul(&t, &(b->y), &z2);
+
+    return feEqual(&t, &(a->y));
+}
+
+int p256HasIfma(void) {
+    return cpuFeatures()->avx512ifma;
+}
+
+#ifdef RBC_HAVE_AVX512_TARGET
+#define IFMA_LIMB_MASK ((UINT64_C(1) << 52) - 1)
+// How many 64-bit words apart two points are in an array of them
+#define IFMA_POINT_STRIDE  (sizeof(P256Point) / sizeof(uint64_t))
+#define IFMA_AFFINE_STRIDE (sizeof(P256Affine) / sizeof(uint64_t))
+// How many 64-bit words each of P256Step's ifma_points takes up
+#define IFMA_TABLE_STRIDE 10
+
+// p and 2p as 52-bit limbs
+static const uint64_t kPIfma[5] = {UINT64_C(0xfffffffffffff), UINT64_C(0xfffffffffff), 0,
+                                   UINT64_C(0x1000000000), UINT64_C(0xffffffff0000)};
+static const uint64_t k2PIfma[5] = {UINT64_C(0xffffffffffffe), UINT64_C(0x1fffffffffff), 0,
+                                    UINT64_C(0x2000000000), UINT64_C(0x1fffffffe0000)};
+// 2^264 and 2^256 modulo p. Montgomery multiplication for R = 2^260 by them turns Montgomery form
+// for R = 2^256 into that for R = 2^260, and back.
+static const uint64_t kToIfma[5] = {UINT64_C(0x100), 0, UINT64_C(0xfffffffffffff),
+                                    UINT64_C(0xfefffffffffff), UINT64_C(0xffffff)};
+static const uint64_t kFromIfma[5] = {UINT64_C(0x1), UINT64_C(0xff00000000000),
+                                      UINT64_C(0xfffffffffffff), UINT64_C(0xfffefffffffff),
+                                      UINT64_C(0xffff)};
+
+/// A field element in each of 8 lanes, as five 52-bit limbs in Montgomery form for R = 2^260, least
+/// significant first. Every limb is kept below 2^52, as IFMA only multiplies their low 52 bits, and
+/// every value below 2p.
+typedef struct FeIfma {
+    __m512i v[5];
+} FeIfma;
+
+typedef struct PointIfma {
+    FeIfma x, y, z;
+} PointIfma;
+
+/// Split four 64-bit limbs into five 52-bit ones.
+static void feToIfmaLimbs(uint64_t* r, const uint64_t* w) {
+    r[0] = w[0] & IFMA_LIMB_MASK;
+    r[1] = (w[0] >> 52 | w[1] << 12) & IFMA_LIMB_MASK;
+    r[2] = (w[1] >> 40 | w[2] << 24) & IFMA_LIMB_MASK;
+    r[3] = (w[2] >> 28 | w[3] << 36) & IFMA_LIMB_MASK;
+    r[4] = w[3] >> 16;
+}
+
+/// Convert a field element to 52-bit limbs in Montgomery form for R = 2^260, which is 16 times its
+/// Montgomery form for R = 2^256.
+static void feToIfma(uint64_t* r, const P256Fe* a) {
+    P256Fe t = *a;
+
+    for (int i = 0; i < 4; i++) {
+        feAdd(&t, &t, &t);
+    }
+
+    feToIfmaLimbs(r, t.v);
+}
+
+static inline P256_IFMA_TARGET void feIfmaSet(FeIfma* r, const uint64_t* limbs) {
+    for (int i = 0; i < 5; i++) {
+        r->v[i] = _mm512_set1_epi64((long long)limbs[i]);
+    }
+}
+
+/// Carry each limb past 52 bits into the next, where limbs may be negative but the value isn't.
+static inline P256_IFMA_TARGET void feIfmaCarry(FeIfma* a) {
+    const __m512i mask = _mm512_set1_epi64(IFMA_LIMB_MASK);
+
+    for (int i = 0; i < 4; i++) {
+        a->v[i + 1] = _mm512_add_epi64(a->v[i + 1], _mm512_srai_epi64(a->v[i], 52));
+        a->v[i] = _mm512_and_si512(a->v[i], mask);
+    }
+}
+
+/// Carry a value's limbs and subtract a modulus from it if it is at least the modulus.
+static inline P256_IFMA_TARGET void feIfmaReduce(FeIfma* r, const FeIfma* a,
+                                                 const uint64_t* modulus) {
+    FeIfma s = *a, t;
+    __mmask8 negative;
+
+    feIfmaCarry(&s);
+
+    for (int i = 0; i < 5; i++) {
+        t.v[i] = _mm512_sub_epi64(s.v[i], _mm512_set1_epi64((long long)modulus[i]));
+    }
+
+    feIfmaCarry(&t);
+
+    negative = _mm512_cmplt_epi64_mask(t.v[4], _mm512_setzero_si512());
+
+    for (int i = 0; i < 5; i++) {
+        r->v[i] = _mm512_mask_blend_epi64(negative, t.v[i], s.v[i]);
+    }
+}
+
+static inline P256_IFMA_TARGET void feIfmaAdd(FeIfma* r, const FeIfma* a, const FeIfma* b) {
+    FeIfma t;
+
+    for (int i = 0; i < 5; i++) {
+        t.v[i] = _mm512_add_epi64(a->v[i], b->v[i]);
+    }
+
+    feIfmaReduce(r, &t, k2PIfma);
+}
+
+static inline P256_IFMA_TARGET void feIfmaSub(FeIfma* r, const FeIfma* a, const FeIfma* b) {
+    FeIfma t;
+
+    // Adding 2p keeps it from going negative
+    for (int i = 0; i < 5; i++) {
+        t.v[i] = _mm512_add_epi64(_mm512_sub_epi64(a->v[i], b->v[i]),
+                                  _mm512_set1_epi64((long long)k2PIfma[i]));
+    }
+
+    feIfmaReduce(r, &t, k2PIfma);
+}
+
+/// Montgomery multiplication for R = 2^260, the same as feMul but over 52-bit limbs, leaving the
+/// carries in each limb until the end. Since p = -1 mod 2^52 as well, each step's multiple of p is
+/// the lowest limb again.
+static inline P256_IFMA_TARGET void feIfmaMul(FeIfma* r, const FeIfma* a, const FeIfma* b) {
+    const __m512i mask = _mm512_set1_epi64(IFMA_LIMB_MASK);
+    __m512i t[6], m;
+
+    for (int i = 0; i < 6; i++) {
+        t[i] = _mm512_setzero_si512();
+    }
+
+    for (int i = 0; i < 5; i++) {
+        for (int j = 0; j < 5; j++) {
+            t[j] = _mm512_madd52lo_epu64(t[j], a->v[i], b->v[j]);
+            t[j + 1] = _mm512_madd52hi_epu64(t[j + 1], a->v[i], b->v[j]);
+        }
+
+        m = _mm512_and_si512(t[0], mask);
+
+        for (int j = 0; j < 5; j++) {
+            if (kPIfma[j] != 0) {
+                const __m512i p = _mm512_set1_epi64((long long)kPIfma[j]);
+
+                t[j] = _mm512_madd52lo_epu64(t[j], m, p);
+                t[j + 1] = _mm512_madd52hi_epu64(t[j + 1], m, p);
+            }
+        }
+
+        // The lowest limb is now a multiple of 2^52, so only its carry is left
+        t[1] = _mm512_add_epi64(t[1], _mm512_srli_epi64(t[0], 52));
+
+        for (int j = 0; j < 5; j++) {
+            t[j] = t[j + 1];
+        }
+
+        t[5] = _mm512_setzero_si512();
+    }
+
+    for (int i = 0; i < 5; i++) {
+        r->v[i] = t[i];
+    }
+
+    feIfmaCarry(r);
+}
+
+static inline P256_IFMA_TARGET void feIfmaSqr(FeIfma* r, const FeIfma* a) {
+    feIfmaMul(r, a, a);
+}
+
+/// \return A mask of the lanes where the value is 0 modulo p.
+static inline P256_IFMA_TARGET __mmask8 feIfmaIsZero(const FeIfma* a) {
+    FeIfma t;
+
+    feIfmaReduce(&t, a, kPIfma);
+
+    return _mm512_cmpeq_epi64_mask(
+            _mm512_or_si512(_mm512_or_si512(t.v[0], t.v[1]),
+                            _mm512_or_si512(_mm512_or_si512(t.v[2], t.v[3]), t.v[4])),
+            _mm512_setzero_si512());
+}
+
+/// Gather a field element of each lane as four 64-bit limbs and split them into 52-bit ones,
+/// leaving it in whatever Montgomery form it was in.
+/// \param base The first field element.
+/// \param index How many 64-bit words each lane's field element is past base.
+static inline P256_IFMA_TARGET void feIfmaGather(FeIfma* r, const P256Fe* base, __m512i index,
+                                                 __mmask8 lanes) {
+    const __m512i mask = _mm512_set1_epi64(IFMA_LIMB_MASK);
+    __m512i w[4];
+
+    for (int i = 0; i < 4; i++) {
+        w[i] = _mm512_mask_i64gather_epi64(_mm512_setzero_si512(), lanes, index, base->v + i, 8);
+    }
+
+    r->v[0] = _mm512_and_si512(w[0], mask);
+    r->v[1] = _mm512_and_si512(
+            _mm512_or_si512(_mm512_srli_epi64(w[0], 52), _mm512_slli_epi64(w[1], 12)), mask);
+    r->v[2] = _mm512_and_si512(
+            _mm512_or_si512(_mm512_srli_epi64(w[1], 40), _mm512_slli_epi64(w[2], 24)), mask);
+    r->v[3] = _mm512_and_si512(
+            _mm512_or_si512(_mm512_srli_epi64(w[2], 28), _mm512_slli_epi64(w[3], 36)), mask);
+    r->v[4] = _mm512_srli_epi64(w[3], 16);
+}
+
+/// Gather a field element of each lane in Montgomery form for R = 2^256 into that for R = 2^260.
+static inline P256_IFMA_TARGET void feIfmaLoad(FeIfma* r, const P256Fe* base, __m512i index,
+                                               __mmask8 lanes) {
+    FeIfma to;
+
+    feIfmaGather(r, base, index, lanes);
+    feIfmaSet(&to, kToIfma);
+    feIfmaMul(r, r, &to);
+}
+
+/// The reverse of feIfmaLoad, scattering each lane's field element back fully reduced.
+static inline P256_IFMA_TARGET void feIfmaStore(P256Fe* base, __m512i index, __mmask8 lanes,
+                                                const FeIfma* a) {
+    FeIfma from, t;
+    __m512i w[4];
+
+    feIfmaSet(&from, kFromIfma);
+    feIfmaMul(&t, a, &from);
+    feIfmaReduce(&t, &t, kPIfma);
+
+    w[0] = _mm512_or_si512(t.v[0], _mm512_slli_epi64(t.v[1], 52));
+    w[1] = _mm512_or_si512(_mm512_srli_epi64(t.v[1], 12), _mm512_slli_epi64(t.v[2], 40));
+    w[2] = _mm512_or_si512(_mm512_srli_epi64(t.v[2], 24), _mm512_slli_epi64(t.v[3], 28));
+    w[3] = _mm512_or_si512(_mm512_srli_epi64(t.v[3], 36), _mm512_slli_epi64(t.v[4], 16));
+
+    for (int i = 0; i < 4; i++) {
+        _mm512_mask_i64scatter_epi64(base->v + i, lanes, index, w[i], 8);
+    }
+}
+
+static inline P256_IFMA_TARGET __m512i pointIfmaIndex(void) {
+    return _mm512_set_epi64(7 * IFMA_POINT_STRIDE, 6 * IFMA_POINT_STRIDE, 5 * IFMA_POINT_STRIDE,
+                            4 * IFMA_POINT_STRIDE, 3 * IFMA_POINT_STRIDE, 2 * IFMA_POINT_STRIDE,
+                            IFMA_POINT_STRIDE, 0);
+}
+
+static inline P256_IFMA_TARGET void pointIfmaLoad(PointIfma* r, const P256Point* points,
+                                                  __mmask8 lanes) {
+    feIfmaLoad(&(r->x), &(points->x), pointIfmaIndex(), lanes);
+    feIfmaLoad(&(r->y), &(points->y), pointIfmaIndex(), lanes);
+    feIfmaLoad(&(r->z), &(points->z), pointIfmaIndex(), lanes);
+}
+
+static inline P256_IFMA_TARGET void pointIfmaStore(P256Point* points, __mmask8 lanes,
+                                                   const PointIfma* a) {
+    feIfmaStore(&(points->x), pointIfmaIndex(), lanes, &(a->x));
+    feIfmaStore(&(points->y), pointIfmaIndex(), lanes, &(a->y));
+    feIfmaStore(&(points->z), pointIfmaIndex(), lanes, &(a->z));
+}
+
+/// Add an affine point to the Jacobian point of each lane, the same way p256PointAddAffine does,
+/// except for the lanes where the Jacobian point is infinity or has the same x as the affine one,
+/// which are left as they are.
+/// \param a The Jacobian points, which are added to in place.
+/// \param x2 The x of each lane's affine point, which can't be infinity.
+/// \param y2 The y of each lane's affine point.
+/// \param lanes Which lanes to add to.
+/// \return A mask of the lanes left as they are, for p256PointAddAffine to take care of.
+static P256_IFMA_TARGET __mmask8 pointIfmaAddAffine(PointIfma* a, const FeIfma* x2,
+                                                    const FeIfma* y2, __mmask8 lanes) {
+    FeIfma z1z1, u2, s2, h, hh, i, j, rr, v, t0, x3, z3;
+    __mmask8 skipped;
+
+    // madd-2007-bl
+    feIfmaSqr(&z1z1, &(a->z));
+    feIfmaMul(&u2, x2, &z1z1);
+    feIfmaMul(&s2, &(a->z), &z1z1);
+    feIfmaMul(&s2, y2, &s2);
+    feIfmaSub(&h, &u2, &(a->x));
+    feIfmaSub(&rr, &s2, &(a->y));
+
+    skipped = lanes & (feIfmaIsZero(&(a->z)) | feIfmaIsZero(&h));
+    lanes &= ~skipped;
+
+    feIfmaAdd(&rr, &rr, &rr);
+    feIfmaSqr(&hh, &h);
+    feIfmaAdd(&i, &hh, &hh);
+    feIfmaAdd(&i, &i, &i);
+    feIfmaMul(&j, &h, &i);
+    feIfmaMul(&v, &(a->x), &i);
+
+    // z3 = (z1 + h)^2 - z1z1 - hh
+    feIfmaAdd(&t0, &(a->z), &h);
+    feIfmaSqr(&t0, &t0);
+    feIfmaSub(&t0, &t0, &z1z1);
+    feIfmaSub(&z3, &t0, &hh);
+
+    feIfmaMul(&t0, &(a->y), &j);
+    feIfmaAdd(&t0, &t0, &t0);
+
+    // x3 = rr^2 - j - 2 * v
+    feIfmaSqr(&x3, &rr);
+    feIfmaSub(&x3, &x3, &j);
+    feIfmaSub(&x3, &x3, &v);
+    feIfmaSub(&x3, &x3, &v);
+
+    // y3 = rr * (v - x3) - 2 * y1 * j
+    feIfmaSub(&v, &v, &x3);
+    feIfmaMul(&v, &rr, &v);
+    feIfmaSub(&v, &v, &t0);
+
+    for (int k = 0; k < 5; k++) {
+        a->x.v[k] = _mm512_mask_mov_epi64(a->x.v[k], lanes, x3.v[k]);
+        a->y.v[k] = _mm512_mask_mov_epi64(a->y.v[k], lanes, v.v[k]);
+        a->z.v[k] = _mm512_mask_mov_epi64(a->z.v[k], lanes, z3.v[k]);
+    }
+
+    return skipped;
+}
+
+/// The AVX-512 IFMA version of p256PointsAddAffine, for an affine point that isn't infinity.
+static P256_IFMA_TARGET void pointsAddAffineIfma(P256Point* r, const P256Point* a,
+                                                 const P256Affine* b, size_t count) {
+    uint64_t limbs[5];
+    FeIfma x2, y2;
+    PointIfma t;
+
+    feToIfma(limbs, &(b->x));
+    feIfmaSet(&x2, limbs);
+    feToIfma(limbs, &(b->y));
+    feIfmaSet(&y2, limbs);
+
+    for (size_t i = 0; i < count; i += P256_STEP_LANES) {
+        size_t n = count - i < P256_STEP_LANES ? count - i : P256_STEP_LANES;
+        __mmask8 lanes = (__mmask8)((1u << n) - 1), skipped;
+
+        pointIfmaLoad(&t, a + i, lanes);
+        skipped = pointIfmaAddAffine(&t, &x2, &y2, lanes);
+        pointIfmaStore(r + i, lanes, &t);
+
+        // The lanes left out were stored as they were
+        for (; skipped; skipped &= skipped - 1) {
+            size_t lane = i + (size_t)__builtin_ctz(skipped);
+
+            p256PointAddAffine(&(r[lane]), &(r[lane]), b);
+        }
+    }
+}
+
+/// The AVX-512 IFMA version of p256PointsEqualAffine, for an affine point that isn't infinity.
+static P256_IFMA_TARGET uint32_t pointsEqualAffineIfma(const P256Point* points, size_t count,
+                                                       const P256Affine* b) {
+    uint64_t limbs[5];
+    uint32_t matches = 0;
+    P256Fe k = b->x;
+    FeIfma x, z, x2;
+
+    // Leaving x and z in Montgomery form for R = 2^256 saves converting them, as long as b.x is
+    // taken times R'^2 / R^2 = 2^8 more, where R' = 2^260
+    for (int i = 0; i < 8; i++) {
+        feAdd(&k, &k, &k);
+    }
+
+    feToIfmaLimbs(limbs, k.v);
+    feIfmaSet(&x2, limbs);
+
+    for (size_t i = 0; i < count; i += P256_STEP_LANES) {
+        size_t n = count - i < P256_STEP_LANES ? count - i : P256_STEP_LANES;
+        __mmask8 lanes = (__mmask8)((1u << n) - 1), candidates = 0, infinity;
+
+        feIfmaGather(&x, &(points[i].x), pointIfmaIndex(), lanes);
+        feIfmaGather(&z, &(points[i].z), pointIfmaIndex(), lanes);
+
+        // z is fully reduced already, so only 0 stands for infinity, which never matches
+        infinity = _mm512_cmpeq_epi64_mask(
+                _mm512_or_si512(_mm512_or_si512(z.v[0], z.v[1]),
+                                _mm512_or_si512(_mm512_or_si512(z.v[2], z.v[3]), z.v[4])),
+                _mm512_setzero_si512());
+
+        // x = b.x * z^2
+        feIfmaSqr(&z, &z);
+        feIfmaMul(&z, &x2, &z);
+        feIfmaReduce(&z, &z, kPIfma);
+
+        candidates = lanes & ~infinity;
+
+        for (int j = 0; j < 5; j++) {
+            candidates &= _mm512_cmpeq_epi64_mask(x.v[j], z.v[j]);
+        }
+
+        // Only a match or its negation is left to check y for
+        for (; candidates; candidates &= candidates - 1) {
+            size_t lane = i + (size_t)__builtin_ctz(candidates);
+
+            if (p256PointEqualsAffine(&(points[lane]), b)) {
+                matches |= UINT32_C(1) << lane;
+            }
+        }
+    }
+
+    return matches;
+}
+
+/// Step the lanes of P256Step_getLanes in lock-step, adding the next of each lane's points until
+/// every lane runs out.
+/// \param adds The indices into step->points to add to each lane, in order.
+/// \param add_counts How many points to add to each lane.
+static P256_IFMA_TARGET void stepLanesIfma(const P256Step* step, P256Point* points,
+                                           const size_t (*adds)[P256_STEP_MAX_FLIPS],
+                                           const int* add_counts) {
+    __mmask8 lanes = 0;
+    int rounds = 0;
+    PointIfma a;
+
+    for (int lane = 0; lane < P256_STEP_LANES; lane++) {
+        if (add_counts[lane] > 0) {
+            lanes |= (__mmask8)(1u << lane);
+            rounds = add_counts[lane] > rounds ? add_counts[lane] : rounds;
+        }
+    }
+
+    if (lanes == 0) {
+        return;
+    }
+
+    pointIfmaLoad(&a, points, lanes);
+
+    for (int round = 0; round < rounds; round++) {
+        long long offsets[P256_STEP_LANES] = {0};
+        __mmask8 active = 0, skipped;
+        __m512i index;
+        FeIfma x2, y2;
+
+        for (int lane = 0; lane < P256_STEP_LANES; lane++) {
+            if (round < add_counts[lane]) {
+                active |= (__mmask8)(1u << lane);
+                offsets[lane] = (long long)(adds[lane][round] * IFMA_TABLE_STRIDE);
+            }
+        }
+
+        index = _mm512_loadu_si512(offsets);
+
+        for (int k = 0; k < 5; k++) {
+            x2.v[k] = _mm512_mask_i64gather_epi64(_mm512_setzero_si512(), active, index,
+                                                  step->ifma_points + k, 8);
+            y2.v[k] = _mm512_mask_i64gather_epi64(_mm512_setzero_si512(), active, index,
+                                                  step->ifma_points + 5 + k, 8);
+        }
+
+        if ((skipped = pointIfmaAddAffine(&a, &x2, &y2, active)) != 0) {
+            pointIfmaStore(points, lanes, &a);
+
+            for (; skipped; skipped &= skipped - 1) {
+                int lane = __builtin_ctz(skipped);
+
+                p256PointAddAffine(&(points[lane]), &(points[lane]),
+                                   &(step->points[adds[lane][round]]));
+            }
+
+            pointIfmaLoad(&a, points, lanes);
+        }
+    }
+
+    pointIfmaStore(points, lanes, &a);
+}
+#endif
+
+void p256PointsAddAffine(P256Point* r, const P256Point* a, const P256Affine* b, size_t count) {
+#ifdef RBC_HAVE_AVX512_TARGET
+    if (!p256AffineIsInfinity(b) && p256HasIfma()) {
+        pointsAddAffineIfma(r, a, b, count);
+
+        return;
+    }
+#endif
+
+    for (size_t i = 0; i < count; i++) {
+        p256PointAddAffine(&(r[i]), &(a[i]), b);
+    }
+}
+
+uint32_t p256PointsEqualAffine(const P256Point* points, size_t count, const P256Affine* b) {
+    uint32_t matches = 0;
+
+#ifdef RBC_HAVE_AVX512_TARGET
+    if (!p256AffineIsInfinity(b) && p256HasIfma()) {
+        return pointsEqualAffineIfma(points, count, b);
+    }
+#endif
+
+    for (size_t i = 0; i < count; i++) {
+        if (p256PointEqualsAffine(&(points[i]), b)) {
+            matches |= UINT32_C(1) << i;
+        }
+    }
+
+    return matches;
+}
+
+int p256AffineFromBytes(P256Affine* r, const unsigned char* oct) {
+    unsigned char bytes[P256_SCALAR_SIZE];
+    P256Fe lhs, rhs;
+
+    if (oct[0] != 0x04) {
+        return 1;
+    }
+
+    feFromBytes(&(r->x), oct + 1);
+    feFromBytes(&(r->y), oct + 1 + P256_SCALAR_SIZE);
+
+    // Converting a coordinate past p reduces it, so it won't convert back to the same bytes
+    feToBytes(bytes, &(r->x));
+    if (memcmp(bytes, oct + 1, P256_SCALAR_SIZE) != 0) {
+        return 1;
+    }
+
+    feToBytes(bytes, &(r->y));
+    if (memcmp(bytes, oct + 1 + P256_SCALAR_SIZE, P256_SCALAR_SIZE) != 0) {
+        return 1;
+    }
+
+    // y^2 = x^3 - 3x + b
+    feSqr(&lhs, &(r->y));
+    feSqr(&rhs, &(r->x));
+    feMul(&rhs, &rhs, &(r->x));
+    feSub(&rhs, &rhs, &(r->x));
+    feSub(&rhs, &rhs, &(r->x));
+    feSub(&rhs, &rhs, &(r->x));
+    feAdd(&rhs, &rhs, &kB);
+
+    return !feEqual(&lhs, &rhs);
+}
+
+void p256AffineToBytes(unsigned char* oct, const P256Affine* a) {
+    oct[0] = 0x04;
+    feToBytes(oct + 1, &(a->x));
+    feToBytes(oct + 1 + P256_SCALAR_SIZE, &(a->y));
+}
+
+P256Step* P256Step_create(size_t window_size) {
+    size_t bits = window_size * 8;
+    unsigned char lowest[P256_SCALAR_SIZE] = {0};
+    const P256Fe zero = {{0}};
+    P256Point* powers;
+    P256Affine* affine;
+    P256Step* step;
+
+    if (window_size == 0 || window_size > P256_SCALAR_SIZE ||
+        (step = calloc(1, sizeof(*step))) == NULL) {
+        return NULL;
+    }
+
+    step->window_size = window_size;
+    powers = malloc(bits * sizeof(*powers));
+    affine = malloc(bits * sizeof(*affine));
+
+    if ((step->points = malloc(bits * 2 * sizeof(*step->points))) == NULL || powers == NULL ||
+        affine == NULL) {
+        free(affine);
+        free(powers);
+        P256Step_destroy(step);
+
+        return NULL;
+    }
+
+    // powers[i] is 2^i·G for the i-th lowest scalar bit of the window, which starts at the last
+    // byte of the window, and each is the doubling of the one below it
+    lowest[window_size - 1] = 1;
+    p256ScalarMulBase(&(powers[0]), lowest);
+
+    for (size_t i = 1; i < bits; i++) {
+        p256PointDouble(&(powers[i]), &(powers[i - 1]));
+    }
+
+    // Made affine to take the cheaper mixed addition, sharing a single inversion between them all
+    p256BatchToAffine(affine, powers, bits);
+
+    for (size_t i = 0; i < bits; i++) {
+        // Byte j of the window holds scalar bits 8 * (window_size - 1 - j) and up of it
+        size_t j = (window_size - 1 - i / 8) * 8 + i % 8;
+
+        step->points[2 * j + 1] = affine[i];
+        step->points[2 * j].x = affine[i].x;
+        feSub(&(step->points[2 * j].y), &zero, &(affine[i].y));
+    }
+
+    free(affine);
+    free(powers);
+
+#ifdef RBC_HAVE_AVX512_TARGET
+    if (p256HasIfma()) {
+        if ((step->ifma_points = malloc(bits * 2 * IFMA_TABLE_STRIDE * sizeof(uint64_t))) == NULL) {
+            P256Step_destroy(step);
+
+            return NULL;
+        }
+
+        for (size_t i = 0; i < bits * 2; i++) {
+            feToIfma(step->ifma_points + i * IFMA_TABLE_STRIDE, &(step->points[i].x));
+            feToIfma(step->ifma_points + i * IFMA_TABLE_STRIDE + 5, &(step->points[i].y));
+        }
+    }
+#endif
+
+    return step;
+}
+
+void P256Step_destroy(P256Step* step) {
+    if (step == NULL) {
+        return;
+    }
+
+    free(step->ifma_points);
+    free(step->points);
+    free(step);
+}
+
+void P256Step_setBase(P256Step* step, const unsigned char* priv_key) {
+    p256ScalarMulBase(&(step->base_point), priv_key);
+    memcpy(step->base_key, priv_key, P256_SCALAR_SIZE);
+    step->has_base = 1;
+}
+
+/// Count how many bits two private keys differ by, as long as they only differ in the window.
+/// \return The count, or more than P256_STEP_MAX_FLIPS if the keys differ outside of the window or
+/// in more bits than that.
+static int countFlips(const P256Step* step, const unsigned char* from, const unsigned char* to) {
+    int flips = 0;
+
+    for (size_t i = 0; i < step->window_size && flips <= P256_STEP_MAX_FLIPS; i++) {
+        flips += __builtin_popcount(from[i] ^ to[i]);
+    }
+
+    if (memcmp(from + step->window_size, to + step->window_size,
+               P256_SCALAR_SIZE - step->window_size) != 0) {
+        return P256_STEP_MAX_FLIPS + 1;
+    }
+
+    return flips;
+}
+
+/// Step a public key from one private key to another by adding the point for every flipped bit.
+static void stepFrom(const P256Step* step, P256Point* point, const unsigned char* from,
+                     const unsigned char* priv_key) {
+    for (size_t i = 0; i < step->window_size; i++) {
+        unsigned int flipped = from[i] ^ priv_key[i];
+
+        while (flipped) {
+            unsigned int bit = (unsigned int)__builtin_ctz(flipped);
+
+            p256PointAddAffine(point, point,
+                               &(step->points[2 * (i * 8 + bit) + ((priv_key[i] >> bit) & 1)]));
+            flipped &= flipped - 1;
+        }
+    }
+}
+
+void P256Step_get(P256Step* step, P256Point* point, const unsigned char* priv_key) {
+    const unsigned char* from = step->priv_key;
+    int flips = P256_STEP_MAX_FLIPS + 1, base_flips;
+
+    if (step->has_key) {
+        flips = countFlips(step, step->priv_key, priv_key);
+    }
+
+    if (step->has_base && (base_flips = countFlips(step, step->base_key, priv_key)) < flips) {
+        *point = step->base_point;
+        flips = base_flips;
+        from = step->base_key;
+    }
+
+    if (flips > P256_STEP_MAX_FLIPS) {
+        p256ScalarMulBase(point, priv_key);
+    } else {
+        stepFrom(step, point, from, priv_key);
+    }
+
+    memcpy(step->priv_key, priv_key, P256_SCALAR_SIZE);
+    step->has_key = 1;
+}
+
+void P256Step_getLanes(P256Step* step, P256Point* points, const unsigned char* priv_keys,
+                       size_t count) {
+    size_t adds[P256_STEP_LANES][P256_STEP_MAX_FLIPS];
+    int add_counts[P256_STEP_LANES] = {0};
+    int ifma = step->ifma_points != NULL;
+
+    for (size_t lane = 0; lane < count && lane < P256_STEP_LANES; lane++) {
+        const unsigned char* priv_key = priv_keys + lane * P256_SCALAR_SIZE;
+        const unsigned char* from = NULL;
+        int flips = P256_STEP_MAX_FLIPS + 1, other_flips;
+
+        if ((step->has_lane_keys >> lane) & 1) {
+            flips = countFlips(step, step->lane_keys[lane], priv_key);
+            from = step->lane_keys[lane];
+        }
+
+        // Stepping from the lane before would keep the lanes from stepping all at once
+        if (!ifma && lane > 0 &&
+            (other_flips = countFlips(step, priv_key - P256_SCALAR_SIZE, priv_key)) < flips) {
+            points[lane] = points[lane - 1];
+            flips = other_flips;
+            from = priv_key - P256_SCALAR_SIZE;
+        }
+
+        if (step->has_base && (other_flips = countFlips(step, step->base_key, priv_key)) < flips) {
+            points[lane] = step->base_point;
+            flips = other_flips;
+            from = step->base_key;
+        }
+
+        if (flips > P256_STEP_MAX_FLIPS) {
+            p256ScalarMulBase(&(points[lane]), priv_key);
+        } else if (!ifma) {
+            stepFrom(step, &(points[lane]), from, priv_key);
+        } else {
+            for (size_t i = 0; i < step->window_size; i++) {
+                unsigned int flipped = from[i] ^ priv_key[i];
+
+                for (; flipped; flipped &= flipped - 1) {
+                    unsigned int bit = (unsigned int)__builtin_ctz(flipped);
+
+                    adds[lane][add_counts[lane]++] = 2 * (i * 8 + bit) + ((priv_key[i] >> bit) & 1);
+                }
+            }
+        }
+
+        memcpy(step->lane_keys[lane], priv_key, P256_SCALAR_SIZE);
+        step->has_lane_keys |= 1u << lane;
+    }
+
+#ifdef RBC_HAVE_AVX512_TARGET
+    if (ifma) {
+        stepLanesIfma(step, points, (const size_t(*)[P256_STEP_MAX_FLIPS])adds, add_counts);
+    }
+#endif
+}
@@ -0,0 +1,159 @@
+#ifndef RBC_VALIDATOR_CRYPTO_P256_H_
+#define RBC_VALIDATOR_CRYPTO_P256_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Field and group arithmetic for secp256r1 (P-256) over four 64-bit limbs in Montgomery form, for
+// working out the public keys of seeds that aren't secret to begin with. None of it runs in
+// constant time and nothing is allocated on the secure heap, unlike OpenSSL's EC_POINT functions,
+// which are built for one-off operations on secret scalars.
+
+#define P256_SCALAR_SIZE 32
+// 0x04 followed by the big-endian x and y coordinates
+#define P256_UNCOMPRESSED_SIZE 65
+// The most bits two private keys can differ by for P256Step_get to still step from one public key
+// to the other
+#define P256_STEP_MAX_FLIPS 16
+// How many private keys P256Step_getLanes works out at once, one per 64-bit lane of AVX-512
+#define P256_STEP_LANES 8
+
+/// A field element modulo p in Montgomery form, least significant limb first, always fully reduced.
+typedef struct P256Fe {
+    uint64_t v[4];
+} P256Fe;
+
+/// A point in Jacobian coordinates, standing for (x / z², y / z³), or infinity if z is 0.
+typedef struct P256Point {
+    P256Fe x, y, z;
+} P256Point;
+
+/// A point in affine coordinates. (0, 0) isn't on the curve, and stands for infinity.
+typedef struct P256Affine {
+    P256Fe x, y;
+} P256Affine;
+
+/// The P-256 version of EcStep, which works out the public keys of a run of private keys that each
+/// differ from the last in only a few bits by adding or subtracting 2^i·G for every flipped bit i.
+typedef struct P256Step {
+    // points[2 * j + b] is what setting bit j % 8 of byte j / 8 of the private key to b adds to its
+    // public key, for the leading window_size bytes of it
+    P256Affine* points;
+    size_t window_size;
+    // The private key whose public key was worked out last, if has_key is set
+    unsigned char priv_key[P256_SCALAR_SIZE];
+    int has_key;
+    // The base private key and its public key, if has_base is set
+    unsigned char base_key[P256_SCALAR_SIZE];
+    P256Point base_point;
+    int has_base;
+    // The private key each lane of P256Step_getLanes worked out last, if bit i of has_lane_keys is
+    // set for lane i
+    unsigned char lane_keys[P256_STEP_LANES][P256_SCALAR_SIZE];
+    unsigned int has_lane_keys;
+    // The points again as 52-bit limbs in Montgomery form for R = 2^260, x then y, for the AVX-512
+    // IFMA kernel, or NULL if the CPU doesn't have it
+    uint64_t* ifma_points;
+} P256Step;
+
+/// \param r The output point, which may be a.
+/// \param a The point to double.
+void p256PointDouble(P256Point* r, const P256Point* a);
+
+/// Add an affine point to a Jacobian one, taking care of infinity and of the points being equal.
+/// \param r The output point, which may be a.
+/// \param a A Jacobian point.
+/// \param b An affine point.
+void p256PointAddAffine(P256Point* r, const P256Point* a, const P256Affine* b);
+
+/// \param r The output point, which may be a.
+/// \param a The point to negate.
+void p256PointNegate(P256Point* r, const P256Point* a);
+
+/// \return Returns 1 if the affine point is infinity, or 0 if it isn't.
+int p256AffineIsInfinity(const P256Affine* a);
+
+/// \return Returns 1 if the CPU can run the AVX-512 IFMA kernel that p256PointsAddAffine,
+/// p256PointsEqualAffine, and P256Step_getLanes use for P256_STEP_LANES points at once, or 0 if
+/// they fall back to one point at a time.
+int p256HasIfma(void);
+
+/// Add the same affine point to several Jacobian points, like p256PointAddAffine.
+/// \param r The count output points, which may be a.
+/// \param a The count Jacobian points.
+/// \param b The affine point.
+/// \param count How many points there are.
+void p256PointsAddAffine(P256Point* r, const P256Point* a, const P256Affine* b, size_t count);
+
+/// Compare several Jacobian points against the same affine one, like p256PointEqualsAffine.
+/// \param points The count Jacobian points, at most 32.
+/// \param count How many points there are.
+/// \param b The affine point.
+/// \return A mask with bit i set if points[i] is the same as b.
+uint32_t p256PointsEqualAffine(const P256Point* points, size_t count, const P256Affine* b);
+
+/// Multiply the generator by a scalar.
+/// \param r The output point.
+/// \param scalar The big-endian scalar of P256_SCALAR_SIZE bytes, which doesn't have to be reduced.
+void p256ScalarMulBase(P256Point* r, const unsigned char* scalar);
+
+/// Make several points affine, sharing a single inversion between all of them.
+/// \param r The count output points.
+/// \param points The count points to make affine.
+/// \param count How many points there are.
+void p256BatchToAffine(P256Affine* r, const P256Point* points, size_t count);
+
+/// Compare a Jacobian point against an affine one by cross-multiplying with z, without inverting
+/// it.
+/// \return Returns 1 if the points are the same, or 0 if they aren't.
+int p256PointEqualsAffine(const P256Point* a, const P256Affine* b);
+
+/// \param r The output normal form limbs, least significant first.
+/// \param a The field element.
+void p256FeGet(uint64_t* r, const P256Fe* a);
+
+/// Parse an uncompressed point.
+/// \param r The output point.
+/// \param oct The P256_UNCOMPRESSED_SIZE byte point.
+/// \return Returns 0 on success, or 1 if the point isn't on the curve.
+int p256AffineFromBytes(P256Affine* r, const unsigned char* oct);
+
+/// \param oct The output P256_UNCOMPRESSED_SIZE byte point, or all zeros after the 0x04 for
+/// infinity.
+/// \param a The point.
+void p256AffineToBytes(unsigned char* oct, const P256Affine* a);
+
+/// Precompute the points for stepping between the public keys of private keys whose leading
+/// window_size bytes are the only ones that vary.
+/// \param window_size How many of the leading bytes can differ, up to P256_SCALAR_SIZE.
+/// \return A new P256Step, or NULL on error.
+P256Step* P256Step_create(size_t window_size);
+void P256Step_destroy(P256Step* step);
+
+/// Set the base private key to step from whenever it is closer than the last private key.
+/// \param step The P256Step.
+/// \param priv_key The base private key of P256_SCALAR_SIZE bytes.
+void P256Step_setBase(P256Step* step, const unsigned char* priv_key);
+
+/// Work out the public key of a private key, stepping from the one worked out by the last call or
+/// from the base, whichever differs from it by fewer bits, if that is at most P256_STEP_MAX_FLIPS
+/// bits all within the window, or else using p256ScalarMulBase.
+/// \param step The P256Step, which remembers the private key for the next call.
+/// \param point The public key. Must be the same point passed to the last call, left as it was.
+/// \param priv_key The private key of P256_SCALAR_SIZE bytes.
+void P256Step_get(P256Step* step, P256Point* point, const unsigned char* priv_key);
+
+/// Work out the public keys of up to P256_STEP_LANES private keys at once. Each lane steps like
+/// P256Step_get, but from the key that lane worked out on the last call rather than the last key
+/// of all, so that the lanes can step in lock-step on AVX-512 IFMA. Without it, a lane can also
+/// step from the lane before it.
+/// \param step The P256Step, which remembers each lane's private key for the next call.
+/// \param points The P256_STEP_LANES public keys, each the same point passed to the last call for
+/// its lane, left as it was.
+/// \param priv_keys The count private keys of P256_SCALAR_SIZE bytes, one after the other.
+/// \param count How many of the lanes to work out, at most P256_STEP_LANES. The rest are left as
+/// they are.
+void P256Step_getLanes(P256Step* step, P256Point* points, const unsigned char* priv_keys,
+                       size_t count);
+
+#endif  // RBC_VALIDATOR_CRYPTO_P256_H_
@@ -0,0 +1,579 @@
+#include "secp256k1.h"
+
+#include <gmp.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef unsigned __int128 uint128_t;
+
+// p = 2^256 - 2^32 - 977
+static const Secp256k1Fe kP = {{UINT64_C(0xfffffffefffffc2f), UINT64_C(0xffffffffffffffff),
+                                UINT64_C(0xffffffffffffffff), UINT64_C(0xffffffffffffffff)}};
+// 2^256 modulo p, which the top half of a product is folded back in by
+#define SECP256K1_FOLD UINT64_C(0x1000003d1)
+// A non-trivial cube root of unity modulo p, which the endomorphism multiplies x by
+static const Secp256k1Fe kBeta = {{UINT64_C(0xc1396c28719501ee), UINT64_C(0x9cf0497512f58995),
+                                   UINT64_C(0x6e64479eac3434e9), UINT64_C(0x7ae96a2b657c0710)}};
+static const Secp256k1Fe kOne = {{1, 0, 0, 0}};
+// The curve's b
+static const Secp256k1Fe kB = {{7, 0, 0, 0}};
+static const Secp256k1Affine kG = {
+        {{UINT64_C(0x59f2815b16f81798), UINT64_C(0x029bfcdb2dce28d9),
+          UINT64_C(0x55a06295ce870b07), UINT64_C(0x79be667ef9dcbbac)}},
+        {{UINT64_C(0x9c47d08ffb10d4b8), UINT64_C(0xfd17b448a6855419),
+          UINT64_C(0x5da4fbfc0e1108a8), UINT64_C(0x483ada7726a3c465)}}};
+
+// The group order n, and the short basis (a1, b1), (a2, b2) of the scalars the endomorphism maps
+// to 0, with b1 negated and b2 = a1, in hexadecimal
+static const char kOrderHex[] = "fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364141";
+static const char kA1Hex[] = "3086d221a7d46bcde86c90e49284eb15";
+static const char kMinusB1Hex[] = "e4437ed6010e88286f547fa90abfe4c3";
+static const char kA2Hex[] = "114ca50f7a8e2f3f657c1108d9d44cfd8";
+
+/// Subtract p from a 257-bit value if it is at least p.
+static inline void feReduce(Secp256k1Fe* r, const uint64_t* t, uint64_t carry) {
+    uint64_t d[4], borrow = 0;
+
+    for (int i = 0; i < 4; i++) {
+        uint128_t x = (uint128_t)t[i] - kP.v[i] - borrow;
+
+        d[i] = (uint64_t)x;
+        borrow = (uint64_t)(x >> 64) & 1;
+    }
+
+    // Keep t if subtracting p borrowed past the carry
+    if (borrow > carry) {
+        memcpy(r->v, t, sizeof(r->v));
+    } else {
+        memcpy(r->v, d, sizeof(r->v));
+    }
+}
+
+static inline void feAdd(Secp256k1Fe* r, const Secp256k1Fe* a, const Secp256k1Fe* b) {
+    uint64_t t[4], carry = 0;
+
+    for (int i = 0; i < 4; i++) {
+        uint128_t x = (uint128_t)a->v[i] + b->v[i] + carry;
+
+        t[i] = (uint64_t)x;
+        carry = (uint64_t)(x >> 64);
+    }
+
+    feReduce(r, t, carry);
+}
+
+static inline void feSub(Secp256k1Fe* r, const Secp256k1Fe* a, const Secp256k1Fe* b) {
+    uint64_t t[4], borrow = 0, carry = 0;
+
+    for (int i = 0; i < 4; i++) {
+        uint128_t x = (uint128_t)a->v[i] - b->v[i] - borrow;
+
+        t[i] = (uint64_t)x;
+        borrow = (uint64_t)(x >> 64) & 1;
+    }
+
+    // Add p back if it went negative
+    if (borrow) {
+        for (int i = 0; i < 4; i++) {
+            uint128_t x = (uint128_t)t[i] + kP.v[i] + carry;
+
+            t[i] = (uint64_t)x;
+            carry = (uint64_t)(x >> 64);
+        }
+    }
+
+    memcpy(r->v, t, sizeof(r->v));
+}
+
+/// Multiply two field elements, folding the top half of the product back into the bottom half
+/// as 2^256 = 2^32 + 977 modulo p.
+static inline void feMul(Secp256k1Fe* r, const Secp256k1Fe* a, const Secp256k1Fe* b) {
+    uint64_t t[8] = {0}, u[4], carry = 0;
+    uint128_t x;
+
+    for (int i = 0; i < 4; i++) {
+        carry = 0;
+
+        for (int j = 0; j < 4; j++) {
+            x = (uint128_t)a->v[j] * b->v[i] + t[i + j] + carry;
+            t[i + j] = (uint64_t)x;
+            carry = (uint64_t)(x >> 64);
+        }
+
+        t[i + 4] = carry;
+    }
+
+    carry = 0;
+
+    for (int i = 0; i < 4; i++) {
+        x = (uint128_t)t[4 + i] * SECP256K1_FOLD + t[i] + carry;
+        u[i] = (uint64_t)x;
+        carry = (uint64_t)(x >> 64);
+    }
+
+    // The carry is at most 34 bits, and folding it in again can only carry out if u wraps around
+    // to something small enough that the last fold can't
+    for (int fold = 0; fold < 2 && carry; fold++) {
+        x = (uint128_t)carry * SECP256K1_FOLD + u[0];
+        u[0] = (uint64_t)x;
+        carry = (uint64_t)(x >> 64);
+
+        for (int i = 1; i < 4; i++) {
+            x = (uint128_t)u[i] + carry;
+            u[i] = (uint64_t)x;
+            carry = (uint64_t)(x >> 64);
+        }
+    }
+
+    feReduce(r, u, 0);
+}
+
+static inline void feSqr(Secp256k1Fe* r, const Secp256k1Fe* a) {
+    feMul(r, a, a);
+}
+
+static inline int feIsZero(const Secp256k1Fe* a) {
+    return (a->v[0] | a->v[1] | a->v[2] | a->v[3]) == 0;
+}
+
+static inline int feEqual(const Secp256k1Fe* a, const Secp256k1Fe* b) {
+    return ((a->v[0] ^ b->v[0]) | (a->v[1] ^ b->v[1]) | (a->v[2] ^ b->v[2]) |
+            (a->v[3] ^ b->v[3])) == 0;
+}
+
+/// Invert a field element as a^(p - 2), or leave 0 as 0.
+static void feInv(Secp256k1Fe* r, const Secp256k1Fe* a) {
+    Secp256k1Fe result = kOne;
+
+    // p - 2 from its most significant bit down
+    for (int i = 255; i >= 0; i--) {
+        uint64_t limb = kP.v[i / 64] - (i < 64 ? 2 : 0);
+
+        feSqr(&result, &result);
+
+        if ((limb >> (i % 64)) & 1) {
+            feMul(&result, &result, a);
+        }
+    }
+
+    *r = result;
+}
+
+static void feFromBytes(Secp256k1Fe* r, const unsigned char* bytes) {
+    for (int i = 0; i < 4; i++) {
+        r->v[i] = 0;
+
+        for (int j = 0; j < 8; j++) {
+            r->v[i] = (r->v[i] << 8) | bytes[(3 - i) * 8 + j];
+        }
+    }
+}
+
+static void feToBytes(unsigned char* bytes, const Secp256k1Fe* a) {
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 8; j++) {
+            bytes[(3 - i) * 8 + j] = (unsigned char)(a->v[i] >> (56 - j * 8));
+        }
+    }
+}
+
+void secp256k1PointDouble(Secp256k1Point* r, const Secp256k1Point* a) {
+    Secp256k1Fe xx, yy, yyyy, d, e, t0;
+
+    if (feIsZero(&(a->z))) {
+        *r = *a;
+
+        return;
+    }
+
+    // dbl-2009-l, for a = 0
+    feSqr(&xx, &(a->x));
+    feSqr(&yy, &(a->y));
+    feSqr(&yyyy, &yy);
+
+    // d = 2 * ((x + yy)^2 - xx - yyyy)
+    feAdd(&t0, &(a->x), &yy);
+    feSqr(&t0, &t0);
+    feSub(&t0, &t0, &xx);
+    feSub(&t0, &t0, &yyyy);
+    feAdd(&d, &t0, &t0);
+
+    // e = 3 * xx
+    feAdd(&e, &xx, &xx);
+    feAdd(&e, &e, &xx);
+
+    // z3 = 2 * y * z, worked out first since r may be a
+    feMul(&t0, &(a->y), &(a->z));
+    feAdd(&(r->z), &t0, &t0);
+
+    // x3 = e^2 - 2 * d
+    feSqr(&t0, &e);
+    feSub(&t0, &t0, &d);
+    feSub(&(r->x), &t0, &d);
+
+    // y3 = e * (d - x3) - 8 * yyyy
+    feSub(&t0, &d, &(r->x));
+    feMul(&t0, &e, &t0);
+    feAdd(&yyyy, &yyyy, &yyyy);
+    feAdd(&yyyy, &yyyy, &yyyy);
+    feAdd(&yyyy, &yyyy, &yyyy);
+    feSub(&(r->y), &t0, &yyyy);
+}
+
+void secp256k1PointAddAffine(Secp256k1Point* r, const Secp256k1Point* a, const Secp256k1Affine* b) {
+    Secp256k1Fe z1z1, u2, s2, h, hh, i, j, rr, v, t0;
+
+    if (secp256k1AffineIsInfinity(b)) {
+        *r = *a;
+
+        return;
+    }
+
+    if (feIsZero(&(a->z))) {
+        r->x = b->x;
+        r->y = b->y;
+        r->z = kOne;
+
+        return;
+    }
+
+    // madd-2007-bl
+    feSqr(&z1z1, &(a->z));
+    feMul(&u2, &(b->x), &z1z1);
+    feMul(&s2, &(a->z), &z1z1);
+    feMul(&s2, &(b->y), &s2);
+    feSub(&h, &u2, &(a->x));
+    feSub(&rr, &s2, &(a->y));
+
+    if (feIsZero(&h)) {
+        if (feIsZero(&rr)) {
+            secp256k1PointDouble(r, a);
+        } else {
+            memset(r, 0, sizeof(*r));
+        }
+
+        return;
+    }
+
+    feAdd(&rr, &rr, &rr);
+    feSqr(&hh, &h);
+    feAdd(&i, &hh, &hh);
+    feAdd(&i, &i, &i);
+    feMul(&j, &h, &i);
+    feMul(&v, &(a->x), &i);
+
+    // z3 = (z1 + h)^2 - z1z1 - hh, worked out first since r may be a
+    feAdd(&t0, &(a->z), &h);
+    feSqr(&t0, &t0);
+    feSub(&t0, &t0, &z1z1);
+    feSub(&(r->z), &t0, &hh);
+
+    // y1 * j before x3 overwrites anything
+    feMul(&t0, &(a->y), &j);
+    feAdd(&t0, &t0, &t0);
+
+    // x3 = rr^2 - j - 2 * v
+    feSqr(&(r->x), &rr);
+    feSub(&(r->x), &(r->x), &j);
+    feSub(&(r->x), &(r->x), &v);
+    feSub(&(r->x), &(r->x), &v);
+
+    // y3 = rr * (v - x3) - 2 * y1 * j
+    feSub(&v, &v, &(r->x));
+    feMul(&v, &rr, &v);
+    feSub(&(r->y), &v, &t0);
+}
+
+int secp256k1AffineIsInfinity(const Secp256k1Affine* a) {
+    return feIsZero(&(a->x)) && feIsZero(&(a->y));
+}
+
+void secp256k1ScalarMulBase(Secp256k1Point* r, const unsigned char* scalar) {
+    const Secp256k1Fe zero = {{0}};
+    Secp256k1Affine g = kG, lambda_g;
+    Secp256k1Point result;
+    mpz_t k, k1, k2, c1, c2, t, n, a1, minus_b1, a2;
+    size_t bits;
+
+    mpz_inits(k, k1, k2, c1, c2, t, NULL);
+    mpz_init_set_str(n, kOrderHex, 16);
+    mpz_init_set_str(a1, kA1Hex, 16);
+    mpz_init_set_str(minus_b1, kMinusB1Hex, 16);
+    mpz_init_set_str(a2, kA2Hex, 16);
+
+    mpz_import(k, SECP256K1_SCALAR_SIZE, 1, 1, 1, 0, scalar);
+    mpz_mod(k, k, n);
+
+    // Split k = k1 + k2·λ, with c1 = round(b2·k / n) and c2 = round(-b1·k / n), leaving
+    // k1 = k - c1·a1 - c2·a2 and k2 = -c1·b1 - c2·b2 at about 128 bits each
+    mpz_mul(c1, a1, k);
+    mpz_mul(c2, minus_b1, k);
+    mpz_tdiv_q_2exp(t, n, 1);
+    mpz_add(c1, c1, t);
+    mpz_add(c2, c2, t);
+    mpz_fdiv_q(c1, c1, n);
+    mpz_fdiv_q(c2, c2, n);
+
+    mpz_mul(t, c1, a1);
+    mpz_sub(k1, k, t);
+    mpz_mul(t, c2, a2);
+    mpz_sub(k1, k1, t);
+
+    mpz_mul(k2, c1, minus_b1);
+    mpz_mul(t, c2, a1);
+    mpz_sub(k2, k2, t);
+
+    // λ·G is (β·x, y), and each half's sign goes on its point instead
+    feMul(&(lambda_g.x), &kBeta, &(kG.x));
+    lambda_g.y = kG.y;
+
+    if (mpz_sgn(k1) < 0) {
+        feSub(&(g.y), &zero, &(g.y));
+        mpz_neg(k1, k1);
+    }
+
+    if (mpz_sgn(k2) < 0) {
+        feSub(&(lambda_g.y), &zero, &(lambda_g.y));
+        mpz_neg(k2, k2);
+    }
+
+    memset(&result, 0, sizeof(result));
+    bits = mpz_sizeinbase(k1, 2) > mpz_sizeinbase(k2, 2) ? mpz_sizeinbase(k1, 2)
+                                                         : mpz_sizeinbase(k2, 2);
+
+    // Both halves share the same doublings
+    for (size_t i = bits; i-- > 0;) {
+        secp256k1PointDouble(&result, &result);
+
+        if (mpz_tstbit(k1, i)) {
+            secp256k1PointAddAffine(&result, &result, &g);
+        }
+
+        if (mpz_tstbit(k2, i)) {
+            secp256k1PointAddAffine(&result, &result, &lambda_g);
+        }
+    }
+
+    mpz_clears(k, k1, k2, c1, c2, t, n, a1, minus_b1, a2, NULL);
+
+    *r = result;
+}
+
+void secp256k1BatchToAffine(Secp256k1Affine* r, const Secp256k1Point* points, size_t count) {
+    Secp256k1Fe inv, z_inv, z_inv2;
+
+    if (count == 0) {
+        return;
+    }
+
+    // Montgomery's trick, with r[i].x holding the product of every z up to i, skipping infinity
+    for (size_t i = 0; i < count; i++) {
+        const Secp256k1Fe* prev = i > 0 ? &(r[i - 1].x) : &kOne;
+
+        if (feIsZero(&(points[i].z))) {
+            r[i].x = *prev;
+        } else {
+            feMul(&(r[i].x), prev, &(points[i].z));
+        }
+    }
+
+    feInv(&inv, &(r[count - 1].x));
+
+    for (size_t i = count; i-- > 0;) {
+        if (feIsZero(&(points[i].z))) {
+            memset(&(r[i]), 0, sizeof(r[i]));
+            continue;
+        }
+
+        // The inverse of this z is the inverse of the product up to it times the product before it
+        if (i > 0) {
+            feMul(&z_inv, &inv, &(r[i - 1].x));
+            feMul(&inv, &inv, &(points[i].z));
+        } else {
+            z_inv = inv;
+        }
+
+        feSqr(&z_inv2, &z_inv);
+        feMul(&(r[i].x), &(points[i].x), &z_inv2);
+        feMul(&z_inv2, &z_inv2, &z_inv);
+        feMul(&(r[i].y), &(points[i].y), &z_inv2);
+    }
+}
+
+int secp256k1PointEqualsAffine(const Secp256k1Point* a, const Secp256k1Affine* b) {
+    Secp256k1Fe z2, t;
+
+    if (feIsZero(&(a->z))) {
+        return secp256k1AffineIsInfinity(b);
+    }
+
+    // x = b.x * z^2, and only then y = b.y * z^3
+    feSqr(&z2, &(a->z));
+    feMul(&t, &(b->x), &z2);
+
+    if (!feEqual(&t, &(a->x))) {
+        return 0;
+    }
+
+    feMul(&z2, &z2, &(a->z));
+    feMul(&t, &(b->y), &z2);
+
+    return feEqual(&t, &(a->y));
+}
+
+int secp256k1AffineFromBytes(Secp256k1Affine* r, const unsigned char* oct) {
+    Secp256k1Fe lhs, rhs;
+    uint64_t borrow_x = 0, borrow_y = 0;
+
+    if (oct[0] != 0x04) {
+        return 1;
+    }
+
+    feFromBytes(&(r->x), oct + 1);
+    feFromBytes(&(r->y), oct + 1 + SECP256K1_SCALAR_SIZE);
+
+    // Both coordinates have to be below p
+    for (int i = 0; i < 4; i++) {
+        borrow_x = (uint64_t)(((uint128_t)r->x.v[i] - kP.v[i] - borrow_x) >> 64) & 1;
+        borrow_y = (uint64_t)(((uint128_t)r->y.v[i] - kP.v[i] - borrow_y) >> 64) & 1;
+    }
+
+    if (!borrow_x || !borrow_y) {
+        return 1;
+    }
+
+    // y^2 = x^3 + 7
+    feSqr(&lhs, &(r->y));
+    feSqr(&rhs, &(r->x));
+    feMul(&rhs, &rhs, &(r->x));
+    feAdd(&rhs, &rhs, &kB);
+
+    return !feEqual(&lhs, &rhs);
+}
+
+void secp256k1AffineToBytes(unsigned char* oct, const Secp256k1Affine* a) {
+    oct[0] = 0x04;
+    feToBytes(oct + 1, &(a->x));
+    feToBytes(oct + 1 + SECP256K1_SCALAR_SIZE, &(a->y));
+}
+
+Secp256k1Step* Secp256k1Step_create(size_t window_size) {
+    size_t bits = window_size * 8;
+    unsigned char lowest[SECP256K1_SCALAR_SIZE] = {0};
+    const Secp256k1Fe zero = {{0}};
+    Secp256k1Point* powers;
+    Secp256k1Affine* affine;
+    Secp256k1Step* step;
+
+    if (window_size == 0 || window_size > SECP256K1_SCALAR_SIZE ||
+        (step = calloc(1, sizeof(*step))) == NULL) {
+        return NULL;
+    }
+
+    step->window_size = window_size;
+    powers = malloc(bits * sizeof(*powers));
+    affine = malloc(bits * sizeof(*affine));
+
+    if ((step->points = malloc(bits * 2 * sizeof(*step->points))) == NULL || powers == NULL ||
+        affine == NULL) {
+        free(affine);
+        free(powers);
+        Secp256k1Step_destroy(step);
+
+        return NULL;
+    }
+
+    // powers[i] is 2^i·G for the i-th lowest scalar bit of the window, which starts at the last
+    // byte of the window, and each is the doubling of the one below it
+    lowest[window_size - 1] = 1;
+    secp256k1ScalarMulBase(&(powers[0]), lowest);
+
+    for (size_t i = 1; i < bits; i++) {
+        secp256k1PointDouble(&(powers[i]), &(powers[i - 1]));
+    }
+
+    secp256k1BatchToAffine(affine, powers, bits);
+
+    for (size_t i = 0; i < bits; i++) {
+        // Byte j of the window holds scalar bits 8 * (window_size - 1 - j) and up of it
+        size_t j = (window_size - 1 - i / 8) * 8 + i % 8;
+
+        step->points[2 * j + 1] = affine[i];
+        step->points[2 * j].x = affine[i].x;
+        feSub(&(step->points[2 * j].y), &zero, &(affine[i].y));
+    }
+
+    free(affine);
+    free(powers);
+
+    return step;
+}
+
+void Secp256k1Step_destroy(Secp256k1Step* step) {
+    if (step == NULL) {
+        return;
+    }
+
+    free(step->points);
+    free(step);
+}
+
+void Secp256k1Step_setBase(Secp256k1Step* step, const unsigned char* priv_key) {
+    secp256k1ScalarMulBase(&(step->base_point), priv_key);
+    memcpy(step->base_key, priv_key, SECP256K1_SCALAR_SIZE);
+    step->has_base = 1;
+}
+
+/// Count how many bits two private keys differ by, as long as they only differ in the window.
+/// \return The count, or more than SECP256K1_STEP_MAX_FLIPS if the keys differ outside of the
+/// window or in more bits than that.
+static int countFlips(const Secp256k1Step* step, const unsigned char* from,
+                      const unsigned char* to) {
+    int flips = 0;
+
+    for (size_t i = 0; i < step->window_size && flips <= SECP256K1_STEP_MAX_FLIPS; i++) {
+        flips += __builtin_popcount(from[i] ^ to[i]);
+    }
+
+    if (memcmp(from + step->window_size, to + step->window_size,
+               SECP256K1_SCALAR_SIZE - step->window_size) != 0) {
+        return SECP256K1_STEP_MAX_FLIPS + 1;
+    }
+
+    return flips;
+}
+
+void Secp256k1Step_get(Secp256k1Step* step, Secp256k1Point* point, const unsigned char* priv_key) {
+    const unsigned char* from = step->priv_key;
+    int flips = SECP256K1_STEP_MAX_FLIPS + 1, base_flips;
+
+    if (step->has_key) {
+        flips = countFlips(step, step->priv_key, priv_key);
+    }
+
+    if (step->has_base && (base_flips = countFlips(step, step->base_key, priv_key)) < flips) {
+        *point = step->base_point;
+        flips = base_flips;
+        from = step->base_key;
+    }
+
+    if (flips > SECP256K1_STEP_MAX_FLIPS) {
+        secp256k1ScalarMulBase(point, priv_key);
+    } else {
+        for (size_t i = 0; i < step->window_size; i++) {
+            unsigned int flipped = from[i] ^ priv_key[i];
+
+            while (flipped) {
+                unsigned int bit = (unsigned int)__builtin_ctz(flipped);
+
+                secp256k1PointAddAffine(
+                        point, point,
+                        &(step->points[2 * (i * 8 + bit) + ((priv_key[i] >> bit) & 1)]));
+                flipped &= flipped - 1;
+            }
+        }
+    }
+
+    memcpy(step->priv_key, priv_key, SECP256K1_SCALAR_SIZE);
+    step->has_key = 1;
+}
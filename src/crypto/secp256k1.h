@@ -0,0 +1,110 @@
+#ifndef RBC_VALIDATOR_CRYPTO_SECP256K1_H_
+#define RBC_VALIDATOR_CRYPTO_SECP256K1_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Field and group arithmetic for secp256k1 over four 64-bit limbs, in the same vein as p256.h and
+// with the same caveats: none of it runs in constant time, since the seeds being searched aren't
+// secret. Since p = 2^256 - 2^32 - 977, products are reduced by folding their top half back in
+// rather than with Montgomery multiplication. Scalar multiplication splits the scalar in two
+// halves of about 128 bits with the GLV endomorphism, which maps (x, y) to (β·x, y) = λ·(x, y),
+// so that it takes half as many doublings.
+
+#define SECP256K1_SCALAR_SIZE 32
+// 0x04 followed by the big-endian x and y coordinates
+#define SECP256K1_UNCOMPRESSED_SIZE 65
+// The most bits two private keys can differ by for Secp256k1Step_get to still step from one
+// public key to the other
+#define SECP256K1_STEP_MAX_FLIPS 16
+
+/// A field element modulo p, least significant limb first, always fully reduced.
+typedef struct Secp256k1Fe {
+    uint64_t v[4];
+} Secp256k1Fe;
+
+/// A point in Jacobian coordinates, standing for (x / z², y / z³), or infinity if z is 0.
+typedef struct Secp256k1Point {
+    Secp256k1Fe x, y, z;
+} Secp256k1Point;
+
+/// A point in affine coordinates. (0, 0) isn't on the curve, and stands for infinity.
+typedef struct Secp256k1Affine {
+    Secp256k1Fe x, y;
+} Secp256k1Affine;
+
+/// The secp256k1 version of P256Step.
+typedef struct Secp256k1Step {
+    // points[2 * j + b] is what setting bit j % 8 of byte j / 8 of the private key to b adds to its
+    // public key, for the leading window_size bytes of it
+    Secp256k1Affine* points;
+    size_t window_size;
+    // The private key whose public key was worked out last, if has_key is set
+    unsigned char priv_key[SECP256K1_SCALAR_SIZE];
+    int has_key;
+    // The base private key and its public key, if has_base is set
+    unsigned char base_key[SECP256K1_SCALAR_SIZE];
+    Secp256k1Point base_point;
+    int has_base;
+} Secp256k1Step;
+
+/// \param r The output point, which may be a.
+/// \param a The point to double.
+void secp256k1PointDouble(Secp256k1Point* r, const Secp256k1Point* a);
+
+/// Add an affine point to a Jacobian one, taking care of infinity and of the points being equal.
+/// \param r The output point, which may be a.
+/// \param a A Jacobian point.
+/// \param b An affine point.
+void secp256k1PointAddAffine(Secp256k1Point* r, const Secp256k1Point* a, const Secp256k1Affine* b);
+
+/// \return Returns 1 if the affine point is infinity, or 0 if it isn't.
+int secp256k1AffineIsInfinity(const Secp256k1Affine* a);
+
+/// Multiply the generator by a scalar, split into two halves with the GLV endomorphism.
+/// \param r The output point.
+/// \param scalar The big-endian scalar of SECP256K1_SCALAR_SIZE bytes, which doesn't have to be
+/// reduced.
+void secp256k1ScalarMulBase(Secp256k1Point* r, const unsigned char* scalar);
+
+/// Make several points affine, sharing a single inversion between all of them.
+/// \param r The count output points.
+/// \param points The count points to make affine.
+/// \param count How many points there are.
+void secp256k1BatchToAffine(Secp256k1Affine* r, const Secp256k1Point* points, size_t count);
+
+/// Compare a Jacobian point against an affine one by cross-multiplying with z, without inverting
+/// it.
+/// \return Returns 1 if the points are the same, or 0 if they aren't.
+int secp256k1PointEqualsAffine(const Secp256k1Point* a, const Secp256k1Affine* b);
+
+/// Parse an uncompressed point.
+/// \param r The output point.
+/// \param oct The SECP256K1_UNCOMPRESSED_SIZE byte point.
+/// \return Returns 0 on success, or 1 if the point isn't on the curve.
+int secp256k1AffineFromBytes(Secp256k1Affine* r, const unsigned char* oct);
+
+/// \param oct The output SECP256K1_UNCOMPRESSED_SIZE byte point, or all zeros after the 0x04 for
+/// infinity.
+/// \param a The point.
+void secp256k1AffineToBytes(unsigned char* oct, const Secp256k1Affine* a);
+
+/// Precompute the points for stepping between the public keys of private keys whose leading
+/// window_size bytes are the only ones that vary.
+/// \param window_size How many of the leading bytes can differ, up to SECP256K1_SCALAR_SIZE.
+/// \return A new Secp256k1Step, or NULL on error.
+Secp256k1Step* Secp256k1Step_create(size_t window_size);
+void Secp256k1Step_destroy(Secp256k1Step* step);
+
+/// Set the base private key to step from whenever it is closer than the last private key.
+/// \param step The Secp256k1Step.
+/// \param priv_key The base private key of SECP256K1_SCALAR_SIZE bytes.
+void Secp256k1Step_setBase(Secp256k1Step* step, const unsigned char* priv_key);
+
+/// Work out the public key of a private key the same way P256Step_get does.
+/// \param step The Secp256k1Step, which remembers the private key for the next call.
+/// \param point The public key. Must be the same point passed to the last call, left as it was.
+/// \param priv_key The private key of SECP256K1_SCALAR_SIZE bytes.
+void Secp256k1Step_get(Secp256k1Step* step, Secp256k1Point* point, const unsigned char* priv_key);
+
+#endif  // RBC_VALIDATOR_CRYPTO_SECP256K1_H_
@@ -0,0 +1,467 @@
+#include "x25519.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef unsigned __int128 uint128_t;
+
+// p = 2^255 - 19
+static const X25519Fe kP = {{UINT64_C(0xffffffffffffffed), UINT64_C(0xffffffffffffffff),
+                             UINT64_C(0xffffffffffffffff), UINT64_C(0x7fffffffffffffff)}};
+// 2^256 modulo p, which the top half of a product is folded back in by
+#define X25519_FOLD 38
+// 2·d, for the curve's d = -121665 / 121666
+static const X25519Fe kD2 = {{UINT64_C(0xebd69b9426b2f159), UINT64_C(0x00e0149a8283b156),
+                              UINT64_C(0x198e80f2eef3d130), UINT64_C(0x2406d9dc56dffce7)}};
+static const X25519Fe kOne = {{1, 0, 0, 0}};
+// The base point, whose u-coordinate is 9, with y = 4 / 5 and x even
+static const X25519Fe kBaseX = {{UINT64_C(0xc9562d608f25d51a), UINT64_C(0x692cc7609525a7b2),
+                                 UINT64_C(0xc0a4e231fdd6dc5c), UINT64_C(0x216936d3cd6e53fe)}};
+static const X25519Fe kBaseY = {{UINT64_C(0x6666666666666658), UINT64_C(0x6666666666666666),
+                                 UINT64_C(0x6666666666666666), UINT64_C(0x6666666666666666)}};
+
+/// Fully reduce any 256-bit value by folding its top bit back in as 19, and then subtracting p if
+/// it is still at least p.
+static inline void feReduce(X25519Fe* r, const uint64_t* t) {
+    uint64_t u[4], d[4], carry = (t[3] >> 63) * 19, borrow = 0;
+
+    for (int i = 0; i < 4; i++) {
+        uint128_t x = (uint128_t)(i == 3 ? t[i] & (UINT64_MAX >> 1) : t[i]) + carry;
+
+        u[i] = (uint64_t)x;
+        carry = (uint64_t)(x >> 64);
+    }
+
+    for (int i = 0; i < 4; i++) {
+        uint128_t x = (uint128_t)u[i] - kP.v[i] - borrow;
+
+        d[i] = (uint64_t)x;
+        borrow = (uint64_t)(x >> 64) & 1;
+    }
+
+    // Keep u if subtracting p borrowed
+    memcpy(r->v, borrow ? u : d, sizeof(r->v));
+}
+
+static inline void feAdd(X25519Fe* r, const X25519Fe* a, const X25519Fe* b) {
+    uint64_t t[4], carry = 0;
+
+    // Both are below 2^255, so the sum can't carry out
+    for (int i = 0; i < 4; i++) {
+        uint128_t x = (uint128_t)a->v[i] + b->v[i] + carry;
+
+        t[i] = (uint64_t)x;
+        carry = (uint64_t)(x >> 64);
+    }
+
+    feReduce(r, t);
+}
+
+static inline void feSub(X25519Fe* r, const X25519Fe* a, const X25519Fe* b) {
+    uint64_t t[4], borrow = 0, carry = 0;
+
+    for (int i = 0; i < 4; i++) {
+        uint128_t x = (uint128_t)a->v[i] - b->v[i] - borrow;
+
+        t[i] = (uint64_t)x;
+        borrow = (uint64_t)(x >> 64) & 1;
+    }
+
+    // Add p back if it went negative
+    if (borrow) {
+        for (int i = 0; i < 4; i++) {
+            uint128_t x = (uint128_t)t[i] + kP.v[i] + carry;
+
+            t[i] = (uint64_t)x;
+            carry = (uint64_t)(x >> 64);
+        }
+    }
+
+    memcpy(r->v, t, sizeof(r->v));
+}
+
+static inline void feNeg(X25519Fe* r, const X25519Fe* a) {
+    const X25519Fe zero = {{0}};
+
+    feSub(r, &zero, a);
+}
+
+/// Multiply two field elements, folding the top half of the product back into the bottom half
+/// as 2^256 = 38 modulo p.
+static inline void feMul(X25519Fe* r, const X25519Fe* a, const X25519Fe* b) {
+    uint64_t t[8] = {0}, u[4], carry;
+    uint128_t x;
+
+    for (int i = 0; i < 4; i++) {
+        carry = 0;
+
+        for (int j = 0; j < 4; j++) {
+            x = (uint128_t)a->v[j] * b->v[i] + t[i + j] + carry;
+            t[i + j] = (uint64_t)x;
+            carry = (uint64_t)(x >> 64);
+        }
+
+        t[i + 4] = carry;
+    }
+
+    carry = 0;
+
+    for (int i = 0; i < 4; i++) {
+        x = (uint128_t)t[4 + i] * X25519_FOLD + t[i] + carry;
+        u[i] = (uint64_t)x;
+        carry = (uint64_t)(x >> 64);
+    }
+
+    // The carry is at most 6 bits, and folding it in again can only carry out if u wraps around
+    // to something small enough that the last fold can't
+    for (int fold = 0; fold < 2 && carry; fold++) {
+        x = (uint128_t)carry * X25519_FOLD + u[0];
+        u[0] = (uint64_t)x;
+        carry = (uint64_t)(x >> 64);
+
+        for (int i = 1; i < 4; i++) {
+            x = (uint128_t)u[i] + carry;
+            u[i] = (uint64_t)x;
+            carry = (uint64_t)(x >> 64);
+        }
+    }
+
+    feReduce(r, u);
+}
+
+static inline void feSqr(X25519Fe* r, const X25519Fe* a) {
+    feMul(r, a, a);
+}
+
+static inline int feEqual(const X25519Fe* a, const X25519Fe* b) {
+    return ((a->v[0] ^ b->v[0]) | (a->v[1] ^ b->v[1]) | (a->v[2] ^ b->v[2]) |
+            (a->v[3] ^ b->v[3])) == 0;
+}
+
+/// Invert a field element as a^(p - 2), or leave 0 as 0.
+static void feInv(X25519Fe* r, const X25519Fe* a) {
+    X25519Fe result = kOne;
+
+    // p - 2 from its most significant bit down
+    for (int i = 254; i >= 0; i--) {
+        uint64_t limb = kP.v[i / 64] - (i < 64 ? 2 : 0);
+
+        feSqr(&result, &result);
+
+        if ((limb >> (i % 64)) & 1) {
+            feMul(&result, &result, a);
+        }
+    }
+
+    *r = result;
+}
+
+/// Read a little-endian field element, ignoring its highest bit as X25519 does.
+static void feFromBytes(X25519Fe* r, const unsigned char* bytes) {
+    uint64_t t[4];
+
+    for (int i = 0; i < 4; i++) {
+        t[i] = 0;
+
+        for (int j = 7; j >= 0; j--) {
+            t[i] = (t[i] << 8) | bytes[i * 8 + j];
+        }
+    }
+
+    t[3] &= UINT64_MAX >> 1;
+    feReduce(r, t);
+}
+
+static void feToBytes(unsigned char* bytes, const X25519Fe* a) {
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 8; j++) {
+            bytes[i * 8 + j] = (unsigned char)(a->v[i] >> (j * 8));
+        }
+    }
+}
+
+/// Make several points affine, sharing a single inversion between all of them, in the form
+/// x25519PointAddNiels takes.
+/// \param r The count output points.
+/// \param points The count points to make affine.
+/// \param count How many points there are, at least 1.
+static void pointsToNiels(X25519Niels* r, const X25519Point* points, size_t count) {
+    X25519Fe inv, z_inv, x, y;
+
+    // Montgomery's trick, with r[i].xy2d holding the product of every z up to i, none of which
+    // are 0 on a complete curve
+    r[0].xy2d = points[0].z;
+
+    for (size_t i = 1; i < count; i++) {
+        feMul(&(r[i].xy2d), &(r[i - 1].xy2d), &(points[i].z));
+    }
+
+    feInv(&inv, &(r[count - 1].xy2d));
+
+    for (size_t i = count; i-- > 0;) {
+        // The inverse of this z is the inverse of the product up to it times the product before it
+        if (i > 0) {
+            feMul(&z_inv, &inv, &(r[i - 1].xy2d));
+            feMul(&inv, &inv, &(points[i].z));
+        } else {
+            z_inv = inv;
+        }
+
+        feMul(&x, &(points[i].x), &z_inv);
+        feMul(&y, &(points[i].y), &z_inv);
+        feAdd(&(r[i].y_plus_x), &y, &x);
+        feSub(&(r[i].y_minus_x), &y, &x);
+        feMul(&(r[i].xy2d), &x, &y);
+        feMul(&(r[i].xy2d), &(r[i].xy2d), &kD2);
+    }
+}
+
+void x25519Clamp(unsigned char* r, const unsigned char* priv_key) {
+    memmove(r, priv_key, X25519_KEY_SIZE);
+    r[0] &= 248;
+    r[X25519_KEY_SIZE - 1] &= 127;
+    r[X25519_KEY_SIZE - 1] |= 64;
+}
+
+void x25519PointDouble(X25519Point* r, const X25519Point* a) {
+    X25519Fe xx, yy, zz2, e, f, g, h;
+
+    // dbl-2008-hwcd, for a = -1
+    feSqr(&xx, &(a->x));
+    feSqr(&yy, &(a->y));
+    feSqr(&zz2, &(a->z));
+    feAdd(&zz2, &zz2, &zz2);
+
+    // e = (x + y)^2 - xx - yy
+    feAdd(&e, &(a->x), &(a->y));
+    feSqr(&e, &e);
+    feSub(&e, &e, &xx);
+    feSub(&e, &e, &yy);
+
+    // g = yy - xx, f = g - 2 * z^2, h = -xx - yy
+    feSub(&g, &yy, &xx);
+    feSub(&f, &g, &zz2);
+    feAdd(&h, &xx, &yy);
+    feNeg(&h, &h);
+
+    feMul(&(r->x), &e, &f);
+    feMul(&(r->y), &g, &h);
+    feMul(&(r->t), &e, &h);
+    feMul(&(r->z), &f, &g);
+}
+
+void x25519PointAddNiels(X25519Point* r, const X25519Point* a, const X25519Niels* b) {
+    X25519Fe pa, pb, c, d, e, f, g, h;
+
+    // madd-2008-hwcd-3, for a = -1
+    feSub(&pa, &(a->y), &(a->x));
+    feMul(&pa, &pa, &(b->y_minus_x));
+    feAdd(&pb, &(a->y), &(a->x));
+    feMul(&pb, &pb, &(b->y_plus_x));
+    feMul(&c, &(a->t), &(b->xy2d));
+    feAdd(&d, &(a->z), &(a->z));
+
+    feSub(&e, &pb, &pa);
+    feSub(&f, &d, &c);
+    feAdd(&g, &d, &c);
+    feAdd(&h, &pb, &pa);
+
+    feMul(&(r->x), &e, &f);
+    feMul(&(r->y), &g, &h);
+    feMul(&(r->t), &e, &h);
+    feMul(&(r->z), &f, &g);
+}
+
+/// \param r The output base point, ready to add.
+static void baseNiels(X25519Niels* r) {
+    feAdd(&(r->y_plus_x), &kBaseY, &kBaseX);
+    feSub(&(r->y_minus_x), &kBaseY, &kBaseX);
+    feMul(&(r->xy2d), &kBaseX, &kBaseY);
+    feMul(&(r->xy2d), &(r->xy2d), &kD2);
+}
+
+void x25519ScalarMulBase(X25519Point* r, const unsigned char* priv_key) {
+    unsigned char scalar[X25519_KEY_SIZE];
+    X25519Niels base;
+    X25519Point result = {{{0}}, kOne, kOne, {{0}}};
+
+    x25519Clamp(scalar, priv_key);
+    baseNiels(&base);
+
+    // Bit 254 is always the highest one set
+    for (int i = 254; i >= 0; i--) {
+        x25519PointDouble(&result, &result);
+
+        if ((scalar[i / 8] >> (i % 8)) & 1) {
+            x25519PointAddNiels(&result, &result, &base);
+        }
+    }
+
+    *r = result;
+}
+
+void x25519PointToBytes(unsigned char* pub_key, const X25519Point* a) {
+    X25519Fe num, den;
+
+    // u = (1 + y) / (1 - y) = (z + y) / (z - y), which leaves the identity at 0 as X25519 does
+    feAdd(&num, &(a->z), &(a->y));
+    feSub(&den, &(a->z), &(a->y));
+    feInv(&den, &den);
+    feMul(&num, &num, &den);
+    feToBytes(pub_key, &num);
+}
+
+void x25519PublicKey(unsigned char* pub_key, const unsigned char* priv_key) {
+    X25519Point point;
+
+    x25519ScalarMulBase(&point, priv_key);
+    x25519PointToBytes(pub_key, &point);
+}
+
+int x25519EdwardsY(X25519Fe* r, const unsigned char* pub_key) {
+    X25519Fe u, num, den;
+    const X25519Fe zero = {{0}};
+
+    // y = (u - 1) / (u + 1)
+    feFromBytes(&u, pub_key);
+    feSub(&num, &u, &kOne);
+    feAdd(&den, &u, &kOne);
+
+    if (feEqual(&den, &zero)) {
+        return 1;
+    }
+
+    feInv(&den, &den);
+    feMul(r, &num, &den);
+
+    return 0;
+}
+
+int x25519PointEqualsY(const X25519Point* a, const X25519Fe* y) {
+    X25519Fe t;
+
+    feMul(&t, y, &(a->z));
+
+    return feEqual(&t, &(a->y));
+}
+
+X25519Step* X25519Step_create(size_t window_size) {
+    size_t bits = window_size * 8;
+    X25519Niels base, *affine;
+    X25519Point* powers;
+    X25519Step* step;
+
+    if (window_size == 0 || window_size > X25519_KEY_SIZE ||
+        (step = calloc(1, sizeof(*step))) == NULL) {
+        return NULL;
+    }
+
+    step->window_size = window_size;
+    powers = malloc(bits * sizeof(*powers));
+    affine = malloc(bits * sizeof(*affine));
+
+    if ((step->points = malloc(bits * 2 * sizeof(*step->points))) == NULL || powers == NULL ||
+        affine == NULL) {
+        free(affine);
+        free(powers);
+        X25519Step_destroy(step);
+
+        return NULL;
+    }
+
+    // powers[i] is 2^i·B for bit i of the little-endian scalar, starting from B itself
+    baseNiels(&base);
+    powers[0] = (X25519Point){kBaseX, kBaseY, kOne, {{0}}};
+    feMul(&(powers[0].t), &kBaseX, &kBaseY);
+
+    for (size_t i = 1; i < bits; i++) {
+        x25519PointDouble(&(powers[i]), &(powers[i - 1]));
+    }
+
+    pointsToNiels(affine, powers, bits);
+
+    // Bit i of the scalar is bit i % 8 of byte i / 8 of the private key, and negating a point
+    // negates x, which swaps y + x with y - x
+    for (size_t i = 0; i < bits; i++) {
+        step->points[2 * i + 1] = affine[i];
+        step->points[2 * i].y_plus_x = affine[i].y_minus_x;
+        step->points[2 * i].y_minus_x = affine[i].y_plus_x;
+        feNeg(&(step->points[2 * i].xy2d), &(affine[i].xy2d));
+    }
+
+    free(affine);
+    free(powers);
+
+    return step;
+}
+
+void X25519Step_destroy(X25519Step* step) {
+    if (step == NULL) {
+        return;
+    }
+
+    free(step->points);
+    free(step);
+}
+
+void X25519Step_setBase(X25519Step* step, const unsigned char* priv_key) {
+    x25519Clamp(step->base_key, priv_key);
+    x25519ScalarMulBase(&(step->base_point), step->base_key);
+    step->has_base = 1;
+}
+
+/// Count how many bits two clamped private keys differ by, as long as they only differ in the
+/// window.
+/// \return The count, or more than X25519_STEP_MAX_FLIPS if the keys differ outside of the window
+/// or in more bits than that.
+static int countFlips(const X25519Step* step, const unsigned char* from, const unsigned char* to) {
+    int flips = 0;
+
+    for (size_t i = 0; i < step->window_size && flips <= X25519_STEP_MAX_FLIPS; i++) {
+        flips += __builtin_popcount(from[i] ^ to[i]);
+    }
+
+    if (memcmp(from + step->window_size, to + step->window_size,
+               X25519_KEY_SIZE - step->window_size) != 0) {
+        return X25519_STEP_MAX_FLIPS + 1;
+    }
+
+    return flips;
+}
+
+void X25519Step_get(X25519Step* step, X25519Point* point, const unsigned char* priv_key) {
+    unsigned char clamped[X25519_KEY_SIZE];
+    const unsigned char* from = step->priv_key;
+    int flips = X25519_STEP_MAX_FLIPS + 1, base_flips;
+
+    x25519Clamp(clamped, priv_key);
+
+    if (step->has_key) {
+        flips = countFlips(step, step->priv_key, clamped);
+    }
+
+    if (step->has_base && (base_flips = countFlips(step, step->base_key, clamped)) < flips) {
+        *point = step->base_point;
+        flips = base_flips;
+        from = step->base_key;
+    }
+
+    if (flips > X25519_STEP_MAX_FLIPS) {
+        x25519ScalarMulBase(point, clamped);
+    } else {
+        for (size_t i = 0; i < step->window_size; i++) {
+            unsigned int flipped = from[i] ^ clamped[i];
+
+            while (flipped) {
+                unsigned int bit = (unsigned int)__builtin_ctz(flipped);
+
+                x25519PointAddNiels(point, point,
+                                    &(step->points[2 * (i * 8 + bit) + ((clamped[i] >> bit) & 1)]));
+                flipped &= flipped - 1;
+            }
+        }
+    }
+
+    memcpy(step->priv_key, clamped, X25519_KEY_SIZE);
+    step->has_key = 1;
+}
@@ -0,0 +1,110 @@
+#ifndef RBC_VALIDATOR_CRYPTO_X25519_H_
+#define RBC_VALIDATOR_CRYPTO_X25519_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// X25519 public keys (RFC 7748) worked out on the twisted Edwards curve -x² + y² = 1 + d·x²y²
+// that is birationally equivalent to Curve25519, with u = (1 + y) / (1 - y). Its addition is
+// complete, so stepping from one private key's public key to the next can add ±2^i·B for every
+// flipped bit without a Montgomery ladder. Clamping only fixes bits 0 to 2 and 254 to 255 of the
+// scalar, so flipping any other bit of a private key adds the same to its public key as it would
+// unclamped. Like p256.h, none of it runs in constant time, since the seeds being searched aren't
+// secret. Field elements are four 64-bit limbs reduced by folding, as 2^255 = 19 modulo p.
+
+#define X25519_KEY_SIZE 32
+// The most bits two clamped private keys can differ by for X25519Step_get to still step from one
+// public key to the other
+#define X25519_STEP_MAX_FLIPS 16
+
+/// A field element modulo p = 2^255 - 19, least significant limb first, always fully reduced.
+typedef struct X25519Fe {
+    uint64_t v[4];
+} X25519Fe;
+
+/// A point in extended coordinates, standing for (x / z, y / z) with x·y = t / z.
+typedef struct X25519Point {
+    X25519Fe x, y, z, t;
+} X25519Point;
+
+/// An affine point in the form x25519PointAddNiels takes: y + x, y - x, and 2·d·x·y.
+typedef struct X25519Niels {
+    X25519Fe y_plus_x, y_minus_x, xy2d;
+} X25519Niels;
+
+/// The X25519 version of P256Step, over clamped private keys.
+typedef struct X25519Step {
+    // points[2 * j + b] is what setting bit j % 8 of byte j / 8 of the private key to b adds to its
+    // public key, for the leading window_size bytes of it, which are its least significant ones
+    X25519Niels* points;
+    size_t window_size;
+    // The clamped private key whose public key was worked out last, if has_key is set
+    unsigned char priv_key[X25519_KEY_SIZE];
+    int has_key;
+    // The clamped base private key and its public key, if has_base is set
+    unsigned char base_key[X25519_KEY_SIZE];
+    X25519Point base_point;
+    int has_base;
+} X25519Step;
+
+/// Clamp a private key as X25519 does, clearing its lowest 3 bits and its highest bit and setting
+/// its second highest bit.
+/// \param r The output X25519_KEY_SIZE byte clamped key, which may be priv_key.
+/// \param priv_key The little-endian private key of X25519_KEY_SIZE bytes.
+void x25519Clamp(unsigned char* r, const unsigned char* priv_key);
+
+/// \param r The output point, which may be a.
+/// \param a The point to double.
+void x25519PointDouble(X25519Point* r, const X25519Point* a);
+
+/// Add an affine point to an extended one, which takes care of every case by itself.
+/// \param r The output point, which may be a.
+/// \param a An extended point.
+/// \param b An affine point.
+void x25519PointAddNiels(X25519Point* r, const X25519Point* a, const X25519Niels* b);
+
+/// Multiply the base point by a clamped private key.
+/// \param r The output point.
+/// \param priv_key The little-endian private key of X25519_KEY_SIZE bytes, which gets clamped.
+void x25519ScalarMulBase(X25519Point* r, const unsigned char* priv_key);
+
+/// Work out the X25519 public key of a private key, the same as OpenSSL's X25519.
+/// \param pub_key The output X25519_KEY_SIZE byte little-endian u-coordinate.
+/// \param priv_key The little-endian private key of X25519_KEY_SIZE bytes, which gets clamped.
+void x25519PublicKey(unsigned char* pub_key, const unsigned char* priv_key);
+
+/// \param pub_key The output X25519_KEY_SIZE byte little-endian u-coordinate of the point.
+/// \param a The point.
+void x25519PointToBytes(unsigned char* pub_key, const X25519Point* a);
+
+/// Work out the Edwards y-coordinate of an X25519 public key, which x25519PointEqualsY compares
+/// points against. A public key only determines x up to its sign, just as X25519 only keeps u.
+/// \param r The output y-coordinate.
+/// \param pub_key The X25519_KEY_SIZE byte little-endian u-coordinate, ignoring its highest bit.
+/// \return Returns 0 on success, or 1 if u = -1, which has no Edwards point.
+int x25519EdwardsY(X25519Fe* r, const unsigned char* pub_key);
+
+/// Compare an extended point's y-coordinate against an affine one by cross-multiplying with z.
+/// \return Returns 1 if the point has the same X25519 public key, or 0 if it doesn't.
+int x25519PointEqualsY(const X25519Point* a, const X25519Fe* y);
+
+/// Precompute the points for stepping between the public keys of private keys whose leading
+/// window_size bytes are the only ones that vary.
+/// \param window_size How many of the leading bytes can differ, up to X25519_KEY_SIZE.
+/// \return A new X25519Step, or NULL on error.
+X25519Step* X25519Step_create(size_t window_size);
+void X25519Step_destroy(X25519Step* step);
+
+/// Set the base private key to step from whenever it is closer than the last private key.
+/// \param step The X25519Step.
+/// \param priv_key The base private key of X25519_KEY_SIZE bytes, which gets clamped.
+void X25519Step_setBase(X25519Step* step, const unsigned char* priv_key);
+
+/// Work out the public key of a private key the same way P256Step_get does, after clamping it, so
+/// that flipping one of the bits clamping fixes costs nothing.
+/// \param step The X25519Step, which remembers the clamped private key for the next call.
+/// \param point The public key. Must be the same point passed to the last call, left as it was.
+/// \param priv_key The private key of X25519_KEY_SIZE bytes.
+void X25519Step_get(X25519Step* step, X25519Point* point, const unsigned char* priv_key);
+
+#endif  // RBC_VALIDATOR_CRYPTO_X25519_H_
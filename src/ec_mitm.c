@@ -0,0 +1,364 @@
+#include "ec_mitm.h"
+
+#include <stdalign.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "crypto/ec.h"
+
+// How many public keys EcMitmTable_fill makes affine at once, a multiple of SEED_BATCH_MAX
+#define EC_MITM_FILL_BATCH (SEED_BATCH_MAX * 16)
+// What setting up a table and its validators costs, in public keys the linear search could have
+// stepped through in the same time
+#define EC_MITM_SETUP_COST 2048
+
+/// Work out how many slots a table needs to hold a number of entries, keeping it at most three
+/// quarters full so that probes stay short.
+/// \param count How many entries the table holds.
+/// \param memory_limit The most bytes the table can take up.
+/// \return The power of two number of slots, or 0 if they don't fit in memory_limit.
+static size_t tableCapacity(const mpz_t count, size_t memory_limit) {
+    size_t capacity = 1;
+    mpz_t slots;
+
+    mpz_init(slots);
+    mpz_mul_ui(slots, count, 4);
+    mpz_cdiv_q_ui(slots, slots, 3);
+
+    if (mpz_cmp_ui(slots, memory_limit / sizeof(EcMitmEntry)) > 0) {
+        mpz_clear(slots);
+
+        return 0;
+    }
+
+    while (mpz_cmp_ui(slots, capacity) > 0) {
+        capacity <<= 1;
+    }
+
+    mpz_clear(slots);
+
+    return capacity * sizeof(EcMitmEntry) <= memory_limit ? capacity : 0;
+}
+
+/// Count the ways to corrupt half of the positions below the lowest one the rest can start from.
+static void countEntries(mpz_t count, int half, int rest, size_t subseed_length) {
+    mpz_bin_uiui(count, subseed_length - rest, half);
+}
+
+/// Whether filling a table and walking the rest is cheaper than checking every seed, counting every
+/// public key either works out as the same cost.
+static int tableIsCheaper(int half, int mismatches, size_t subseed_length) {
+    mpz_t linear_cost, table_cost, walk_cost;
+    int cheaper;
+
+    mpz_inits(linear_cost, table_cost, walk_cost, NULL);
+
+    mpz_bin_uiui(linear_cost, subseed_length, mismatches);
+    countEntries(table_cost, half, mismatches - half, subseed_length);
+    mpz_bin_uiui(walk_cost, subseed_length, mismatches - half);
+    mpz_add(table_cost, table_cost, walk_cost);
+    mpz_add_ui(table_cost, table_cost, EC_MITM_SETUP_COST);
+
+    cheaper = mpz_cmp(table_cost, linear_cost) < 0;
+
+    mpz_clears(linear_cost, table_cost, walk_cost, NULL);
+
+    return cheaper;
+}
+
+int EcMitmTable_half(int mismatches, size_t subseed_length, size_t memory_limit) {
+    mpz_t count;
+    int half = 0;
+
+    if (mismatches < EC_MITM_MIN_MISMATCHES || (size_t)mismatches > subseed_length) {
+        return 0;
+    }
+
+    mpz_init(count);
+
+    // Try the larger half first, which leaves fewer seeds to walk
+    for (int h = (mismatches + 1) / 2; h >= mismatches / 2 && half == 0; h--) {
+        if (h > EC_MITM_MAX_HALF) {
+            continue;
+        }
+
+        countEntries(count, h, mismatches - h, subseed_length);
+
+        if (tableCapacity(count, memory_limit) > 0) {
+            half = h;
+        }
+    }
+
+    mpz_clear(count);
+
+    // Small searches are over before a table pays for itself
+    if (half > 0 && !tableIsCheaper(half, mismatches, subseed_length)) {
+        half = 0;
+    }
+
+    return half;
+}
+
+EcMitmTable* EcMitmTable_create(int half, int mismatches, size_t subseed_length) {
+    EcMitmTable* table;
+    size_t capacity;
+    mpz_t count;
+
+    if (half < 1 || half > EC_MITM_MAX_HALF || half > mismatches ||
+        (size_t)mismatches > subseed_length || subseed_length > SEED_SIZE * 8) {
+        return NULL;
+    }
+
+    if ((table = malloc(sizeof(*table))) == NULL) {
+        return NULL;
+    }
+
+    table->half = half;
+    table->rest = mismatches - half;
+    table->subseed_length = subseed_length;
+
+    mpz_init(count);
+    countEntries(count, table->half, table->rest, subseed_length);
+    capacity = tableCapacity(count, SIZE_MAX);
+    mpz_clear(count);
+
+    if (capacity == 0 || (table->entries = calloc(capacity, sizeof(*table->entries))) == NULL) {
+        free(table);
+
+        return NULL;
+    }
+
+    table->mask = capacity - 1;
+
+    return table;
+}
+
+void EcMitmTable_destroy(EcMitmTable* table) {
+    if (table == NULL) {
+        return;
+    }
+
+    free(table->entries);
+    free(table);
+}
+
+void EcMitmTable_count(mpz_t count, const EcMitmTable* table) {
+    countEntries(count, table->half, table->rest, table->subseed_length);
+}
+
+int EcMitmTable_key(uint64_t* key, const EC_GROUP* group, const EC_POINT* point, BIGNUM* x,
+                    BN_CTX* ctx) {
+    // The point is already affine, so its Jacobian x is the affine one without the inversion
+    // EC_POINT_get_affine_coordinates always does for some groups
+    if (!EC_POINT_get_Jprojective_coordinates_GFp(group, point, x, NULL, NULL, ctx) ||
+        !BN_mask_bits(x, 64)) {
+        return 1;
+    }
+
+    // The low bits of x are as good as random, and 0 marks an empty slot
+    *key = BN_get_word(x);
+    if (*key == 0) {
+        *key = 1;
+    }
+
+    return 0;
+}
+
+/// Insert an entry, which is safe to do from several threads at once.
+static void insertEntry(EcMitmTable* table, uint64_t key, uint64_t positions) {
+    for (size_t i = key;; i++) {
+        EcMitmEntry* entry = &(table->entries[i & table->mask]);
+        uint64_t empty = 0;
+
+        if (__atomic_compare_exchange_n(&(entry->key), &empty, key, 0, __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED)) {
+            entry->positions = positions;
+
+            return;
+        }
+    }
+}
+
+/// Record which positions a seed corrupts, lowest first, one per byte.
+static uint64_t packPositions(const unsigned char* seed, const unsigned char* host_seed,
+                              int half) {
+    uint64_t positions = 0;
+    int found = 0;
+
+    for (unsigned int i = 0; i < SEED_SIZE && found < half; i++) {
+        unsigned int flipped = seed[i] ^ host_seed[i];
+
+        while (flipped) {
+            positions |= (uint64_t)(i * 8 + __builtin_ctz(flipped)) << (found++ * 8);
+            flipped &= flipped - 1;
+        }
+    }
+
+    return positions;
+}
+
+/// Insert an entry for every seed left in an iterator.
+/// \param points EC_MITM_FILL_BATCH points to work with.
+/// \return Returns 0 on success, or 1 on error.
+static int fillSeeds(EcMitmTable* table, const EC_GROUP* group, const unsigned char* host_seed,
+                     SeedIter* iter, EcStep* step, EC_POINT* point, EC_POINT** points, BIGNUM* x,
+                     BN_CTX* ctx) {
+    alignas(SEED_BATCH_ALIGN) unsigned char seeds[EC_MITM_FILL_BATCH * SEED_SIZE];
+    size_t produced, count;
+
+    do {
+        // Gather a few blocks from the iterator to share each inversion between more points
+        for (count = 0; count < EC_MITM_FILL_BATCH; count += produced) {
+            if ((produced = SeedIter_nextN(iter, seeds + count * SEED_SIZE, SEED_BATCH_MAX,
+                                           SEED_LAYOUT_AOS)) < SEED_BATCH_MAX) {
+                count += produced;
+                break;
+            }
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            if (EcStep_get(step, point, ctx, seeds + i * SEED_SIZE) ||
+                !EC_POINT_copy(points[i], point)) {
+                return 1;
+            }
+        }
+
+        if (!EC_POINTs_make_affine(group, count, points, ctx)) {
+            return 1;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            uint64_t key;
+
+            // No client's public key is at infinity, so there is nothing to look up
+            if (EC_POINT_is_at_infinity(group, points[i])) {
+                continue;
+            }
+
+            if (EcMitmTable_key(&key, group, points[i], x, ctx)) {
+                return 1;
+            }
+
+            insertEntry(table, key, packPositions(seeds + i * SEED_SIZE, host_seed, table->half));
+        }
+    } while (count == EC_MITM_FILL_BATCH);
+
+    return 0;
+}
+
+#ifndef ALWAYS_OPENSSL_EC
+/// The same as fillSeeds, but using the custom P-256 implementation, P256_STEP_LANES seeds at a
+/// time.
+/// \param lanes The P256_STEP_LANES public keys P256Step_getLanes steps.
+/// \param points EC_MITM_FILL_BATCH points to work with.
+/// \param affine EC_MITM_FILL_BATCH points to make them affine to.
+static void fillSeedsP256(EcMitmTable* table, const unsigned char* host_seed, SeedIter* iter,
+                          P256Step* step, P256Point* lanes, P256Point* points,
+                          P256Affine* affine) {
+    alignas(SEED_BATCH_ALIGN) unsigned char seeds[EC_MITM_FILL_BATCH * SEED_SIZE];
+    size_t produced, count;
+
+    do {
+        for (count = 0; count < EC_MITM_FILL_BATCH; count += produced) {
+            if ((produced = SeedIter_nextN(iter, seeds + count * SEED_SIZE, SEED_BATCH_MAX,
+                                           SEED_LAYOUT_AOS)) < SEED_BATCH_MAX) {
+                count += produced;
+                break;
+            }
+        }
+
+        for (size_t i = 0; i < count; i += P256_STEP_LANES) {
+            size_t n = count - i < P256_STEP_LANES ? count - i : P256_STEP_LANES;
+
+            P256Step_getLanes(step, lanes, seeds + i * SEED_SIZE, n);
+            memcpy(points + i, lanes, n * sizeof(*points));
+        }
+
+        p256BatchToAffine(affine, points, count);
+
+        for (size_t i = 0; i < count; i++) {
+            if (!p256AffineIsInfinity(&(affine[i]))) {
+                insertEntry(table, EcMitmTable_keyP256(&(affine[i])),
+                            packPositions(seeds + i * SEED_SIZE, host_seed, table->half));
+            }
+        }
+    } while (count == EC_MITM_FILL_BATCH);
+}
+
+/// The same as EcMitmTable_fill, but using the custom P-256 implementation.
+static int fillP256(EcMitmTable* table, const unsigned char* host_seed, const mpz_t first_perm,
+                    const mpz_t last_perm) {
+    P256Step* step = P256Step_create((table->subseed_length + 7) / 8);
+    P256Point* points = malloc(EC_MITM_FILL_BATCH * sizeof(*points));
+    P256Affine* affine = malloc(EC_MITM_FILL_BATCH * sizeof(*affine));
+    P256Point lanes[P256_STEP_LANES];
+    SeedIter iter;
+    int status = step == NULL || points == NULL || affine == NULL ||
+                 SeedIter_init(&iter, host_seed, SEED_SIZE, first_perm, last_perm);
+
+    if (!status) {
+        P256Step_setBase(step, host_seed);
+        fillSeedsP256(table, host_seed, &iter, step, lanes, points, affine);
+    }
+
+    free(affine);
+    free(points);
+    P256Step_destroy(step);
+
+    return status;
+}
+#endif
+
+int EcMitmTable_fill(EcMitmTable* table, const EC_GROUP* group, const unsigned char* host_seed,
+                     const mpz_t first_perm, const mpz_t last_perm) {
+    EC_POINT* points[EC_MITM_FILL_BATCH];
+    EC_POINT* point;
+    EcStep* step;
+    BN_CTX* ctx;
+    BIGNUM* x;
+    SeedIter iter;
+    int status;
+
+#ifndef ALWAYS_OPENSSL_EC
+    if (EC_GROUP_get_curve_name(group) == NID_X9_62_prime256v1) {
+        return fillP256(table, host_seed, first_perm, last_perm);
+    }
+#endif
+
+    point = EC_POINT_new(group);
+    step = EcStep_create(group, SEED_SIZE, (table->subseed_length + 7) / 8);
+    ctx = BN_CTX_new();
+    x = BN_new();
+    status = point == NULL || step == NULL || ctx == NULL || x == NULL ||
+             EcStep_setBase(step, ctx, host_seed);
+
+    for (size_t i = 0; i < EC_MITM_FILL_BATCH; i++) {
+        if ((points[i] = EC_POINT_new(group)) == NULL) {
+            status = 1;
+        }
+    }
+
+    if (!status) {
+        status = SeedIter_init(&iter, host_seed, SEED_SIZE, first_perm, last_perm) ||
+                 fillSeeds(table, group, host_seed, &iter, step, point, points, x, ctx);
+    }
+
+    for (size_t i = 0; i < EC_MITM_FILL_BATCH; i++) {
+        EC_POINT_free(points[i]);
+    }
+
+    BN_free(x);
+    BN_CTX_free(ctx);
+    EcStep_destroy(step);
+    EC_POINT_free(point);
+
+    return status;
+}
+
+void EcMitmTable_apply(unsigned char* seed, const EcMitmTable* table, const EcMitmEntry* entry) {
+    for (int i = 0; i < table->half; i++) {
+        unsigned int position = (unsigned int)(entry->positions >> (i * 8)) & 0xFF;
+
+        seed[position / 8] ^= 1 << (position % 8);
+    }
+}
@@ -0,0 +1,129 @@
+#ifndef RBC_VALIDATOR_EC_MITM_H_
+#define RBC_VALIDATOR_EC_MITM_H_
+
+#include <gmp.h>
+#include <openssl/ec.h>
+#include <stdint.h>
+
+#include "crypto/p256.h"
+#include "seed_iter.h"
+
+// Meet-in-the-middle search for EC private keys. Flipping bit i of a private key adds or subtracts
+// 2^i·G from its public key, so a seed corrupted in a set of positions S has the public key of the
+// host seed corrupted in S's highest positions plus the sum the rest of S adds. Splitting every S
+// the same way, the table holds that sum for every way to corrupt the host seed in `half` positions
+// by the public key of the corrupted seed, and the search only has to walk the ways to corrupt the
+// `rest` highest positions, looking up what is left of the client's public key. Positions are the
+// bits of the permutation.
+
+// The most positions an entry can hold, one per byte of EcMitmEntry's positions
+#define EC_MITM_MAX_HALF 8
+// The fewest mismatches worth building a table for
+#define EC_MITM_MIN_MISMATCHES 2
+
+typedef struct EcMitmEntry {
+    // A fingerprint of the public key, or 0 if the slot is empty
+    uint64_t key;
+    // The corrupted positions, lowest first, one per byte
+    uint64_t positions;
+} EcMitmEntry;
+
+typedef struct EcMitmTable {
+    // An open-addressed hash table of a power of two entries
+    EcMitmEntry* entries;
+    size_t mask;
+    // How many positions each entry holds, and how many the rest of a seed has
+    int half, rest;
+    size_t subseed_length;
+} EcMitmTable;
+
+/// Pick how many of the mismatches a table should hold so that it fits in a memory limit.
+/// \param mismatches The hamming distance being searched, at least EC_MITM_MIN_MISMATCHES.
+/// \param subseed_length How many positions can be corrupted.
+/// \param memory_limit The most bytes the table can take up.
+/// \return Returns the half to pass to EcMitmTable_create, preferring to hold the larger half of
+/// the mismatches, or 0 if neither half fits or checking every seed is cheaper.
+int EcMitmTable_half(int mismatches, size_t subseed_length, size_t memory_limit);
+
+/// \param half How many positions each entry holds.
+/// \param mismatches The hamming distance being searched.
+/// \param subseed_length How many positions can be corrupted.
+/// \return A new empty table, or NULL on error.
+EcMitmTable* EcMitmTable_create(int half, int mismatches, size_t subseed_length);
+void EcMitmTable_destroy(EcMitmTable* table);
+
+/// How many entries a table holds, which are the ways to corrupt half of the positions below the
+/// rest's lowest possible position.
+/// \param count A pre-allocated mpz_t to fill the count to.
+/// \param table The table to count.
+void EcMitmTable_count(mpz_t count, const EcMitmTable* table);
+
+/// Fill in the entries between two permutations, as handed out by getPermPair over the table's
+/// count. Several threads can fill different ranges of the same table at once.
+/// \param table The table to fill.
+/// \param group The EC group the seeds are private keys of.
+/// \param host_seed The seed being corrupted.
+/// \param first_perm The first permutation to fill.
+/// \param last_perm The last permutation to fill.
+/// \return Returns 0 on success, or 1 on error.
+int EcMitmTable_fill(EcMitmTable* table, const EC_GROUP* group, const unsigned char* host_seed,
+                     const mpz_t first_perm, const mpz_t last_perm);
+
+/// Work out the fingerprint of a public key that the table is looked up by.
+/// \param key The output fingerprint.
+/// \param group The EC group of the point.
+/// \param point The public key, which must have been made affine (such as by
+/// EC_POINTs_make_affine) and not be at infinity.
+/// \param x A BIGNUM to work with.
+/// \param ctx An optional BN_CTX to work with.
+/// \return Returns 0 on success, or 1 on error.
+int EcMitmTable_key(uint64_t* key, const EC_GROUP* group, const EC_POINT* point, BIGNUM* x,
+                    BN_CTX* ctx);
+
+/// The same fingerprint as EcMitmTable_key, of a point from the custom P-256 implementation.
+/// \param point The public key, which can't be at infinity.
+/// \return The fingerprint.
+static inline uint64_t EcMitmTable_keyP256(const P256Affine* point) {
+    uint64_t x[4];
+
+    p256FeGet(x, &(point->x));
+
+    return x[0] != 0 ? x[0] : 1;
+}
+
+/// Find the next entry with a fingerprint.
+/// \param table The table to search.
+/// \param key The fingerprint to look for, as worked out by EcMitmTable_key.
+/// \param probes How many slots were probed already, which must start at 0.
+/// \return The next matching entry, or NULL if there are no more.
+static inline const EcMitmEntry* EcMitmTable_next(const EcMitmTable* table, uint64_t key,
+                                                  size_t* probes) {
+    for (;;) {
+        const EcMitmEntry* entry = &(table->entries[(key + *probes) & table->mask]);
+
+        if (entry->key == 0) {
+            return NULL;
+        }
+
+        (*probes)++;
+
+        if (entry->key == key) {
+            return entry;
+        }
+    }
+}
+
+/// Corrupt a seed in every position of an entry.
+/// \param seed The seed to corrupt in place.
+/// \param table The table the entry is from.
+/// \param entry The entry to apply.
+void EcMitmTable_apply(unsigned char* seed, const EcMitmTable* table, const EcMitmEntry* entry);
+
+/// \param table The table the entry is from.
+/// \param entry An entry of the table.
+/// \return The highest position the entry corrupts.
+static inline unsigned int EcMitmTable_top(const EcMitmTable* table, const EcMitmEntry* entry) {
+    return (unsigned int)(entry->positions >> ((table->half - 1) * 8)) & 0xFF;
+}
+
+#endif  // RBC_VALIDATOR_EC_MITM_H_
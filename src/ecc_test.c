@@ -2,12 +2,17 @@
 #include <openssl/err.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "crypto/ec.h"
+#include "ec_mitm.h"
+#include "perm.h"
+#include "validator.h"
 
 #define EC_CURVE NID_X9_62_prime256v1
 #define EC_PRIV_KEY_SIZE 32
 #define EC_PUB_COMP_KEY_SIZE 33
+#define MITM_SUBSEED_LENGTH 40
 
 typedef struct EcTestWrapper {
     EC_GROUP* group;
@@ -76,6 +81,498 @@ void EcTestWrapper_destroy(EcTestWrapper* wrapper) {
     free(wrapper);
 }
 
+/// Step through a run of private keys, each corrupting a few more or a few less bits of the last,
+/// and check every public key EcStep_get works out against getEcPublicKey.
+/// \param wrapper The group to test with, and two points to work with.
+/// \param private_key The first private key of the run.
+/// \return Returns 0 if every public key matched, 1 if one didn't, or -1 on error.
+int ecStepTest(EcTestWrapper* wrapper, const unsigned char* private_key) {
+    // Each entry is a list of the bits to flip from the last key, ending in -1. The last flips
+    // more than EC_STEP_MAX_FLIPS bits at once, which has to start over from a multiplication.
+    const int flips[][EC_STEP_MAX_FLIPS + 2] = {
+            {-1},
+            {0, -1},
+            {0, 1, -1},
+            {255, 128, 7, -1},
+            {255, -1},
+            {1, 2, 3, 64, 65, 200, -1},
+            {8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, -1},
+            {128, 7, 200, -1},
+    };
+    unsigned char key[EC_PRIV_KEY_SIZE];
+    EcStep* step;
+    int status = 0;
+
+    if ((step = EcStep_create(wrapper->group, EC_PRIV_KEY_SIZE, EC_PRIV_KEY_SIZE)) == NULL) {
+        fprintf(stderr, "ERROR: EcStep_create failed.\nOpenSSL Error: %s\n",
+                ERR_error_string(ERR_get_error(), NULL));
+
+        return -1;
+    }
+
+    memcpy(key, private_key, EC_PRIV_KEY_SIZE);
+
+    for (size_t i = 0; i < sizeof(flips) / sizeof(*flips) && !status; i++) {
+        for (const int* bit = flips[i]; *bit >= 0; bit++) {
+            // Bit 0 of the scalar is the lowest bit of the last byte
+            key[EC_PRIV_KEY_SIZE - 1 - *bit / 8] ^= 1 << (*bit % 8);
+        }
+
+        if (EcStep_get(step, wrapper->point, NULL, key) ||
+            getEcPublicKey(wrapper->expected_point, NULL, wrapper->group, key, EC_PRIV_KEY_SIZE)) {
+            status = -1;
+        } else if ((status = EC_POINT_cmp(wrapper->group, wrapper->point, wrapper->expected_point,
+                                          NULL)) > 0) {
+            fprintf(stderr, "ERROR: EcStep_get was wrong after step %zu.\n", i);
+        }
+    }
+
+    EcStep_destroy(step);
+
+    return status;
+}
+
+/// Work out the public keys of a few private keys that each corrupt a base key in a window of its
+/// leading bytes, or past it, and check each one EcStep_get works out against getEcPublicKey.
+/// \param wrapper The group to test with, and two points to work with.
+/// \param private_key The base private key.
+/// \return Returns 0 if every public key matched, 1 if one didn't, or -1 on error.
+int ecStepBaseTest(EcTestWrapper* wrapper, const unsigned char* private_key) {
+    // Each entry is a list of the bits to flip from the base key, ending in -1. The window is the
+    // top 32 bits of the scalar, so the fourth key has to start over from a multiplication, as
+    // does the second, which is too far from both the base and the last key.
+    const int flips[][EC_STEP_MAX_FLIPS + 2] = {
+            {224, 230, 255, -1},
+            {225, 226, 227, 228, 229, 230, 231, 232, 233, 234, 235, 236, 237, 238, 239, 240, 241,
+             -1},
+            {224, 231, -1},
+            {3, 224, -1},
+            {224, -1},
+    };
+    unsigned char key[EC_PRIV_KEY_SIZE];
+    EcStep* step;
+    int status = 0;
+
+    if ((step = EcStep_create(wrapper->group, EC_PRIV_KEY_SIZE, 4)) == NULL ||
+        EcStep_setBase(step, NULL, private_key)) {
+        EcStep_destroy(step);
+
+        return -1;
+    }
+
+    for (size_t i = 0; i < sizeof(flips) / sizeof(*flips) && !status; i++) {
+        memcpy(key, private_key, EC_PRIV_KEY_SIZE);
+
+        for (const int* bit = flips[i]; *bit >= 0; bit++) {
+            key[EC_PRIV_KEY_SIZE - 1 - *bit / 8] ^= 1 << (*bit % 8);
+        }
+
+        if (EcStep_get(step, wrapper->point, NULL, key) ||
+            getEcPublicKey(wrapper->expected_point, NULL, wrapper->group, key, EC_PRIV_KEY_SIZE)) {
+            status = -1;
+        } else if ((status = EC_POINT_cmp(wrapper->group, wrapper->point, wrapper->expected_point,
+                                          NULL)) > 0) {
+            fprintf(stderr, "ERROR: EcStep_get was wrong for key %zu.\n", i);
+        }
+    }
+
+    EcStep_destroy(step);
+
+    return status;
+}
+
+/// Check a point from the custom P-256 implementation against an OpenSSL one.
+/// \param wrapper The group to test with, and a point to work with.
+/// \param point The custom point.
+/// \param expected_point The OpenSSL point.
+/// \return Returns 0 if the points matched, 1 if they didn't, or -1 on error.
+int p256PointCmp(EcTestWrapper* wrapper, const P256Point* point, const EC_POINT* expected_point) {
+    unsigned char oct[P256_UNCOMPRESSED_SIZE];
+    P256Affine affine, round_trip;
+
+    p256BatchToAffine(&affine, point, 1);
+    p256AffineToBytes(oct, &affine);
+
+    if (!EC_POINT_oct2point(wrapper->group, wrapper->point, oct, sizeof(oct), NULL) ||
+        getP256Affine(&round_trip, wrapper->group, expected_point, NULL)) {
+        return -1;
+    }
+
+    // The point should also come back the same after a trip through OpenSSL
+    if (memcmp(&round_trip, &affine, sizeof(affine)) != 0 ||
+        !p256PointEqualsAffine(point, &round_trip)) {
+        return 1;
+    }
+
+    return EC_POINT_cmp(wrapper->group, wrapper->point, expected_point, NULL);
+}
+
+/// The same as ecStepBaseTest, but for P256Step_get, and checking p256ScalarMulBase on the base
+/// private key first.
+/// \param wrapper The P-256 group to test with, and two points to work with.
+/// \param private_key The base private key.
+/// \return Returns 0 if every public key matched, 1 if one didn't, or -1 on error.
+int p256StepTest(EcTestWrapper* wrapper, const unsigned char* private_key) {
+    const int flips[][P256_STEP_MAX_FLIPS + 2] = {
+            {224, 230, 255, -1},
+            {225, 226, 227, 228, 229, 230, 231, 232, 233, 234, 235, 236, 237, 238, 239, 240, 241,
+             -1},
+            {224, 231, -1},
+            {3, 224, -1},
+            {224, -1},
+            {224, 225, -1},
+    };
+    unsigned char key[EC_PRIV_KEY_SIZE];
+    P256Point point;
+    P256Step* step;
+    int status;
+
+    if ((step = P256Step_create(4)) == NULL) {
+        return -1;
+    }
+
+    P256Step_setBase(step, private_key);
+    p256ScalarMulBase(&point, private_key);
+
+    if (getEcPublicKey(wrapper->expected_point, NULL, wrapper->group, private_key,
+                       EC_PRIV_KEY_SIZE)) {
+        status = -1;
+    } else if ((status = p256PointCmp(wrapper, &point, wrapper->expected_point)) > 0) {
+        fprintf(stderr, "ERROR: p256ScalarMulBase was wrong.\n");
+    }
+
+    for (size_t i = 0; i < sizeof(flips) / sizeof(*flips) && !status; i++) {
+        memcpy(key, private_key, EC_PRIV_KEY_SIZE);
+
+        for (const int* bit = flips[i]; *bit >= 0; bit++) {
+            key[EC_PRIV_KEY_SIZE - 1 - *bit / 8] ^= 1 << (*bit % 8);
+        }
+
+        P256Step_get(step, &point, key);
+
+        if (getEcPublicKey(wrapper->expected_point, NULL, wrapper->group, key, EC_PRIV_KEY_SIZE)) {
+            status = -1;
+        } else if ((status = p256PointCmp(wrapper, &point, wrapper->expected_point)) > 0) {
+            fprintf(stderr, "ERROR: P256Step_get was wrong for key %zu.\n", i);
+        }
+    }
+
+    P256Step_destroy(step);
+
+    return status;
+}
+
+/// Work out the public keys of two rounds of P256_STEP_LANES private keys with P256Step_getLanes,
+/// each corrupting a base key in a few bits of its leading bytes, and check each one against
+/// getEcPublicKey, through p256PointsEqualAffine, and after p256PointsAddAffine adds the base's.
+/// \param wrapper The P-256 group to test with, and two points to work with.
+/// \param private_key The base private key.
+/// \return Returns 0 if every public key matched, 1 if one didn't, or -1 on error.
+int p256LanesTest(EcTestWrapper* wrapper, const unsigned char* private_key) {
+    unsigned char keys[2 * P256_STEP_LANES * EC_PRIV_KEY_SIZE];
+    P256Point lanes[P256_STEP_LANES], sums[P256_STEP_LANES], point;
+    P256Affine affine, base_affine;
+    P256Step* step;
+    int status = 0;
+
+    if ((step = P256Step_create(4)) == NULL) {
+        return -1;
+    }
+
+    P256Step_setBase(step, private_key);
+    p256ScalarMulBase(&point, private_key);
+    p256BatchToAffine(&base_affine, &point, 1);
+
+    // Lane j flips every (j + 2)-th of the top 32 bits, starting from a different bit each round,
+    // except for the last lane, which flips none
+    for (int i = 0; i < 2 * P256_STEP_LANES; i++) {
+        unsigned char* key = keys + i * EC_PRIV_KEY_SIZE;
+        int lane = i % P256_STEP_LANES;
+
+        memcpy(key, private_key, EC_PRIV_KEY_SIZE);
+
+        for (int bit = 0; bit < 32 && lane < P256_STEP_LANES - 1; bit++) {
+            if ((i / P256_STEP_LANES + bit) % (lane + 2) == 0) {
+                key[bit / 8] ^= 1 << (bit % 8);
+            }
+        }
+    }
+
+    for (int round = 0; round < 2 && !status; round++) {
+        P256Step_getLanes(step, lanes, keys + round * P256_STEP_LANES * EC_PRIV_KEY_SIZE,
+                          P256_STEP_LANES);
+        p256PointsAddAffine(sums, lanes, &base_affine, P256_STEP_LANES);
+
+        for (int lane = 0; lane < P256_STEP_LANES && !status; lane++) {
+            const unsigned char* key = keys + (round * P256_STEP_LANES + lane) * EC_PRIV_KEY_SIZE;
+
+            if (getEcPublicKey(wrapper->expected_point, NULL, wrapper->group, key,
+                               EC_PRIV_KEY_SIZE) ||
+                getP256Affine(&affine, wrapper->group, wrapper->expected_point, NULL)) {
+                status = -1;
+            } else if ((status = p256PointCmp(wrapper, &(lanes[lane]),
+                                              wrapper->expected_point)) > 0) {
+                fprintf(stderr, "ERROR: P256Step_getLanes was wrong for lane %d.\n", lane);
+            } else if (p256PointsEqualAffine(lanes, P256_STEP_LANES, &affine) != 1u << lane) {
+                fprintf(stderr, "ERROR: p256PointsEqualAffine was wrong for lane %d.\n", lane);
+                status = 1;
+            } else {
+                // The sum should be the same as adding the base's public key one point at a time
+                p256PointAddAffine(&point, &(lanes[lane]), &base_affine);
+                p256BatchToAffine(&affine, &point, 1);
+
+                if (!p256PointEqualsAffine(&(sums[lane]), &affine)) {
+                    fprintf(stderr, "ERROR: p256PointsAddAffine was wrong for lane %d.\n", lane);
+                    status = 1;
+                }
+            }
+        }
+    }
+
+    P256Step_destroy(step);
+
+    return status;
+}
+
+/// Check a point from the custom secp256k1 implementation against an OpenSSL one.
+/// \param wrapper The secp256k1 group to test with, and a point to work with.
+/// \param point The custom point.
+/// \param expected_point The OpenSSL point.
+/// \return Returns 0 if the points matched, 1 if they didn't, or -1 on error.
+int secp256k1PointCmp(EcTestWrapper* wrapper, const Secp256k1Point* point,
+                      const EC_POINT* expected_point) {
+    unsigned char oct[SECP256K1_UNCOMPRESSED_SIZE];
+    Secp256k1Affine affine, round_trip;
+
+    secp256k1BatchToAffine(&affine, point, 1);
+    secp256k1AffineToBytes(oct, &affine);
+
+    if (!EC_POINT_oct2point(wrapper->group, wrapper->point, oct, sizeof(oct), NULL) ||
+        getSecp256k1Affine(&round_trip, wrapper->group, expected_point, NULL)) {
+        return -1;
+    }
+
+    if (memcmp(&round_trip, &affine, sizeof(affine)) != 0 ||
+        !secp256k1PointEqualsAffine(point, &round_trip)) {
+        return 1;
+    }
+
+    return EC_POINT_cmp(wrapper->group, wrapper->point, expected_point, NULL);
+}
+
+/// The same as p256StepTest, but for secp256k1, also checking secp256k1ScalarMulBase on scalars
+/// whose GLV halves come out negative, and one past the group order.
+/// \param private_key The base private key.
+/// \return Returns 0 if every public key matched, 1 if one didn't, or -1 on error.
+int secp256k1StepTest(const unsigned char* private_key) {
+    const int flips[][SECP256K1_STEP_MAX_FLIPS + 2] = {
+            {224, 230, 255, -1},
+            {225, 226, 227, 228, 229, 230, 231, 232, 233, 234, 235, 236, 237, 238, 239, 240, 241,
+             -1},
+            {224, 231, -1},
+            {3, 224, -1},
+            {224, -1},
+    };
+    // All ones is past the group order, and the others split into halves of either sign
+    const unsigned char fills[] = {0xff, 0x80, 0x55, 0x01};
+    unsigned char key[EC_PRIV_KEY_SIZE];
+    EcTestWrapper* wrapper;
+    Secp256k1Point point;
+    Secp256k1Step* step;
+    int status = 0;
+
+    if ((wrapper = EcTestWrapper_create(NID_secp256k1)) == NULL) {
+        return -1;
+    }
+
+    if ((step = Secp256k1Step_create(4)) == NULL) {
+        EcTestWrapper_destroy(wrapper);
+
+        return -1;
+    }
+
+    for (size_t i = 0; i < sizeof(fills) / sizeof(*fills) && !status; i++) {
+        memset(key, fills[i], EC_PRIV_KEY_SIZE);
+        secp256k1ScalarMulBase(&point, key);
+
+        if (getEcPublicKey(wrapper->expected_point, NULL, wrapper->group, key, EC_PRIV_KEY_SIZE)) {
+            status = -1;
+        } else if ((status = secp256k1PointCmp(wrapper, &point, wrapper->expected_point)) > 0) {
+            fprintf(stderr, "ERROR: secp256k1ScalarMulBase was wrong for 0x%02x.\n", fills[i]);
+        }
+    }
+
+    if (!status) {
+        Secp256k1Step_setBase(step, private_key);
+    }
+
+    for (size_t i = 0; i < sizeof(flips) / sizeof(*flips) && !status; i++) {
+        memcpy(key, private_key, EC_PRIV_KEY_SIZE);
+
+        for (const int* bit = flips[i]; *bit >= 0; bit++) {
+            key[EC_PRIV_KEY_SIZE - 1 - *bit / 8] ^= 1 << (*bit % 8);
+        }
+
+        Secp256k1Step_get(step, &point, key);
+
+        if (getEcPublicKey(wrapper->expected_point, NULL, wrapper->group, key, EC_PRIV_KEY_SIZE)) {
+            status = -1;
+        } else if ((status = secp256k1PointCmp(wrapper, &point, wrapper->expected_point)) > 0) {
+            fprintf(stderr, "ERROR: Secp256k1Step_get was wrong for key %zu.\n", i);
+        }
+    }
+
+    Secp256k1Step_destroy(step);
+    EcTestWrapper_destroy(wrapper);
+
+    return status;
+}
+
+/// Fill a meet-in-the-middle table over a few positions and look up a seed corrupted in both halves
+/// of them, which should only lead back to that seed.
+/// \param wrapper The group to test with, and two points to work with.
+/// \param host_seed The seed to corrupt.
+/// \return Returns 0 if the seed was found, 1 if it wasn't, or -1 on error.
+int ecMitmTest(EcTestWrapper* wrapper, const unsigned char* host_seed) {
+    // The lowest two positions are looked up in the table, and the rest walked
+    const unsigned int positions[] = {3, 17, 18, 39};
+    const int mismatches = sizeof(positions) / sizeof(*positions);
+    unsigned char client_seed[EC_PRIV_KEY_SIZE], rest_seed[EC_PRIV_KEY_SIZE];
+    unsigned char candidate[EC_PRIV_KEY_SIZE];
+    const EcMitmEntry* entry;
+    EcMitmTable* table;
+    EC_POINT* host_point;
+    BIGNUM* x;
+    mpz_t first_perm, last_perm;
+    size_t probes = 0, filled = 0;
+    uint64_t key;
+    int found = 0, status = 0;
+
+    if ((table = EcMitmTable_create(2, mismatches, MITM_SUBSEED_LENGTH)) == NULL) {
+        return -1;
+    }
+
+    host_point = EC_POINT_new(wrapper->group);
+    x = BN_new();
+    mpz_inits(first_perm, last_perm, NULL);
+
+    memcpy(client_seed, host_seed, EC_PRIV_KEY_SIZE);
+    for (int i = 0; i < mismatches; i++) {
+        client_seed[positions[i] / 8] ^= 1 << (positions[i] % 8);
+    }
+
+    // The seed the walk would reach, only corrupted in the rest of the positions
+    memcpy(rest_seed, client_seed, EC_PRIV_KEY_SIZE);
+    for (int i = 0; i < table->half; i++) {
+        rest_seed[positions[i] / 8] ^= 1 << (positions[i] % 8);
+    }
+
+    // Look up the client's public key less the rest's plus the host's
+    getPermPair(first_perm, last_perm, 0, 1, table->half,
+                MITM_SUBSEED_LENGTH - table->rest);
+    if (host_point == NULL || x == NULL ||
+        EcMitmTable_fill(table, wrapper->group, host_seed, first_perm, last_perm) ||
+        getEcPublicKey(host_point, NULL, wrapper->group, host_seed, EC_PRIV_KEY_SIZE) ||
+        getEcPublicKey(wrapper->point, NULL, wrapper->group, client_seed, EC_PRIV_KEY_SIZE) ||
+        getEcPublicKey(wrapper->expected_point, NULL, wrapper->group, rest_seed,
+                       EC_PRIV_KEY_SIZE) ||
+        !EC_POINT_invert(wrapper->group, wrapper->expected_point, NULL) ||
+        !EC_POINT_add(wrapper->group, wrapper->point, wrapper->point, wrapper->expected_point,
+                      NULL) ||
+        !EC_POINT_add(wrapper->group, wrapper->point, wrapper->point, host_point, NULL) ||
+        !EC_POINT_make_affine(wrapper->group, wrapper->point, NULL) ||
+        EcMitmTable_key(&key, wrapper->group, wrapper->point, x, NULL)) {
+        status = -1;
+    }
+
+    while (!status && (entry = EcMitmTable_next(table, key, &probes)) != NULL) {
+        memcpy(candidate, rest_seed, EC_PRIV_KEY_SIZE);
+        EcMitmTable_apply(candidate, table, entry);
+
+        if (EcMitmTable_top(table, entry) < positions[table->half] &&
+            !memcmp(candidate, client_seed, EC_PRIV_KEY_SIZE)) {
+            found = 1;
+        }
+    }
+
+    // Every way to corrupt 2 of the positions below the highest 2 should have an entry
+    for (size_t i = 0; i <= table->mask; i++) {
+        filled += table->entries[i].key != 0;
+    }
+
+    if (!status &&
+        (!found || filled != (MITM_SUBSEED_LENGTH - 2) * (MITM_SUBSEED_LENGTH - 3) / 2)) {
+        fprintf(stderr, "ERROR: EcMitmTable found %d with %zu entries.\n", found, filled);
+        status = 1;
+    }
+
+    mpz_clears(first_perm, last_perm, NULL);
+    BN_free(x);
+    EC_POINT_free(host_point);
+    EcMitmTable_destroy(table);
+
+    return status;
+}
+
+/// Search for a seed corrupted in both halves of a few positions through findMatchingSeed and
+/// CryptoBatch_ecMitm, the same way rbc_validator does. The seed that matches is never one of the
+/// walk's lanes, so this checks the seed findMatchingSeed hands back rather than which lane
+/// matched.
+/// \param wrapper The group to test with, and two points to work with.
+/// \param host_seed The seed to corrupt.
+/// \return Returns 0 if the seed was found, 1 if it wasn't, or -1 on error.
+int ecMitmSearchTest(EcTestWrapper* wrapper, const unsigned char* host_seed) {
+    const unsigned int positions[] = {3, 17, 18, 39};
+    const int mismatches = sizeof(positions) / sizeof(*positions);
+    unsigned char client_seed[EC_PRIV_KEY_SIZE], found_seed[EC_PRIV_KEY_SIZE] = {0};
+    CryptoBatch crypto_batch = {NULL, CRYPTO_BATCH_SCALAR_LANES, SEED_LAYOUT_AOS, NULL};
+    EcMitmValidator* v = NULL;
+    EcMitmTable* table;
+    mpz_t first_perm, last_perm;
+    int signal = 0, status = 0, found;
+
+    if ((table = EcMitmTable_create(2, mismatches, MITM_SUBSEED_LENGTH)) == NULL) {
+        return -1;
+    }
+
+    mpz_inits(first_perm, last_perm, NULL);
+
+    memcpy(client_seed, host_seed, EC_PRIV_KEY_SIZE);
+    for (int i = 0; i < mismatches; i++) {
+        client_seed[positions[i] / 8] ^= 1 << (positions[i] % 8);
+    }
+
+    getPermPair(first_perm, last_perm, 0, 1, table->half, MITM_SUBSEED_LENGTH - table->rest);
+    if (EcMitmTable_fill(table, wrapper->group, host_seed, first_perm, last_perm) ||
+        getEcPublicKey(wrapper->point, NULL, wrapper->group, client_seed, EC_PRIV_KEY_SIZE) ||
+        (v = EcMitmValidator_create(wrapper->group, wrapper->point, host_seed, table)) == NULL) {
+        status = -1;
+    }
+
+    if (!status) {
+        // Walk the ways to corrupt the rest of the positions
+        getPermPair(first_perm, last_perm, 0, 1, table->rest, MITM_SUBSEED_LENGTH);
+        EcMitmValidator_setLastPerm(v, last_perm);
+        EcMitmValidator_getBatch(&crypto_batch, v);
+
+        found = findMatchingSeed(found_seed, host_seed, first_perm, last_perm, 0, NULL, &signal,
+                                 &crypto_batch, v);
+
+        if (found < 0) {
+            status = -1;
+        } else if (found == 0 || memcmp(found_seed, client_seed, EC_PRIV_KEY_SIZE) != 0) {
+            fprintf(stderr, "ERROR: findMatchingSeed returned %d with the wrong seed.\n", found);
+            status = 1;
+        }
+    }
+
+    EcMitmValidator_destroy(v);
+    mpz_clears(first_perm, last_perm, NULL);
+    EcMitmTable_destroy(table);
+
+    return status;
+}
+
 int main() {
     unsigned char private_key[EC_PRIV_KEY_SIZE] = {
             0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a,
@@ -155,6 +652,62 @@ int main() {
     }
     printf("\n");
 
+    printf("Stepped Public Keys: Test ");
+    if ((cmp_status = ecStepTest(test_wrapper, private_key)) == 0) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+        status = EXIT_FAILURE;
+    }
+
+    printf("Stepped Public Keys From a Base: Test ");
+    if ((cmp_status = ecStepBaseTest(test_wrapper, private_key)) == 0) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+        status = EXIT_FAILURE;
+    }
+
+    printf("Custom P-256 Public Keys: Test ");
+    if ((cmp_status = p256StepTest(test_wrapper, private_key)) == 0) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+        status = EXIT_FAILURE;
+    }
+
+    printf("Custom P-256 Public Keys in Lanes: Test ");
+    if ((cmp_status = p256LanesTest(test_wrapper, private_key)) == 0) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+        status = EXIT_FAILURE;
+    }
+
+    printf("Custom Secp256k1 Public Keys: Test ");
+    if ((cmp_status = secp256k1StepTest(private_key)) == 0) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+        status = EXIT_FAILURE;
+    }
+
+    printf("Meet-in-the-Middle Table: Test ");
+    if ((cmp_status = ecMitmTest(test_wrapper, private_key)) == 0) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+        status = EXIT_FAILURE;
+    }
+
+    printf("Meet-in-the-Middle Search: Test ");
+    if ((cmp_status = ecMitmSearchTest(test_wrapper, private_key)) == 0) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+        status = EXIT_FAILURE;
+    }
+
     EcTestWrapper_destroy(test_wrapper);
 
     return status;
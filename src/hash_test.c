@@ -5,11 +5,36 @@
 #include "crypto/hash.h"
 
 #include <memory.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "crypto/hash_mb.h"
+#include "crypto/keccak_mb.h"
+#include "test_util.h"
+#include "validator.h"
+
 #define TEST_SIZE 10
 #define MAX_DIGEST_SIZE 64
+#define MB_KEY_COUNT MULTI_KEY_COUNT(HASH_MB_AVX512_LANES, HASH_MB_AVX2_LANES)
+#define SHA512_MB_KEY_COUNT MULTI_KEY_COUNT(SHA512_MB_AVX512_LANES, SHA512_MB_AVX2_LANES)
+#define KECCAK_MB_TEST_SIZE 6
+// The digest size to squeeze out of SHAKE
+#define SHAKE_DIGEST_SIZE 32
+// The most bytes to squeeze out of an XOF at once, which is more than a whole SHAKE128 block
+#define MAX_XOF_DIGEST_SIZE 200
+
+typedef int (*HashFunc)(unsigned char*, const unsigned char*, size_t, const unsigned char*, size_t);
+typedef int (*XofHashFunc)(unsigned char*, size_t, const unsigned char*, size_t,
+                           const unsigned char*, size_t);
+typedef void (*MbTargetFunc)(HashMbTarget*, const uint32_t*, const unsigned char*);
+typedef uint32_t (*MbMatchFunc)(const uint32_t*, size_t, const uint32_t*,
+                                const HashMbTarget*);
+typedef uint32_t (*Sha512MbMatchFunc)(const uint64_t*, size_t, const uint64_t*,
+                                      const unsigned char*);
+typedef uint32_t (*NiMatchFunc)(const unsigned char*, size_t, const uint32_t*,
+                                const unsigned char*);
+typedef uint32_t (*KeccakMbMatchFunc)(const unsigned char*, size_t, const KeccakMbTarget*);
 
 void printHex(const unsigned char* array, size_t count) {
     for (size_t i = 0; i < count; i++) {
@@ -54,6 +79,295 @@ int genericTest(const char* name, const EVP_MD* md, const unsigned char* msg, si
     return status;
 }
 
+/// Check that a multi-buffer kernel matches each key against its digest from the scalar hash
+/// function, and only that key. A target whose early word still matches but whose digest doesn't
+/// must match nothing, so that the kernel is known to check the whole digest after the early one.
+/// \param match_func A kernel that takes SoA keys, or NULL if using ni_match_func.
+/// \param target_func What builds match_func's target, or NULL if using ni_match_func.
+/// \param ni_match_func A SHA-NI kernel that takes AoS keys, or NULL if using match_func.
+/// \return Returns 0 if they all match, 1 if not, or -1 on error.
+int mbTest(const char* name, MbMatchFunc match_func, MbTargetFunc target_func,
+           NiMatchFunc ni_match_func, HashFunc hash_func, const uint32_t* tail,
+           const unsigned char* seed, const unsigned char* salt, size_t salt_size) {
+    unsigned char keys[MB_KEY_COUNT][HASH_MB_KEY_SIZE];
+    uint32_t soa_keys[MB_KEY_COUNT * HASH_MB_KEY_SIZE / sizeof(uint32_t)];
+    unsigned char digest[MAX_DIGEST_SIZE];
+    HashMbTarget target;
+    int status = 0;
+
+    corruptKeys(keys[0], seed, HASH_MB_KEY_SIZE, MB_KEY_COUNT, HASH_MB_KEY_SIZE);
+
+    // Transpose the keys into 32-bit words
+    for (size_t i = 0; i < MB_KEY_COUNT; i++) {
+        for (size_t w = 0; w < HASH_MB_KEY_SIZE / sizeof(uint32_t); w++) {
+            memcpy(&soa_keys[w * MB_KEY_COUNT + i], keys[i] + w * sizeof(uint32_t),
+                   sizeof(uint32_t));
+        }
+    }
+
+    for (size_t i = 0; i < MB_KEY_COUNT; i++) {
+        if (hash_func(digest, keys[i], HASH_MB_KEY_SIZE, salt, salt_size)) {
+            fprintf(stderr, "ERROR: %s hash failed\n", name);
+            return -1;
+        }
+
+        if (match_func == NULL) {
+            if (ni_match_func(keys[0], MB_KEY_COUNT, tail, digest) != UINT32_C(1) << i) {
+                status = 1;
+            }
+            continue;
+        }
+
+        target_func(&target, tail, digest);
+        if (match_func(soa_keys, MB_KEY_COUNT, tail, &target) != UINT32_C(1) << i) {
+            status = 1;
+        }
+
+        target.words[target.word_count - 1] ^= 1;
+        if (match_func(soa_keys, MB_KEY_COUNT, tail, &target) != 0) {
+            status = 1;
+        }
+    }
+
+    printf("%s %s%s: Test %s\n", name, match_func != NULL ? "Multi-Buffer" : "SHA-NI",
+           salt_size > 0 ? " (Salted)" : "", status ? "Failed" : "Passed");
+
+    return status;
+}
+
+/// The same as mbTest, but for the SHA-384/SHA-512 kernels, which take keys in 64-bit words.
+/// \return Returns 0 if they all match, 1 if not, or -1 on error.
+int sha512MbTest(const char* name, Sha512MbMatchFunc match_func, HashFunc hash_func,
+                 const uint64_t* tail, const unsigned char* seed, const unsigned char* salt,
+                 size_t salt_size) {
+    unsigned char keys[SHA512_MB_KEY_COUNT][HASH_MB_KEY_SIZE];
+    uint64_t soa_keys[SHA512_MB_KEY_COUNT * HASH_MB_KEY_SIZE / sizeof(uint64_t)];
+    unsigned char digest[MAX_DIGEST_SIZE];
+    int status = 0;
+
+    corruptKeys(keys[0], seed, HASH_MB_KEY_SIZE, SHA512_MB_KEY_COUNT, HASH_MB_KEY_SIZE);
+
+    // Transpose the keys into 64-bit words
+    for (size_t i = 0; i < SHA512_MB_KEY_COUNT; i++) {
+        for (size_t w = 0; w < HASH_MB_KEY_SIZE / sizeof(uint64_t); w++) {
+            memcpy(&soa_keys[w * SHA512_MB_KEY_COUNT + i], keys[i] + w * sizeof(uint64_t),
+                   sizeof(uint64_t));
+        }
+    }
+
+    for (size_t i = 0; i < SHA512_MB_KEY_COUNT; i++) {
+        if (hash_func(digest, keys[i], HASH_MB_KEY_SIZE, salt, salt_size)) {
+            fprintf(stderr, "ERROR: %s hash failed\n", name);
+            return -1;
+        }
+
+        if (match_func(soa_keys, SHA512_MB_KEY_COUNT, tail, digest) != UINT32_C(1) << i) {
+            status = 1;
+        }
+    }
+
+    printf("%s Multi-Buffer%s: Test %s\n", name, salt_size > 0 ? " (Salted)" : "",
+           status ? "Failed" : "Passed");
+
+    return status;
+}
+
+/// Check that a parallel Keccak kernel matches key i against its digest, and only that key, and
+/// matches nothing once the end of the digest is off, past the first lane the kernels check early.
+/// \return Returns 0 if so, or 1 if not.
+int keccakMbTargetTest(KeccakMbMatchFunc match_func, const unsigned char* keys, size_t i,
+                       const uint64_t* tail, size_t rate, unsigned char* digest,
+                       size_t digest_size) {
+    KeccakMbTarget target;
+    int status = 0;
+
+    if (keccakMbTarget(&target, tail, rate, digest, digest_size) ||
+        match_func(keys, MB_KEY_COUNT, &target) != UINT32_C(1) << i) {
+        return 1;
+    }
+
+    digest[digest_size - 1] ^= 0x01;
+
+    if (keccakMbTarget(&target, tail, rate, digest, digest_size) ||
+        match_func(keys, MB_KEY_COUNT, &target) != 0) {
+        status = 1;
+    }
+
+    digest[digest_size - 1] ^= 0x01;
+
+    return status;
+}
+
+/// Check that the parallel Keccak kernel matches each key against its digest from OpenSSL, and
+/// only that key.
+/// \return Returns 0 if they all match, 1 if not, or -1 on error.
+int keccakMbTest(const char* name, const EVP_MD* md, size_t rate, unsigned char suffix,
+                 const unsigned char* seed, const unsigned char* salt, size_t salt_size) {
+    unsigned char keys[MB_KEY_COUNT][KECCAK_MB_KEY_SIZE];
+    unsigned char digest[MAX_DIGEST_SIZE];
+    uint64_t tail[KECCAK_MB_TAIL_LANES];
+    int is_xof = EVP_MD_flags(md) & EVP_MD_FLAG_XOF;
+    size_t digest_size = is_xof ? SHAKE_DIGEST_SIZE : (size_t)EVP_MD_size(md);
+    int status = 0;
+
+    if (keccakMbTail(tail, rate, suffix, salt, salt_size)) {
+        fprintf(stderr, "ERROR: keccakMbTail failed\n");
+        return -1;
+    }
+
+    corruptKeys(keys[0], seed, KECCAK_MB_KEY_SIZE, MB_KEY_COUNT, KECCAK_MB_KEY_SIZE);
+
+    for (size_t i = 0; i < MB_KEY_COUNT; i++) {
+        if (evpHash(digest, is_xof ? &digest_size : NULL, NULL, md, keys[i], KECCAK_MB_KEY_SIZE,
+                    salt, salt_size)) {
+            fprintf(stderr, "ERROR: %s evpHash failed\n", name);
+            return -1;
+        }
+
+        status |= keccakMbTargetTest(keccakMbMatch, keys[0], i, tail, rate, digest, digest_size);
+    }
+
+    printf("%s Parallel Keccak%s: Test %s\n", name, salt_size > 0 ? " (Salted)" : "",
+           status ? "Failed" : "Passed");
+
+    return status;
+}
+
+/// Check that the parallel KangarooTwelve kernel matches each key against its digest from XKCP's
+/// tree hash, and only that key.
+/// \return Returns 0 if they all match, 1 if not, or -1 on error.
+int kang12MbTest(const unsigned char* seed, const unsigned char* salt, size_t salt_size) {
+    unsigned char keys[MB_KEY_COUNT][KECCAK_MB_KEY_SIZE];
+    unsigned char digest[MAX_DIGEST_SIZE];
+    uint64_t tail[KECCAK_MB_TAIL_LANES];
+    int status = 0;
+
+    if (kang12MbTail(tail, salt, salt_size)) {
+        fprintf(stderr, "ERROR: kang12MbTail failed\n");
+        return -1;
+    }
+
+    corruptKeys(keys[0], seed, KECCAK_MB_KEY_SIZE, MB_KEY_COUNT, KECCAK_MB_KEY_SIZE);
+
+    for (size_t i = 0; i < MB_KEY_COUNT; i++) {
+        if (kang12Hash(digest, SHAKE_DIGEST_SIZE, keys[i], KECCAK_MB_KEY_SIZE, salt, salt_size)) {
+            fprintf(stderr, "ERROR: kang12Hash failed\n");
+            return -1;
+        }
+
+        status |= keccakMbTargetTest(kang12MbMatch, keys[0], i, tail, KANG12_RATE, digest,
+                                     SHAKE_DIGEST_SIZE);
+    }
+
+    printf("KangarooTwelve Parallel Keccak%s: Test %s\n", salt_size > 0 ? " (Salted)" : "",
+           status ? "Failed" : "Passed");
+
+    return status;
+}
+
+/// Check that one of the XKCP hash functions gives the same digest as OpenSSL, both with and
+/// without the salt.
+/// \return Returns 0 if they match, 1 if not, or -1 on error.
+int xkcpHashTest(const char* name, const EVP_MD* md, HashFunc hash_func, const unsigned char* msg,
+                 size_t msg_size, const unsigned char* salt, size_t salt_size) {
+    unsigned char digest[MAX_DIGEST_SIZE], expected_digest[MAX_DIGEST_SIZE];
+    int status = 0;
+
+    for (int salted = 0; salted <= 1; salted++) {
+        const unsigned char* curr_salt = salted ? salt : NULL;
+        size_t size = salted ? salt_size : 0;
+
+        if (hash_func(digest, msg, msg_size, curr_salt, size) ||
+            evpHash(expected_digest, NULL, NULL, md, msg, msg_size, curr_salt, size)) {
+            fprintf(stderr, "ERROR: %s hash failed\n", name);
+            return -1;
+        }
+
+        status |= memcmp(digest, expected_digest, EVP_MD_size(md)) != 0;
+    }
+
+    printf("%s XKCP: Test %s\n", name, status ? "Failed" : "Passed");
+
+    return status;
+}
+
+/// The same as xkcpHashTest, but for an XOF, squeezing a few different sizes out of it. Each must
+/// fill exactly that many bytes of the digest.
+/// \return Returns 0 if they match, 1 if not, or -1 on error.
+int xkcpXofTest(const char* name, const EVP_MD* md, XofHashFunc hash_func,
+                const unsigned char* msg, size_t msg_size, const unsigned char* salt,
+                size_t salt_size) {
+    // A single byte, not a whole number of lanes, and more than a whole block
+    const size_t digest_sizes[] = {1, 35, MAX_XOF_DIGEST_SIZE};
+    unsigned char digest[MAX_XOF_DIGEST_SIZE + 1], expected_digest[MAX_XOF_DIGEST_SIZE];
+    int status = 0;
+
+    for (size_t i = 0; i < sizeof(digest_sizes) / sizeof(*digest_sizes); i++) {
+        for (int salted = 0; salted <= 1; salted++) {
+            const unsigned char* curr_salt = salted ? salt : NULL;
+            size_t digest_size = digest_sizes[i], size = salted ? salt_size : 0;
+
+            memset(digest, 0xA5, sizeof(digest));
+
+            if (hash_func(digest, digest_size, msg, msg_size, curr_salt, size) ||
+                evpHash(expected_digest, &digest_size, NULL, md, msg, msg_size, curr_salt,
+                        size)) {
+                fprintf(stderr, "ERROR: %s hash failed\n", name);
+                return -1;
+            }
+
+            status |= memcmp(digest, expected_digest, digest_size) != 0;
+            status |= digest[digest_size] != 0xA5;
+        }
+    }
+
+    printf("%s XKCP: Test %s\n", name, status ? "Failed" : "Passed");
+
+    return status;
+}
+
+/// Check that a HashValidator for an XOF compares every byte of the digest it was given, rather
+/// than as many as EVP_MD_size reports. It must match the seed, and no longer match once the last
+/// byte of the digest is off.
+/// \return Returns 0 if so, 1 if not, or -1 on error.
+int xofValidatorTest(const char* name, const EVP_MD* md, const unsigned char* seed,
+                     const unsigned char* salt, size_t salt_size) {
+    unsigned char digest[MAX_DIGEST_SIZE];
+    size_t digest_size = MAX_DIGEST_SIZE;
+    int status = 0;
+
+    if (evpHash(digest, &digest_size, NULL, md, seed, SEED_SIZE, salt, salt_size)) {
+        fprintf(stderr, "ERROR: %s evpHash failed\n", name);
+        return -1;
+    }
+
+    for (int off = 0; off <= 1 && status >= 0; off++) {
+        HashValidator* v;
+        int cmp_status;
+
+        digest[digest_size - 1] ^= (unsigned char)off;
+
+        if ((v = HashValidator_create(md, digest, digest_size, salt, salt_size)) == NULL) {
+            return -1;
+        }
+
+        if (CryptoFunc_hash(seed, v) || (cmp_status = CryptoCmp_hash(v)) < 0) {
+            status = -1;
+        } else if (cmp_status != off) {
+            status = 1;
+        }
+
+        HashValidator_destroy(v);
+    }
+
+    if (status >= 0) {
+        printf("%s Validator Digest Size%s: Test %s\n", name, salt_size > 0 ? " (Salted)" : "",
+               status ? "Failed" : "Passed");
+    }
+
+    return status;
+}
+
 int main() {
     const unsigned char seed[] = {
             0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a,
@@ -169,5 +483,139 @@ int main() {
         }
     }
 
+    printf("\n");
+
+    // Salted with the largest salt that still fits in the block, which is a prefix of the seed
+    for (size_t salt_size = 0; salt_size <= SHA256_MB_MAX_SALT_SIZE;
+         salt_size += SHA256_MB_MAX_SALT_SIZE) {
+        const unsigned char* salt = salt_size > 0 ? seed : NULL;
+        uint32_t md5_tail[MD5_MB_TAIL_WORDS], sha256_tail[SHA256_MB_TAIL_WORDS];
+
+        if (md5MbTail(md5_tail, salt, salt_size) || sha256MbTail(sha256_tail, salt, salt_size)) {
+            fprintf(stderr, "ERROR: Building the multi-buffer tail failed\n");
+            return EXIT_FAILURE;
+        }
+
+        int sub_status = mbTest("MD5", md5MbMatch, md5MbTarget, NULL, md5Hash, md5_tail, seed,
+                                salt, salt_size);
+        sub_status |= mbTest("SHA1", sha1MbMatch, sha1MbTarget, NULL, sha1Hash, sha256_tail, seed,
+                             salt, salt_size);
+        sub_status |= mbTest("SHA224", sha224MbMatch, sha224MbTarget, NULL, sha224Hash,
+                             sha256_tail, seed, salt, salt_size);
+        sub_status |= mbTest("SHA256", sha256MbMatch, sha256MbTarget, NULL, sha256Hash,
+                             sha256_tail, seed, salt, salt_size);
+
+        if (hashMbHasShaNi()) {
+            sub_status |= mbTest("SHA1", NULL, NULL, sha1NiMatch, sha1Hash, sha256_tail, seed,
+                                 salt, salt_size);
+            sub_status |= mbTest("SHA224", NULL, NULL, sha224NiMatch, sha224Hash, sha256_tail,
+                                 seed, salt, salt_size);
+            sub_status |= mbTest("SHA256", NULL, NULL, sha256NiMatch, sha256Hash, sha256_tail,
+                                 seed, salt, salt_size);
+        }
+        if (sub_status < 0) {
+            return EXIT_FAILURE;
+        }
+        status |= sub_status;
+    }
+
+    unsigned char keccak_salt[KECCAK_MB_MAX_SALT_SIZE(SHAKE128_RATE)];
+
+    for (size_t i = 0; i < sizeof(keccak_salt); i++) {
+        keccak_salt[i] = (unsigned char)i;
+    }
+
+    for (size_t salt_size = 0; salt_size <= SHA512_MB_MAX_SALT_SIZE;
+         salt_size += SHA512_MB_MAX_SALT_SIZE) {
+        const unsigned char* salt = salt_size > 0 ? keccak_salt : NULL;
+        uint64_t sha512_tail[SHA512_MB_TAIL_WORDS];
+
+        if (sha512MbTail(sha512_tail, salt, salt_size)) {
+            fprintf(stderr, "ERROR: Building the multi-buffer tail failed\n");
+            return EXIT_FAILURE;
+        }
+
+        int sub_status = sha512MbTest("SHA384", sha384MbMatch, sha384Hash, sha512_tail, seed,
+                                      salt, salt_size);
+        sub_status |= sha512MbTest("SHA512", sha512MbMatch, sha512Hash, sha512_tail, seed, salt,
+                                   salt_size);
+        if (sub_status < 0) {
+            return EXIT_FAILURE;
+        }
+        status |= sub_status;
+    }
+
+    const EVP_MD* keccak_mds[KECCAK_MB_TEST_SIZE] = {
+            EVP_sha3_224(), EVP_sha3_256(), EVP_sha3_384(),
+            EVP_sha3_512(), EVP_shake128(), EVP_shake256(),
+    };
+    const char* keccak_names[KECCAK_MB_TEST_SIZE] = {
+            "SHA3-224", "SHA3-256", "SHA3-384", "SHA3-512", "SHAKE128", "SHAKE256",
+    };
+    const size_t keccak_rates[KECCAK_MB_TEST_SIZE] = {
+            SHA3_224_RATE, SHA3_256_RATE, SHA3_384_RATE,
+            SHA3_512_RATE, SHAKE128_RATE, SHAKE256_RATE,
+    };
+
+    // Also salted with the largest salt that still fits in the block, which shares its last byte
+    // between the suffix and the final padding bit
+    for (size_t i = 0; i < KECCAK_MB_TEST_SIZE; i++) {
+        unsigned char suffix = i < 4 ? SHA3_SUFFIX : SHAKE_SUFFIX;
+        size_t max_salt_size = KECCAK_MB_MAX_SALT_SIZE(keccak_rates[i]);
+
+        int sub_status = keccakMbTest(keccak_names[i], keccak_mds[i], keccak_rates[i], suffix,
+                                      seed, NULL, 0);
+        sub_status |= keccakMbTest(keccak_names[i], keccak_mds[i], keccak_rates[i], suffix, seed,
+                                   keccak_salt, max_salt_size);
+        if (sub_status < 0) {
+            return EXIT_FAILURE;
+        }
+        status |= sub_status;
+    }
+
+    int sub_status = kang12MbTest(seed, NULL, 0);
+    sub_status |= kang12MbTest(seed, keccak_salt, KANG12_MB_MAX_SALT_SIZE);
+    if (sub_status < 0) {
+        return EXIT_FAILURE;
+    }
+    status |= sub_status;
+
+    printf("\n");
+
+    const char* sha3_names[] = {"SHA3-224", "SHA3-256", "SHA3-384", "SHA3-512"};
+    const EVP_MD* sha3_mds[] = {EVP_sha3_224(), EVP_sha3_256(), EVP_sha3_384(), EVP_sha3_512()};
+    const HashFunc sha3_funcs[] = {sha3_224Hash, sha3_256Hash, sha3_384Hash, sha3_512Hash};
+
+    for (size_t i = 0; i < sizeof(sha3_funcs) / sizeof(*sha3_funcs); i++) {
+        int sub_status = xkcpHashTest(sha3_names[i], sha3_mds[i], sha3_funcs[i], seed,
+                                      sizeof(seed), seed, sizeof(seed));
+        if (sub_status < 0) {
+            return EXIT_FAILURE;
+        }
+        status |= sub_status;
+    }
+
+    const char* shake_names[] = {"SHAKE128", "SHAKE256"};
+    const EVP_MD* shake_mds[] = {EVP_shake128(), EVP_shake256()};
+    const XofHashFunc shake_funcs[] = {shake128Hash, shake256Hash};
+
+    for (size_t i = 0; i < sizeof(shake_funcs) / sizeof(*shake_funcs); i++) {
+        int sub_status = xkcpXofTest(shake_names[i], shake_mds[i], shake_funcs[i], seed,
+                                     sizeof(seed), seed, sizeof(seed));
+        if (sub_status < 0) {
+            return EXIT_FAILURE;
+        }
+        status |= sub_status;
+    }
+
+    for (size_t i = 0; i < sizeof(shake_mds) / sizeof(*shake_mds); i++) {
+        int sub_status = xofValidatorTest(shake_names[i], shake_mds[i], seed, NULL, 0);
+        sub_status |= xofValidatorTest(shake_names[i], shake_mds[i], seed, seed, sizeof(seed));
+        if (sub_status < 0) {
+            return EXIT_FAILURE;
+        }
+        status |= sub_status;
+    }
+
     return status ? EXIT_FAILURE : EXIT_SUCCESS;
 }
\ No newline at end of file
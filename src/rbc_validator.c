@@ -18,6 +18,8 @@
 #include "crypto/cipher.h"
 #include "crypto/ec.h"
 #include "crypto/hash.h"
+#include "crypto/x25519.h"
+#include "ec_mitm.h"
 #include "perm.h"
 #include "seed_iter.h"
 #include "util.h"
@@ -53,6 +55,8 @@ enum StatusCode { SC_Found = 0, SC_NotFound = 1, SC_Failure = 2 };
 #define MODE_HASH 0b100
 // Used alongside MODE_HASH for a custom digest_size
 #define MODE_XOF 0b1000
+// Used with matching an X25519 public key
+#define MODE_X25519 0b10000
 
 #define DEFAULT_XOF_SIZE 32
 
@@ -70,6 +74,8 @@ const Algo supportedAlgos[] = {
         {"chacha20", "ChaCha20", NID_chacha20, MODE_CIPHER},
         // EC algorithms
         {"ecc", "Secp256r1", NID_X9_62_prime256v1, MODE_EC},
+        {"secp256k1", "Secp256k1", NID_secp256k1, MODE_EC},
+        {"x25519", "X25519", NID_X25519, MODE_X25519},
         // Hashing algorithms
         {"md5", "MD5", NID_md5, MODE_HASH},
         {"sha1", "SHA1", NID_sha1, MODE_HASH},
@@ -145,6 +151,11 @@ int validateArgs(const struct gengetopt_args_info* args_info) {
         return 1;
     }
 
+    if (args_info->ecc_memory_arg < 0) {
+        fprintf(stderr, "--ecc-memory cannot be negative.\n");
+        return 1;
+    }
+
 #ifndef USE_MPI
     if (args_info->threads_arg > omp_get_thread_limit()) {
         fprintf(stderr, "--threads exceeds program thread limit.\n");
@@ -250,6 +261,19 @@ int parse_params(struct Params* params, const struct gengetopt_args_info* args_i
         }
         EC_GROUP_free(group);
 
+        params->client_crypto_hex = args_info->inputs[1];
+    } else if (algo->mode & MODE_X25519) {
+        if (args_info->inputs_num != 2) {
+            fprintf(stderr, "%s\n", gengetopt_args_info_usage);
+            return 1;
+        }
+
+        if (strlen(args_info->inputs[1]) != X25519_KEY_SIZE * 2) {
+            fprintf(stderr, "CLIENT_PUB_KEY not %d bytes for %s\n", X25519_KEY_SIZE,
+                    algo->full_name);
+            return 1;
+        }
+
         params->client_crypto_hex = args_info->inputs[1];
     } else if (algo->mode & MODE_HASH) {
         if (args_info->inputs_num < 2 || args_info->inputs_num > 3) {
@@ -302,6 +326,37 @@ int parse_hex_handler(unsigned char* buffer, const char* hex) {
     return status != 0;
 }
 
+/// Fill one rank's share of an EcMitmTable.
+/// \param table The table to fill.
+/// \param group The EC group the seeds are private keys of.
+/// \param host_seed The seed being corrupted.
+/// \param rank Which share to fill, starting from 0.
+/// \param rank_count How many shares the table is split into.
+/// \return Returns 0 on success, or 1 on error.
+int fillEcMitmTable(EcMitmTable* table, const EC_GROUP* group, const unsigned char* host_seed,
+                    size_t rank, size_t rank_count) {
+    mpz_t entry_count, first_perm, last_perm;
+    int status = 0;
+
+    mpz_inits(entry_count, first_perm, last_perm, NULL);
+
+    EcMitmTable_count(entry_count, table);
+
+    if (mpz_cmp_ui(entry_count, rank) > 0) {
+        if (mpz_cmp_ui(entry_count, rank_count) < 0) {
+            rank_count = mpz_get_ui(entry_count);
+        }
+
+        getPermPair(first_perm, last_perm, rank, rank_count, table->half,
+                    table->subseed_length - table->rest);
+        status = EcMitmTable_fill(table, group, host_seed, first_perm, last_perm);
+    }
+
+    mpz_clears(entry_count, first_perm, last_perm, NULL);
+
+    return status;
+}
+
 /// OpenMP implementation
 /// \return Returns a 0 on successfully finding a match, a 1 when unable to find a match,
 /// and a 2 when a general error has occurred.
@@ -330,6 +385,9 @@ int main(int argc, char* argv[]) {
     unsigned char iv[EVP_MAX_IV_LENGTH];
     EC_GROUP* ec_group;
     EC_POINT* client_ec_point;
+    EcMitmTable* ec_table;
+    size_t ecc_memory;
+    unsigned char client_x25519[X25519_KEY_SIZE];
     unsigned char* client_digest;
     size_t digest_size;
     const EVP_MD* md;
@@ -386,6 +444,7 @@ int main(int argc, char* argv[]) {
     count_flag = args_info.count_flag;
     verbose_flag = args_info.verbose_flag;
     subseed_length = args_info.subkey_arg;
+    ecc_memory = (size_t)args_info.ecc_memory_arg << 20;
 
     mismatch = 0;
     ending_mismatch = args_info.subkey_arg;
@@ -524,6 +583,8 @@ int main(int argc, char* argv[]) {
 
                     return SC_Failure;
                 }
+            } else if (algo->mode & MODE_X25519) {
+                x25519PublicKey(client_x25519, client_seed);
             } else if (algo->mode & MODE_HASH) {
                 int hash_status;
 
@@ -585,6 +646,8 @@ int main(int argc, char* argv[]) {
             MPI_Bcast(client_public_key, len, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
 
             EC_POINT_oct2point(ec_group, client_ec_point, client_public_key, len, NULL);
+        } else if (algo->mode & MODE_X25519) {
+            MPI_Bcast(client_x25519, X25519_KEY_SIZE, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
         } else if (algo->mode & MODE_HASH) {
             MPI_Bcast(client_digest, digest_size, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
         }
@@ -611,6 +674,8 @@ int main(int argc, char* argv[]) {
                             ERR_error_string(ERR_get_error(), NULL));
                     parse_status = 1;
                 }
+            } else if (algo->mode & MODE_X25519) {
+                parse_status = parse_hex_handler(client_x25519, params.client_crypto_hex);
             }
         }
 
@@ -734,6 +799,11 @@ int main(int argc, char* argv[]) {
                 return SC_Failure;
             }
             fprintf(stderr, "\n");
+        } else if (algo->mode & MODE_X25519) {
+            fprintf(stderr, "INFO: Using %s CLIENT_PUB_KEY:%*s", algo->full_name,
+                    13 - (int)strlen(algo->full_name), "");
+            fprintHex(stderr, client_x25519, X25519_KEY_SIZE);
+            fprintf(stderr, "\n");
         } else if (algo->mode & MODE_HASH) {
             fprintf(stderr, "INFO: Using %s ", algo->full_name);
             if (algo->mode & MODE_XOF) {
@@ -773,12 +843,34 @@ int main(int argc, char* argv[]) {
             fflush(stderr);
         }
 
+        ec_table = NULL;
+
+        // Split larger hamming distances between a table of public keys and a walk over the rest
+        if (algo->mode & MODE_EC) {
+            int half = EcMitmTable_half(mismatch, subseed_length, ecc_memory);
+
+            if (half > 0 &&
+                (ec_table = EcMitmTable_create(half, mismatch, subseed_length)) == NULL) {
+                fprintf(stderr, "WARNING: EcMitmTable_create failed, checking every seed.\n");
+            }
+
+            if (ec_table != NULL && verbose_flag
+#ifdef USE_MPI
+                && my_rank == 0
+#endif
+            ) {
+                fprintf(stderr, "INFO: Looking up %d of the %d bits in a table...\n", half,
+                        mismatch);
+                fflush(stderr);
+            }
+        }
+
 #ifndef USE_MPI
 #pragma omp parallel default(none)                                                           \
         shared(found, host_seed, client_seed, evp_cipher, client_cipher, iv, uuid, ec_group, \
-               client_ec_point, md, client_digest, digest_size, salt, salt_size, mismatch,   \
-               validated_keys, algo, subseed_length, all_flag, count_flag,                   \
-               verbose_flag) private(subfound, my_rank)
+               client_ec_point, ec_table, client_x25519, md, client_digest, digest_size,     \
+               salt, salt_size, mismatch, validated_keys, algo, subseed_length, all_flag,    \
+               count_flag, verbose_flag) private(subfound, my_rank)
         {
         long long int sub_validated_keys = 0;
         my_rank = omp_get_thread_num();
@@ -786,49 +878,77 @@ int main(int argc, char* argv[]) {
 
         size_t max_count;
         mpz_t key_count, first_perm, last_perm;
+        // How many bits each seed the iterator walks is corrupted in
+        int iter_mismatch = mismatch;
 
-        int (*crypto_func)(const unsigned char*, void*) = NULL;
-        int (*crypto_cmp)(void*) = NULL;
+        CryptoBatch crypto_batch = {NULL, CRYPTO_BATCH_SCALAR_LANES, SEED_LAYOUT_AOS, NULL};
 
         void* v_args = NULL;
 
         subfound = 0;
 
         if (algo->mode & MODE_CIPHER) {
-#ifndef ALWAYS_EVP_AES
+            crypto_batch.func = CryptoBatch_cipher;
+
             // Use a custom implementation for improved speed
+#ifndef ALWAYS_EVP_AES
             if (algo->nid == NID_aes_256_ecb) {
-                crypto_func = CryptoFunc_aes256;
-                crypto_cmp = CryptoCmp_aes256;
-            } else {
+                crypto_batch.func = CryptoBatch_aes256;
+                // Two groups of AES256_ECB_LANES keys per block to amortize the iteration
+                crypto_batch.lanes = SEED_BATCH_MAX;
+            }
 #endif
-                crypto_func = CryptoFunc_cipher;
-                crypto_cmp = CryptoCmp_cipher;
-#ifndef ALWAYS_EVP_AES
+#ifndef ALWAYS_EVP_CHACHA20
+            if (algo->nid == NID_chacha20) {
+                crypto_batch.func = CryptoBatch_chacha20;
+                crypto_batch.lanes = CHACHA20_AVX512_LANES;
+                crypto_batch.layout = SEED_LAYOUT_SOA32;
             }
 #endif
 
             v_args = CipherValidator_create(evp_cipher, client_cipher, uuid, UUID_SIZE,
                                             EVP_CIPHER_iv_length(evp_cipher) > 0 ? iv : NULL);
         } else if (algo->mode & MODE_EC) {
-            crypto_func = CryptoFunc_ec;
-            crypto_cmp = CryptoCmp_ec;
-            v_args = EcValidator_create(ec_group, client_ec_point);
+            if (ec_table != NULL) {
+#ifdef USE_MPI
+                // Every rank looks up the whole table
+                subfound = -fillEcMitmTable(ec_table, ec_group, host_seed, 0, 1);
+#else
+                subfound = -fillEcMitmTable(ec_table, ec_group, host_seed, (size_t)my_rank,
+                                            omp_get_num_threads());
+#pragma omp barrier
+#endif
+
+                iter_mismatch = ec_table->rest;
+                v_args = EcMitmValidator_create(ec_group, client_ec_point, host_seed, ec_table);
+                EcMitmValidator_getBatch(&crypto_batch, v_args);
+            } else {
+                v_args = EcValidator_create(ec_group, client_ec_point, host_seed,
+                                            (size_t)subseed_length);
+                EcValidator_getBatch(&crypto_batch, v_args);
+            }
+        } else if (algo->mode & MODE_X25519) {
+            crypto_batch.func = CryptoBatch_x25519;
+            // Consecutive seeds are stepped from each other either way, so amortize the iteration
+            crypto_batch.lanes = SEED_BATCH_MAX;
+            v_args = X25519Validator_create(client_x25519, host_seed, (size_t)subseed_length);
         } else if (algo->mode & MODE_HASH) {
             if (algo->nid == NID_kang12) {
-                crypto_func = CryptoFunc_kang12;
-                crypto_cmp = CryptoCmp_kang12;
-                v_args = Kang12Validator_create(client_digest, digest_size, salt, salt_size);
+                Kang12Validator* kang12_args =
+                        Kang12Validator_create(client_digest, digest_size, salt, salt_size);
+                Kang12Validator_getBatch(&crypto_batch, kang12_args);
+                v_args = kang12_args;
             } else {
-                crypto_func = CryptoFunc_hash;
-                crypto_cmp = CryptoCmp_hash;
-                v_args = HashValidator_create(md, client_digest, digest_size, salt, salt_size);
+                HashValidator* hash_args =
+                        HashValidator_create(md, client_digest, digest_size, salt, salt_size);
+                HashValidator_getBatch(&crypto_batch, hash_args);
+                v_args = hash_args;
             }
         }
 
         mpz_inits(key_count, first_perm, last_perm, NULL);
 
-        mpz_bin_uiui(key_count, subseed_length, mismatch);
+        mpz_bin_uiui(key_count, subseed_length, iter_mismatch);
 
         // Only have this rank run if it's within range of possible keys
         if (mpz_cmp_ui(key_count, (unsigned long)my_rank) > 0 && subfound >= 0) {
@@ -844,17 +964,24 @@ int main(int argc, char* argv[]) {
                 max_count = mpz_get_ui(key_count);
             }
 
-                getPermPair(first_perm, last_perm, (size_t)my_rank, max_count, mismatch,
+                getPermPair(first_perm, last_perm, (size_t)my_rank, max_count, iter_mismatch,
                             subseed_length);
 
+            // The lookups are held back until the walk's last seed is in
+            if (ec_table != NULL) {
+                EcMitmValidator_setLastPerm(v_args, last_perm);
+            }
+
 #ifdef USE_MPI
             subfound = findMatchingSeed(client_seed, host_seed, first_perm, last_perm, all_flag,
-                                        count_flag ? &validated_keys : NULL, &found, verbose_flag,
-                                        my_rank, max_count, crypto_func, crypto_cmp, v_args);
+                                        count_flag && ec_table == NULL ? &validated_keys : NULL,
+                                        &found, verbose_flag,
+                                        my_rank, max_count, &crypto_batch, v_args);
 #else
             subfound = findMatchingSeed(client_seed, host_seed, first_perm, last_perm, all_flag,
-                                        count_flag ? &sub_validated_keys : NULL, &found,
-                                        crypto_func, crypto_cmp, v_args);
+                                        count_flag && ec_table == NULL ? &sub_validated_keys
+                                                                       : NULL,
+                                        &found, &crypto_batch, v_args);
 #endif
         }
 
@@ -862,7 +989,24 @@ int main(int argc, char* argv[]) {
         if (algo->mode & MODE_CIPHER) {
             CipherValidator_destroy(v_args);
         } else if (algo->mode & MODE_EC) {
-            EcValidator_destroy(v_args);
+            if (ec_table != NULL) {
+                EcMitmValidator* mitm_args = v_args;
+
+                // Count every seed the walk stood for rather than the seeds it walked
+                if (count_flag && mitm_args != NULL) {
+#ifdef USE_MPI
+                    validated_keys += mitm_args->covered;
+#else
+                    sub_validated_keys += mitm_args->covered;
+#endif
+                }
+
+                EcMitmValidator_destroy(v_args);
+            } else {
+                EcValidator_destroy(v_args);
+            }
+        } else if (algo->mode & MODE_X25519) {
+            X25519Validator_destroy(v_args);
         } else if (algo->mode & MODE_HASH) {
             if (algo->nid == NID_kang12) {
                 Kang12Validator_destroy(v_args);
@@ -905,6 +1049,8 @@ int main(int argc, char* argv[]) {
         }
         }
 #endif
+
+        EcMitmTable_destroy(ec_table);
     }
 
     if (algo->mode & MODE_EC) {
@@ -6,6 +6,11 @@
 
 #include <string.h>
 
+/// Store a single key into a lane of a SeedIter_nextN block.
+static void storeLane(unsigned char* block, const unsigned char* seed, size_t lane, size_t count,
+                      SeedLayout layout);
+
+#ifdef ALWAYS_GMP_ITER
 void mpn_overflowingRshift(mp_limb_t* rop, const mp_limb_t* op1, mp_size_t n, unsigned int shift);
 
 int SeedIter_init(SeedIter* iter, const unsigned char* seed, size_t seed_size,
@@ -78,4 +83,97 @@ void mpn_overflowingRshift(mp_limb_t* rop, const mp_limb_t* op1, mp_size_t n, un
     if (shift > 0) {
         mpn_rshift(rop, op1, n, shift);
     }
-}
\ No newline at end of file
+}
+#else
+int SeedIter_init(SeedIter* iter, const unsigned char* seed, size_t seed_size,
+                  const mpz_t first_perm, const mpz_t last_perm) {
+    if (iter == NULL || seed == NULL || seed_size > SEED_SIZE ||
+        mpz_sizeinbase(first_perm, 2) > SEED_SIZE * 8 ||
+        mpz_sizeinbase(last_perm, 2) > SEED_SIZE * 8) {
+        return 1;
+    }
+
+    memset(iter, 0, sizeof(*iter));
+
+    // Least significant word first, each word in native endianness, same as the mpn limbs
+    mpz_export(iter->curr_perm, NULL, -1, sizeof(*(iter->curr_perm)), 0, 0, first_perm);
+    mpz_export(iter->last_perm, NULL, -1, sizeof(*(iter->last_perm)), 0, 0, last_perm);
+
+    memcpy(iter->seed, seed, seed_size);
+
+    // Perform an XOR operation between the permutation and the key.
+    // If a bit is set in permutation, then flip the bit in the key.
+    // Otherwise, leave it as is.
+    for (unsigned int i = 0; i < ITER_WORD_SIZE; ++i) {
+        iter->corrupted_seed[i] = iter->seed[i] ^ iter->curr_perm[i];
+    }
+
+    return 0;
+}
+#endif
+
+size_t SeedIter_nextN(SeedIter* iter, void* seeds, size_t count, SeedLayout layout) {
+    unsigned char* block = seeds;
+    unsigned char last_seed[SEED_SIZE];
+    size_t produced;
+
+    for (produced = 0; produced < count && !SeedIter_end(iter); ++produced) {
+        storeLane(block, SeedIter_get(iter), produced, count, layout);
+        SeedIter_next(iter);
+    }
+
+    // Pad out a partial block with the last key so every lane holds a valid candidate
+    if (produced > 0 && produced < count) {
+        SeedIter_loadLane(last_seed, block, produced - 1, count, layout);
+
+        for (size_t lane = produced; lane < count; ++lane) {
+            storeLane(block, last_seed, lane, count, layout);
+        }
+    }
+
+    return produced;
+}
+
+static void storeLane(unsigned char* block, const unsigned char* seed, size_t lane, size_t count,
+                      SeedLayout layout) {
+    switch (layout) {
+        case SEED_LAYOUT_SOA32:
+            for (size_t i = 0; i < SEED_SIZE / sizeof(uint32_t); ++i) {
+                memcpy(block + (i * count + lane) * sizeof(uint32_t), seed + i * sizeof(uint32_t),
+                       sizeof(uint32_t));
+            }
+            break;
+        case SEED_LAYOUT_SOA64:
+            for (size_t i = 0; i < SEED_SIZE / sizeof(uint64_t); ++i) {
+                memcpy(block + (i * count + lane) * sizeof(uint64_t), seed + i * sizeof(uint64_t),
+                       sizeof(uint64_t));
+            }
+            break;
+        default:
+            memcpy(block + lane * SEED_SIZE, seed, SEED_SIZE);
+            break;
+    }
+}
+
+void SeedIter_loadLane(unsigned char* seed, const void* seeds, size_t lane, size_t count,
+                       SeedLayout layout) {
+    const unsigned char* block = seeds;
+
+    switch (layout) {
+        case SEED_LAYOUT_SOA32:
+            for (size_t i = 0; i < SEED_SIZE / sizeof(uint32_t); ++i) {
+                memcpy(seed + i * sizeof(uint32_t), block + (i * count + lane) * sizeof(uint32_t),
+                       sizeof(uint32_t));
+            }
+            break;
+        case SEED_LAYOUT_SOA64:
+            for (size_t i = 0; i < SEED_SIZE / sizeof(uint64_t); ++i) {
+                memcpy(seed + i * sizeof(uint64_t), block + (i * count + lane) * sizeof(uint64_t),
+                       sizeof(uint64_t));
+            }
+            break;
+        default:
+            memcpy(seed, block + lane * SEED_SIZE, SEED_SIZE);
+            break;
+    }
+}
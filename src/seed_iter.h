@@ -6,8 +6,20 @@
 #define RBC_VALIDATOR_SEED_ITER_H_
 
 #include <gmp.h>
+#include <stdint.h>
+
+#ifndef ALWAYS_GMP_ITER
+#include <x86intrin.h>
+#endif
 
 #define SEED_SIZE 32
+
+// The alignment SeedIter_nextN expects its output block to have, enough for an AVX-512 load
+#define SEED_BATCH_ALIGN 64
+// The largest block of seeds SeedIter_nextN is expected to fill at once
+#define SEED_BATCH_MAX 16
+
+#ifdef ALWAYS_GMP_ITER
 #define ITER_LIMB_SIZE (SEED_SIZE / sizeof(mp_limb_t))
 
 typedef struct SeedIter {
@@ -20,6 +32,31 @@ typedef struct SeedIter {
     mp_limb_t seed_mpn[ITER_LIMB_SIZE];
     mp_limb_t corrupted_seed_mpn[ITER_LIMB_SIZE];
 } SeedIter;
+#else
+#define ITER_WORD_BITS 64
+#define ITER_WORD_SIZE (SEED_SIZE / sizeof(uint64_t))
+
+typedef struct SeedIter {
+    // Private members
+    uint64_t overflow;
+    uint64_t curr_perm[ITER_WORD_SIZE];
+    uint64_t last_perm[ITER_WORD_SIZE];
+    uint64_t seed[ITER_WORD_SIZE];
+    uint64_t corrupted_seed[ITER_WORD_SIZE];
+} SeedIter;
+#endif
+
+/// How SeedIter_nextN lays out a block of seeds.
+typedef enum SeedLayout {
+    // Array of structures: byte b of lane j is at seeds[j * SEED_SIZE + b]
+    SEED_LAYOUT_AOS,
+    // Structure of arrays over 32-bit words: word i of lane j is at
+    // ((uint32_t*)seeds)[i * count + j]
+    SEED_LAYOUT_SOA32,
+    // Structure of arrays over 64-bit words: word i of lane j is at
+    // ((uint64_t*)seeds)[i * count + j]
+    SEED_LAYOUT_SOA64,
+} SeedLayout;
 
 /// Initialize an iterator based on the parameters passed in.
 /// \param iter A pointer to an iterator.
@@ -31,6 +68,7 @@ typedef struct SeedIter {
 int SeedIter_init(SeedIter* iter, const unsigned char* seed, size_t seed_size,
                   const mpz_t first_perm, const mpz_t last_perm);
 
+#ifdef ALWAYS_GMP_ITER
 /// Iterate forward to the next corrupted key.
 /// \param iter A pointer to an iterator. Its internal state will be changed.
 /// Passing in a NULL pointer is undefined behavior.
@@ -49,5 +87,120 @@ const unsigned char* SeedIter_get(const SeedIter* iter);
 static inline int SeedIter_end(const SeedIter* iter) {
     return iter->overflow || mpn_cmp(iter->curr_perm, iter->last_perm, ITER_LIMB_SIZE) > 0;
 }
+#else
+/// Count the trailing zeros of a 256-bit word array, least significant word first.
+/// \param words The words to scan.
+/// \return The index of the lowest set bit, or SEED_SIZE * 8 if every word is zero.
+static inline unsigned int SeedIter_ctz(const uint64_t* words) {
+    for (unsigned int i = 0; i < ITER_WORD_SIZE; ++i) {
+        if (words[i]) {
+            return i * ITER_WORD_BITS + (unsigned int)__builtin_ctzll(words[i]);
+        }
+    }
+
+    return SEED_SIZE * 8;
+}
+
+/// Iterate forward to the next corrupted key.
+/// \param iter A pointer to an iterator. Its internal state will be changed.
+/// Passing in a NULL pointer is undefined behavior.
+static inline void SeedIter_next(SeedIter* iter) {
+    uint64_t t[ITER_WORD_SIZE], not_t[ITER_WORD_SIZE], u[ITER_WORD_SIZE];
+    unsigned long long word;
+    unsigned char carry = 1;
+    int mask_bits;
+
+    // Equivalent to: t = perm | (perm - 1)
+    for (unsigned int i = 0; i < ITER_WORD_SIZE; ++i) {
+        carry = _subborrow_u64(carry, iter->curr_perm[i], 0, &word);
+        t[i] = word | iter->curr_perm[i];
+        not_t[i] = ~t[i];
+    }
+
+    // This is the only portion that can potentially overflow
+    carry = 1;
+    for (unsigned int i = 0; i < ITER_WORD_SIZE; ++i) {
+        carry = _addcarry_u64(carry, t[i], 0, &word);
+        u[i] = word;
+    }
+    iter->overflow = carry;
+
+    // Equivalent to: perm = (t + 1) | (((~t & -~t) - 1) >> (__builtin_ctz(perm) + 1))
+    // (~t & -~t) - 1 is a run of ones up to the lowest clear bit of t, so after the right shift it
+    // is a run of (ctz(~t) - ctz(perm) - 1) ones starting from bit 0. A zero perm shifts out
+    // everything, hence the clamp.
+    mask_bits = (int)SeedIter_ctz(not_t) - (int)SeedIter_ctz(iter->curr_perm) - 1;
+    for (unsigned int i = 0; i < ITER_WORD_SIZE; ++i) {
+        int word_bits = mask_bits - (int)(i * ITER_WORD_BITS);
+        uint64_t mask;
+
+        if (word_bits >= ITER_WORD_BITS) {
+            mask = UINT64_MAX;
+        } else if (word_bits <= 0) {
+            mask = 0;
+        } else {
+            mask = (UINT64_C(1) << word_bits) - 1;
+        }
+
+        iter->curr_perm[i] = u[i] | mask;
+    }
+
+    // Perform an XOR operation between the permutation and the key.
+    // If a bit is set in permutation, then flip the bit in the key.
+    // Otherwise, leave it as is.
+    for (unsigned int i = 0; i < ITER_WORD_SIZE; ++i) {
+        iter->corrupted_seed[i] = iter->seed[i] ^ iter->curr_perm[i];
+    }
+}
+
+/// Get the current corrupted key.
+/// \param iter A pointer to an iterator that won't be modified.
+/// Passing in a NULL pointer is undefined behavior.
+/// \return A pointer to the SEED_SIZE bytes of the current corrupted key, which stays valid until
+/// the next call to SeedIter_next.
+static inline const unsigned char* SeedIter_get(const SeedIter* iter) {
+    return (const unsigned char*)iter->corrupted_seed;
+}
+
+/// Return a boolean value of whether the iterator has reached the end or not.
+/// \param iter A pointer to an iterator that won't be modified.
+/// Passing in a NULL pointer is undefined behavior.
+/// \return Returns a 0 if the iterator hasn't reached the end, or a 1 if it has.
+static inline int SeedIter_end(const SeedIter* iter) {
+    if (iter->overflow) {
+        return 1;
+    }
+
+    for (int i = ITER_WORD_SIZE - 1; i >= 0; --i) {
+        if (iter->curr_perm[i] != iter->last_perm[i]) {
+            return iter->curr_perm[i] > iter->last_perm[i];
+        }
+    }
+
+    return 0;
+}
+#endif
+
+/// Write the next block of corrupted keys and advance the iterator past them. Words in the SoA
+/// layouts are copied from the key in native byte order.
+/// \param iter A pointer to an iterator. Its internal state will be changed.
+/// Passing in a NULL pointer is undefined behavior.
+/// \param seeds The output block, which must hold count * SEED_SIZE bytes. Aligning it to
+/// SEED_BATCH_ALIGN allows SIMD kernels to use aligned loads.
+/// \param count How many lanes the block has.
+/// \param layout How the keys are laid out within the block.
+/// \return How many keys were written before the iterator reached its end. If it is between 0 and
+/// count, the remaining lanes are filled with copies of the last key written so a fixed-width
+/// kernel can still run over the whole block.
+size_t SeedIter_nextN(SeedIter* iter, void* seeds, size_t count, SeedLayout layout);
+
+/// Copy a single key back out of a block filled by SeedIter_nextN.
+/// \param seed The buffer to fill the key with. Must have at least SEED_SIZE bytes allocated.
+/// \param seeds The block to read from.
+/// \param lane Which lane of the block to read, starting from 0.
+/// \param count How many lanes the block has.
+/// \param layout How the keys are laid out within the block.
+void SeedIter_loadLane(unsigned char* seed, const void* seeds, size_t lane, size_t count,
+                       SeedLayout layout);
 
 #endif  // RBC_VALIDATOR_SEED_ITER_H_
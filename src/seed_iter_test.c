@@ -0,0 +1,103 @@
+#include <stdalign.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "perm.h"
+#include "seed_iter.h"
+
+#define TEST_SIZE 3
+#define MISMATCHES 2
+#define SUBSEED_LENGTH 70
+
+/// Compare every block SeedIter_nextN produces against the keys the scalar iterator produces.
+/// \return Returns 0 if they all match, 1 if not, or -1 on error.
+int batchTest(const char* name, SeedLayout layout, const unsigned char* seed,
+              const mpz_t first_perm, const mpz_t last_perm) {
+    alignas(SEED_BATCH_ALIGN) unsigned char block[SEED_BATCH_MAX * SEED_SIZE];
+    unsigned char lane_seed[SEED_SIZE], last_seed[SEED_SIZE];
+    SeedIter iter, batch_iter;
+    size_t lane_counts[] = {4, 8, 16};
+    size_t word_size = SEED_SIZE;
+    int status = 0;
+
+    if (layout == SEED_LAYOUT_SOA32) {
+        word_size = sizeof(uint32_t);
+    } else if (layout == SEED_LAYOUT_SOA64) {
+        word_size = sizeof(uint64_t);
+    }
+
+    for (size_t c = 0; c < sizeof(lane_counts) / sizeof(*lane_counts); c++) {
+        size_t count = lane_counts[c], produced, total = 0;
+
+        if (SeedIter_init(&iter, seed, SEED_SIZE, first_perm, last_perm) ||
+            SeedIter_init(&batch_iter, seed, SEED_SIZE, first_perm, last_perm)) {
+            fprintf(stderr, "ERROR: SeedIter_init failed\n");
+            return -1;
+        }
+
+        while ((produced = SeedIter_nextN(&batch_iter, block, count, layout)) > 0) {
+            for (size_t lane = 0; lane < count; lane++) {
+                // Read the key back out in the same way a kernel would
+                for (size_t b = 0; b < SEED_SIZE; b++) {
+                    size_t word = b / word_size;
+
+                    lane_seed[b] = block[(word * count + lane) * word_size + b % word_size];
+                }
+
+                // Padded lanes repeat the last key, which the scalar iterator already passed
+                if (lane < produced) {
+                    if (SeedIter_end(&iter) || memcmp(lane_seed, SeedIter_get(&iter), SEED_SIZE)) {
+                        status = 1;
+                    }
+                    memcpy(last_seed, lane_seed, SEED_SIZE);
+                    SeedIter_next(&iter);
+                } else if (memcmp(lane_seed, last_seed, SEED_SIZE)) {
+                    status = 1;
+                }
+            }
+
+            total += produced;
+        }
+
+        if (!SeedIter_end(&iter)) {
+            status = 1;
+        }
+
+        printf("%s (%zu lanes, %zu keys): Test %s\n", name, count, total,
+               status ? "Failed" : "Passed");
+    }
+
+    return status;
+}
+
+int main() {
+    const unsigned char seed[] = {
+            0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a,
+            0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15,
+            0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f,
+    };
+
+    const SeedLayout layouts[TEST_SIZE] = {SEED_LAYOUT_AOS, SEED_LAYOUT_SOA32, SEED_LAYOUT_SOA64};
+    const char* names[TEST_SIZE] = {"AoS", "SoA 32-bit", "SoA 64-bit"};
+
+    mpz_t first_perm, last_perm;
+    int status = 0;
+
+    mpz_inits(first_perm, last_perm, NULL);
+    // An uneven split so the last block is only partially filled
+    getPermPair(first_perm, last_perm, 1, 3, MISMATCHES, SUBSEED_LENGTH);
+
+    for (size_t i = 0; i < TEST_SIZE; i++) {
+        int sub_status = batchTest(names[i], layouts[i], seed, first_perm, last_perm);
+        if (sub_status < 0) {
+            mpz_clears(first_perm, last_perm, NULL);
+            return EXIT_FAILURE;
+        }
+        status |= sub_status;
+    }
+
+    mpz_clears(first_perm, last_perm, NULL);
+
+    return status ? EXIT_FAILURE : EXIT_SUCCESS;
+}
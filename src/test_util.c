@@ -0,0 +1,36 @@
+#include "test_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void corruptKeys(unsigned char* keys, const unsigned char* key, size_t key_size, size_t key_count,
+                 size_t corrupt_size) {
+    for (size_t i = 0; i < key_count; i++) {
+        memcpy(keys + i * key_size, key, key_size);
+        keys[i * key_size + i % corrupt_size] ^= (unsigned char)i;
+    }
+}
+
+int checkKeys(const unsigned char* outputs, size_t output_size, const unsigned char* keys,
+              size_t key_size, size_t key_count, MultiKeyRefFunc ref_func, void* args) {
+    unsigned char* expected;
+    int status = 0;
+
+    if ((expected = malloc(output_size)) == NULL) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < key_count && !status; i++) {
+        if (ref_func(expected, keys + i * key_size, args)) {
+            fprintf(stderr, "ERROR: The reference failed on key %zu\n", i);
+            status = -1;
+        } else if (memcmp(outputs + i * output_size, expected, output_size) != 0) {
+            status = 1;
+        }
+    }
+
+    free(expected);
+
+    return status;
+}
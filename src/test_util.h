@@ -0,0 +1,32 @@
+#ifndef RBC_VALIDATOR_TEST_UTIL_H_
+#define RBC_VALIDATOR_TEST_UTIL_H_
+
+#include <stddef.h>
+
+// How many keys to give a multi-key kernel: enough for a full group of lanes for each of its two
+// widths plus a partial one
+#define MULTI_KEY_COUNT(wide_lanes, narrow_lanes) ((wide_lanes) + (narrow_lanes) + 3)
+
+/// The scalar path to check a multi-key kernel against.
+/// \param output Where to write the key's output.
+/// \param key The key to use.
+/// \param args Whatever else the reference needs, such as a message or an IV.
+/// \return Returns 0 on success or 1 on error.
+typedef int (*MultiKeyRefFunc)(unsigned char* output, const unsigned char* key, void* args);
+
+/// Make a set of keys that are each a different corruption of the original, starting with the
+/// original itself.
+/// \param keys Where to write key_count keys of key_size bytes each.
+/// \param corrupt_size How many of the first bytes of the key to corrupt, which leaves the rest the
+/// same across every key.
+void corruptKeys(unsigned char* keys, const unsigned char* key, size_t key_size, size_t key_count,
+                 size_t corrupt_size);
+
+/// Compare every output of a multi-key kernel against the scalar path's output for the same key.
+/// \param outputs The kernel's key_count outputs of output_size bytes each.
+/// \param keys The key_count keys of key_size bytes each that the kernel was given.
+/// \return Returns 0 if they all match, 1 if not, or -1 if ref_func failed.
+int checkKeys(const unsigned char* outputs, size_t output_size, const unsigned char* keys,
+              size_t key_size, size_t key_count, MultiKeyRefFunc ref_func, void* args);
+
+#endif  // RBC_VALIDATOR_TEST_UTIL_H_
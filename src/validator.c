@@ -8,13 +8,45 @@
 #include <mpi.h>
 #endif
 
+#include <stdalign.h>
 #include <string.h>
 
+#include <openssl/md5.h>
+#include <openssl/sha.h>
+
 #include "crypto/cipher.h"
 #include "crypto/ec.h"
 #include "crypto/hash.h"
+#include "crypto/hash_mb.h"
+#include "crypto/keccak_mb.h"
 #include "seed_iter.h"
 
+// Fall back to the scalar validator for every lane of an array-of-structures block. A match is
+// when the comparison reports equal (0).
+#define CRYPTO_BATCH_SCALAR(name)                                                       \
+    int CryptoBatch_##name(uint32_t* matches, const unsigned char* seeds, size_t count, \
+                           void* args) {                                                \
+        int cmp_status;                                                                 \
+                                                                                        \
+        *matches = 0;                                                                   \
+                                                                                        \
+        for (size_t lane = 0; lane < count; ++lane) {                                   \
+            if (CryptoFunc_##name(seeds + lane * SEED_SIZE, args)) {                    \
+                return 1;                                                               \
+            }                                                                           \
+                                                                                        \
+            if ((cmp_status = CryptoCmp_##name(args)) < 0) {                            \
+                return 1;                                                               \
+            }                                                                           \
+                                                                                        \
+            if (cmp_status == 0) {                                                      \
+                *matches |= UINT32_C(1) << lane;                                        \
+            }                                                                           \
+        }                                                                               \
+                                                                                        \
+        return 0;                                                                       \
+    }
+
 int CryptoFunc_aes256(const unsigned char* curr_seed, void* args) {
     CipherValidator* v = (CipherValidator*)args;
 
@@ -35,6 +67,42 @@ int CryptoCmp_aes256(void* args) {
     return memcmp(v->curr_cipher, v->client_cipher, v->msg_size) != 0;
 }
 
+int CryptoBatch_aes256(uint32_t* matches, const unsigned char* seeds, size_t count, void* args) {
+    CipherValidator* v = (CipherValidator*)args;
+    unsigned char first_blocks[SEED_BATCH_MAX * AES_BLOCK_SIZE];
+
+    *matches = 0;
+
+    if (v == NULL || v->client_cipher == NULL || count > SEED_BATCH_MAX ||
+        v->msg_size < AES_BLOCK_SIZE || v->msg_size % AES_BLOCK_SIZE) {
+        return 1;
+    }
+
+    // Only encrypt the first block of every lane, which rules out nearly all of them
+    aes256EcbEncryptKeys(first_blocks, seeds, count, v->msg);
+
+    for (size_t lane = 0; lane < count; ++lane) {
+        if (memcmp(first_blocks + lane * AES_BLOCK_SIZE, v->client_cipher, AES_BLOCK_SIZE)) {
+            continue;
+        }
+
+        // Then confirm the rest of the message for the lanes that are left
+        if (v->msg_size > AES_BLOCK_SIZE) {
+            if (CryptoFunc_aes256(seeds + lane * SEED_SIZE, v)) {
+                return 1;
+            }
+
+            if (CryptoCmp_aes256(v)) {
+                continue;
+            }
+        }
+
+        *matches |= UINT32_C(1) << lane;
+    }
+
+    return 0;
+}
+
 int CryptoFunc_cipher(const unsigned char* curr_seed, void* args) {
     CipherValidator* v = (CipherValidator*)args;
 
@@ -65,6 +133,68 @@ int CryptoCmp_cipher(void* args) {
     return memcmp(v->curr_cipher, v->client_cipher, v->msg_size) != 0;
 }
 
+CRYPTO_BATCH_SCALAR(cipher)
+
+// How many words at the start of the ChaCha20 keystream to check before confirming a key through
+// EVP, which is enough to rule out every wrong key in practice
+#define CHACHA20_PREFIX_WORDS 4
+
+int CryptoBatch_chacha20(uint32_t* matches, const unsigned char* seeds, size_t count, void* args) {
+    CipherValidator* v = (CipherValidator*)args;
+    uint32_t keystreams[CHACHA20_PREFIX_WORDS * SEED_BATCH_MAX];
+    // The keystream a matching key produces (the message XOR the cipher), and which of its bytes
+    // to check if the message is shorter than the prefix
+    uint32_t expected[CHACHA20_PREFIX_WORDS] = {0}, mask[CHACHA20_PREFIX_WORDS] = {0};
+    unsigned char seed[SEED_SIZE];
+    size_t prefix_size, word_count;
+
+    *matches = 0;
+
+    if (v == NULL || v->msg == NULL || v->client_cipher == NULL || v->iv == NULL ||
+        count > SEED_BATCH_MAX) {
+        return 1;
+    }
+
+    prefix_size = v->msg_size < sizeof(expected) ? v->msg_size : sizeof(expected);
+    word_count = (prefix_size + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    for (size_t i = 0; i < prefix_size; ++i) {
+        ((unsigned char*)expected)[i] = v->msg[i] ^ v->client_cipher[i];
+        ((unsigned char*)mask)[i] = 0xff;
+    }
+
+    chacha20KeystreamKeys(keystreams, word_count, (const uint32_t*)seeds, count, v->iv);
+
+    for (size_t lane = 0; lane < count; ++lane) {
+        uint32_t diff = 0;
+
+        for (size_t i = 0; i < word_count; ++i) {
+            diff |= (keystreams[i * count + lane] ^ expected[i]) & mask[i];
+        }
+
+        if (diff) {
+            continue;
+        }
+
+        // Then confirm the rest of the message for the lanes that are left
+        if (v->msg_size > prefix_size) {
+            SeedIter_loadLane(seed, seeds, lane, count, SEED_LAYOUT_SOA32);
+
+            if (CryptoFunc_cipher(seed, v)) {
+                return 1;
+            }
+
+            if (CryptoCmp_cipher(v)) {
+                continue;
+            }
+        }
+
+        *matches |= UINT32_C(1) << lane;
+    }
+
+    return 0;
+}
+
 int CryptoFunc_ec(const unsigned char* curr_seed, void* args) {
     EcValidator* v = (EcValidator*)args;
 
@@ -72,7 +202,12 @@ int CryptoFunc_ec(const unsigned char* curr_seed, void* args) {
         return -1;
     }
 
+#ifdef ALWAYS_EC_MUL
     return getEcPublicKey(v->curr_point, v->ctx, v->group, curr_seed, SEED_SIZE);
+#else
+    // Consecutive seeds only differ in a few bits, so step from the last public key instead
+    return EcStep_get(v->step, v->curr_point, v->ctx, curr_seed);
+#endif
 }
 
 int CryptoCmp_ec(void* args) {
@@ -82,9 +217,291 @@ int CryptoCmp_ec(void* args) {
         return -1;
     }
 
+    // curr_point is left in Jacobian coordinates, which EC_POINT_cmp compares against the affine
+    // client point by cross-multiplying (X·Z² and Y·Z³) without ever inverting Z
     return EC_POINT_cmp(v->group, v->curr_point, v->client_point, v->ctx);
 }
 
+CRYPTO_BATCH_SCALAR(ec)
+
+#if !defined(ALWAYS_EC_MUL) && !defined(ALWAYS_OPENSSL_EC)
+/// A P-256-only batch function, which steps P256_STEP_LANES lanes at a time with the custom
+/// implementation and compares them in Jacobian coordinates.
+static int CryptoBatch_p256(uint32_t* matches, const unsigned char* seeds, size_t count,
+                            void* args) {
+    EcValidator* v = (EcValidator*)args;
+
+    *matches = 0;
+
+    if (v == NULL) {
+        return 1;
+    }
+
+    for (size_t lane = 0; lane < count; lane += P256_STEP_LANES) {
+        size_t lanes = count - lane < P256_STEP_LANES ? count - lane : P256_STEP_LANES;
+
+        P256Step_getLanes(v->p256_step, v->p256_lanes, seeds + lane * SEED_SIZE, lanes);
+        *matches |= p256PointsEqualAffine(v->p256_lanes, lanes, &(v->p256_client)) << lane;
+    }
+
+    return 0;
+}
+
+/// The same as CryptoBatch_p256, but for secp256k1, one seed at a time.
+static int CryptoBatch_secp256k1(uint32_t* matches, const unsigned char* seeds, size_t count,
+                                 void* args) {
+    EcValidator* v = (EcValidator*)args;
+
+    *matches = 0;
+
+    if (v == NULL) {
+        return 1;
+    }
+
+    for (size_t lane = 0; lane < count; lane++) {
+        Secp256k1Step_get(v->k1_step, &(v->k1_point), seeds + lane * SEED_SIZE);
+
+        if (secp256k1PointEqualsAffine(&(v->k1_point), &(v->k1_client))) {
+            *matches |= UINT32_C(1) << lane;
+        }
+    }
+
+    return 0;
+}
+#endif
+
+void EcValidator_getBatch(CryptoBatch* crypto_batch, const EcValidator* v) {
+    crypto_batch->func = CryptoBatch_ec;
+    crypto_batch->lanes = CRYPTO_BATCH_SCALAR_LANES;
+    crypto_batch->layout = SEED_LAYOUT_AOS;
+
+#if !defined(ALWAYS_EC_MUL) && !defined(ALWAYS_OPENSSL_EC)
+    if (v != NULL && v->p256_step != NULL) {
+        crypto_batch->func = CryptoBatch_p256;
+        crypto_batch->lanes = SEED_BATCH_MAX;
+    } else if (v != NULL && v->k1_step != NULL) {
+        crypto_batch->func = CryptoBatch_secp256k1;
+        crypto_batch->lanes = SEED_BATCH_MAX;
+    }
+#endif
+}
+
+/// Check every way to corrupt the table's positions below a lane's lowest that has the fingerprint
+/// the lane's point is left with.
+/// \param v The validator, whose client_seed is set on a match.
+/// \param seed The lane's seed.
+/// \param lowest The lowest position the lane corrupts.
+/// \param key The fingerprint of the lane's point.
+/// \return Returns 1 on a match, 0 if there is none, or -1 on error.
+static int EcMitmValidator_lookup(EcMitmValidator* v, const unsigned char* seed,
+                                  unsigned int lowest, uint64_t key) {
+    const EcMitmEntry* entry;
+    unsigned char candidate[SEED_SIZE];
+    size_t probes = 0;
+    int cmp_status;
+
+    while ((entry = EcMitmTable_next(v->table, key, &probes)) != NULL) {
+        // Only the split with the table's positions below the lane's is part of this search
+        if (EcMitmTable_top(v->table, entry) >= lowest) {
+            continue;
+        }
+
+        // Fingerprints can collide, so confirm the whole seed
+        memcpy(candidate, seed, SEED_SIZE);
+        EcMitmTable_apply(candidate, v->table, entry);
+
+        if (getEcPublicKey(v->check_point, v->ctx, v->group, candidate, SEED_SIZE) ||
+            (cmp_status = EC_POINT_cmp(v->group, v->check_point, v->client_point, v->ctx)) < 0) {
+            return -1;
+        }
+
+        if (cmp_status == 0) {
+            memcpy(v->client_seed, candidate, SEED_SIZE);
+
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/// Work out what the point of every lane held back is left with using the custom P-256
+/// implementation, P256_STEP_LANES lanes at a time.
+static void EcMitmValidator_stepP256(EcMitmValidator* v) {
+    for (size_t lane = 0; lane < v->pending; lane += P256_STEP_LANES) {
+        size_t lanes = v->pending - lane < P256_STEP_LANES ? v->pending - lane : P256_STEP_LANES;
+
+        P256Step_getLanes(v->p256_step, v->p256_lanes, v->seeds + lane * SEED_SIZE, lanes);
+
+        for (size_t i = 0; i < lanes; i++) {
+            p256PointNegate(&(v->p256_points[lane + i]), &(v->p256_lanes[i]));
+        }
+    }
+
+    p256PointsAddAffine(v->p256_points, v->p256_points, &(v->p256_target), v->pending);
+}
+
+/// Make a lane's point affine, or rather every lane held back at once, and work out its
+/// fingerprint.
+/// \param key The output fingerprint of the lane's point.
+/// \param v The validator.
+/// \param lane Which of the lanes held back to fingerprint, starting from 0.
+/// \return Returns 1 if the lane's point is at infinity, which the table has no seeds for, 0 if it
+/// isn't, or -1 on error.
+static int EcMitmValidator_key(uint64_t* key, EcMitmValidator* v, size_t lane) {
+    if (v->p256_step != NULL) {
+        // One inversion for every lane held back rather than one per lane
+        if (lane == 0) {
+            EcMitmValidator_stepP256(v);
+            p256BatchToAffine(v->p256_affine, v->p256_points, v->pending);
+        }
+
+        if (p256AffineIsInfinity(&(v->p256_affine[lane]))) {
+            return 1;
+        }
+
+        *key = EcMitmTable_keyP256(&(v->p256_affine[lane]));
+
+        return 0;
+    }
+
+    if (lane == 0 && !EC_POINTs_make_affine(v->group, v->pending, v->points, v->ctx)) {
+        return -1;
+    }
+
+    if (EC_POINT_is_at_infinity(v->group, v->points[lane])) {
+        return 1;
+    }
+
+    return EcMitmTable_key(key, v->group, v->points[lane], v->x, v->ctx) ? -1 : 0;
+}
+
+/// Make every lane held back affine and look each of them up.
+/// \return Returns 1 if a lane matched, 0 if none did, or -1 on error.
+static int EcMitmValidator_resolve(EcMitmValidator* v) {
+    int found = 0;
+
+    for (size_t lane = 0; lane < v->pending; lane++) {
+        const unsigned char* seed = v->seeds + lane * SEED_SIZE;
+        unsigned int lowest = v->table->subseed_length;
+        uint64_t key;
+        int status;
+
+        for (unsigned int i = 0; i < SEED_SIZE; i++) {
+            if (seed[i] != v->host_seed[i]) {
+                lowest = i * 8 + (unsigned int)__builtin_ctz(seed[i] ^ v->host_seed[i]);
+                break;
+            }
+        }
+
+        v->covered += v->covers[lowest];
+
+        if ((status = EcMitmValidator_key(&key, v, lane)) < 0) {
+            return -1;
+        } else if (status > 0) {
+            continue;
+        }
+
+        if ((status = EcMitmValidator_lookup(v, seed, lowest, key)) < 0) {
+            return -1;
+        }
+
+        found |= status;
+    }
+
+    v->pending = 0;
+
+    return found;
+}
+
+/// Work out what the next lane's point is left with and hold it back.
+/// \return Returns 0 on success, or 1 on error.
+static int EcMitmValidator_push(EcMitmValidator* v, const unsigned char* seed) {
+    // The custom P-256 implementation steps every lane held back at once when they are looked up
+    if (v->p256_step == NULL) {
+        EC_POINT* point = v->points[v->pending];
+
+        if (EcStep_get(v->step, v->curr_point, v->ctx, seed) ||
+            !EC_POINT_copy(point, v->curr_point) || !EC_POINT_invert(v->group, point, v->ctx) ||
+            !EC_POINT_add(v->group, point, point, v->target, v->ctx)) {
+            return 1;
+        }
+    }
+
+    memcpy(v->seeds + v->pending * SEED_SIZE, seed, SEED_SIZE);
+    v->pending++;
+
+    return 0;
+}
+
+int CryptoBatch_ecMitm(uint32_t* matches, const unsigned char* seeds, size_t count, void* args) {
+    EcMitmValidator* v = (EcMitmValidator*)args;
+    int status;
+
+    *matches = 0;
+
+    if (v == NULL || !v->has_last_seed) {
+        return 1;
+    }
+
+    // The lanes past the end of the walk repeat the last seed and are left out
+    for (size_t lane = 0; lane < count && !v->done; lane++) {
+        const unsigned char* seed = seeds + lane * SEED_SIZE;
+
+        if (EcMitmValidator_push(v, seed)) {
+            return 1;
+        }
+
+        v->done = !memcmp(seed, v->last_seed, SEED_SIZE);
+
+        if (v->pending < EC_MITM_QUERY_BATCH && !v->done) {
+            continue;
+        }
+
+        if ((status = EcMitmValidator_resolve(v)) < 0) {
+            return 1;
+        }
+
+        // The lane that completed the batch isn't the one that matched
+        if (status) {
+            *matches = 1;
+        }
+    }
+
+    return 0;
+}
+
+void EcMitmValidator_getBatch(CryptoBatch* crypto_batch, const EcMitmValidator* v) {
+    crypto_batch->func = CryptoBatch_ecMitm;
+    crypto_batch->lanes = SEED_BATCH_MAX;
+    crypto_batch->layout = SEED_LAYOUT_AOS;
+    crypto_batch->match_seed = v != NULL ? v->client_seed : NULL;
+}
+
+int CryptoBatch_x25519(uint32_t* matches, const unsigned char* seeds, size_t count, void* args) {
+    X25519Validator* v = (X25519Validator*)args;
+
+    *matches = 0;
+
+    if (v == NULL) {
+        return 1;
+    }
+
+    for (size_t lane = 0; lane < count; lane++) {
+#ifdef ALWAYS_EC_MUL
+        x25519ScalarMulBase(&(v->point), seeds + lane * SEED_SIZE);
+#else
+        X25519Step_get(v->step, &(v->point), seeds + lane * SEED_SIZE);
+#endif
+
+        if (x25519PointEqualsY(&(v->point), &(v->client_y))) {
+            *matches |= UINT32_C(1) << lane;
+        }
+    }
+
+    return 0;
+}
+
 int CryptoFunc_hash(const unsigned char* curr_seed, void* args) {
     HashValidator* v = (HashValidator*)args;
 
@@ -109,19 +526,19 @@ int CryptoFunc_hash(const unsigned char* curr_seed, void* args) {
 #endif
 #ifndef ALWAYS_EVP_SHA3
         case NID_sha3_224:
-            return sha3_224_hash(v->curr_digest, curr_seed, SEED_SIZE, v->salt, v->salt_size);
+            return sha3_224Hash(v->curr_digest, curr_seed, SEED_SIZE, v->salt, v->salt_size);
         case NID_sha3_256:
-            return sha3_256_hash(v->curr_digest, curr_seed, SEED_SIZE, v->salt, v->salt_size);
+            return sha3_256Hash(v->curr_digest, curr_seed, SEED_SIZE, v->salt, v->salt_size);
         case NID_sha3_384:
-            return sha3_384_hash(v->curr_digest, curr_seed, SEED_SIZE, v->salt, v->salt_size);
+            return sha3_384Hash(v->curr_digest, curr_seed, SEED_SIZE, v->salt, v->salt_size);
         case NID_sha3_512:
-            return sha3_512_hash(v->curr_digest, curr_seed, SEED_SIZE, v->salt, v->salt_size);
+            return sha3_512Hash(v->curr_digest, curr_seed, SEED_SIZE, v->salt, v->salt_size);
         case NID_shake128:
-            return shake128_hash(v->curr_digest, v->digest_size, curr_seed, SEED_SIZE, v->salt,
-                                 v->salt_size);
+            return shake128Hash(v->curr_digest, v->digest_size, curr_seed, SEED_SIZE, v->salt,
+                                v->salt_size);
         case NID_shake256:
-            return shake256_hash(v->curr_digest, v->digest_size, curr_seed, SEED_SIZE, v->salt,
-                                 v->salt_size);
+            return shake256Hash(v->curr_digest, v->digest_size, curr_seed, SEED_SIZE, v->salt,
+                                v->salt_size);
 #endif
         case NID_kang12:
             return kang12Hash(v->curr_digest, v->digest_size, curr_seed, SEED_SIZE, v->salt,
@@ -142,6 +559,229 @@ int CryptoCmp_hash(void* args) {
     return memcmp(v->curr_digest, v->client_digest, v->digest_size) != 0;
 }
 
+CRYPTO_BATCH_SCALAR(hash)
+
+typedef int (*HashFunc)(unsigned char*, const unsigned char*, size_t, const unsigned char*, size_t);
+typedef int (*XofFunc)(unsigned char*, size_t, const unsigned char*, size_t, const unsigned char*,
+                       size_t);
+
+/// The lane loop shared by every specialized hash validator. Always inlined, so that hash_func,
+/// digest_size, and salted become compile-time constants in each instantiation and neither the nid
+/// nor the digest size are looked at per seed.
+/// \param hash_func A fixed-size hash function, or NULL if xof_func is used instead.
+/// \param xof_func An XOF, or NULL if hash_func is used instead.
+/// \param digest_size The fixed digest size, or 0 to use the validator's XOF digest size.
+/// \param salted If zero, then the salt is left out at compile time.
+static inline __attribute__((always_inline)) int hashBatch(
+        uint32_t* matches, const unsigned char* seeds, size_t count, const HashValidator* v,
+        HashFunc hash_func, XofFunc xof_func, size_t digest_size, int salted) {
+    // XOF digests can be any size, so they go into the validator's own buffer instead
+    unsigned char fixed_digest[EVP_MAX_MD_SIZE];
+    unsigned char* digest = digest_size ? fixed_digest : v->curr_digest;
+    const unsigned char* salt = salted ? v->salt : NULL;
+    size_t salt_size = salted ? v->salt_size : 0;
+
+    *matches = 0;
+
+    for (size_t lane = 0; lane < count; ++lane) {
+        const unsigned char* seed = seeds + lane * SEED_SIZE;
+
+        if (hash_func != NULL) {
+            if (hash_func(digest, seed, SEED_SIZE, salt, salt_size)) {
+                return 1;
+            }
+        } else if (xof_func(digest, v->digest_size, seed, SEED_SIZE, salt, salt_size)) {
+            return 1;
+        }
+
+        if (!memcmp(digest, v->client_digest, digest_size ? digest_size : v->digest_size)) {
+            *matches |= UINT32_C(1) << lane;
+        }
+    }
+
+    return 0;
+}
+
+// Instantiate an unsalted and a salted validator for one hash function
+#define CRYPTO_BATCH_HASH(name, hash_func, xof_func, digest_size)                              \
+    static int CryptoBatch_##name(uint32_t* matches, const unsigned char* seeds, size_t count, \
+                                  void* args) {                                                \
+        return hashBatch(matches, seeds, count, args, hash_func, xof_func, digest_size, 0);    \
+    }                                                                                          \
+                                                                                               \
+    static int CryptoBatch_##name##_salted(uint32_t* matches, const unsigned char* seeds,      \
+                                           size_t count, void* args) {                         \
+        return hashBatch(matches, seeds, count, args, hash_func, xof_func, digest_size, 1);    \
+    }
+
+#ifndef ALWAYS_EVP_HASH
+CRYPTO_BATCH_HASH(md5, md5Hash, NULL, MD5_DIGEST_LENGTH)
+CRYPTO_BATCH_HASH(sha1, sha1Hash, NULL, SHA_DIGEST_LENGTH)
+CRYPTO_BATCH_HASH(sha224, sha224Hash, NULL, SHA224_DIGEST_LENGTH)
+CRYPTO_BATCH_HASH(sha256, sha256Hash, NULL, SHA256_DIGEST_LENGTH)
+CRYPTO_BATCH_HASH(sha384, sha384Hash, NULL, SHA384_DIGEST_LENGTH)
+CRYPTO_BATCH_HASH(sha512, sha512Hash, NULL, SHA512_DIGEST_LENGTH)
+#endif
+#ifndef ALWAYS_EVP_SHA3
+CRYPTO_BATCH_HASH(sha3_224, sha3_224Hash, NULL, SHA224_DIGEST_LENGTH)
+CRYPTO_BATCH_HASH(sha3_256, sha3_256Hash, NULL, SHA256_DIGEST_LENGTH)
+CRYPTO_BATCH_HASH(sha3_384, sha3_384Hash, NULL, SHA384_DIGEST_LENGTH)
+CRYPTO_BATCH_HASH(sha3_512, sha3_512Hash, NULL, SHA512_DIGEST_LENGTH)
+CRYPTO_BATCH_HASH(shake128, NULL, shake128Hash, 0)
+CRYPTO_BATCH_HASH(shake256, NULL, shake256Hash, 0)
+
+// Instantiate a validator for the parallel Keccak kernel, which takes SEED_LAYOUT_AOS blocks
+#define CRYPTO_BATCH_KECCAK_MB(name)                                                  \
+    static int CryptoBatch_##name##_mb(uint32_t* matches, const unsigned char* seeds, \
+                                       size_t count, void* args) {                    \
+        HashValidator* v = (HashValidator*)args;                                      \
+                                                                                      \
+        if (v == NULL) {                                                              \
+            *matches = 0;                                                             \
+            return 1;                                                                 \
+        }                                                                             \
+                                                                                      \
+        *matches = keccakMbMatch(seeds, count, &v->keccak_target);                    \
+                                                                                      \
+        return 0;                                                                     \
+    }
+
+CRYPTO_BATCH_KECCAK_MB(sha3_224)
+CRYPTO_BATCH_KECCAK_MB(sha3_256)
+CRYPTO_BATCH_KECCAK_MB(sha3_384)
+CRYPTO_BATCH_KECCAK_MB(sha3_512)
+CRYPTO_BATCH_KECCAK_MB(shake128)
+CRYPTO_BATCH_KECCAK_MB(shake256)
+#endif
+
+#ifndef ALWAYS_EVP_HASH
+// Instantiate a validator for one of the single-block kernels, which take their keys as key_type
+// blocks in whichever layout the kernel expects and the tail hashMbPrepare built in the validator
+#define CRYPTO_BATCH_HASH_KERNEL(name, key_type, tail, match_func)                             \
+    static int CryptoBatch_##name(uint32_t* matches, const unsigned char* seeds, size_t count, \
+                                  void* args) {                                                \
+        HashValidator* v = (HashValidator*)args;                                               \
+                                                                                               \
+        if (v == NULL) {                                                                       \
+            *matches = 0;                                                                      \
+            return 1;                                                                          \
+        }                                                                                      \
+                                                                                               \
+        *matches = match_func((const key_type*)seeds, count, v->tail, v->client_digest);       \
+                                                                                               \
+        return 0;                                                                              \
+    }
+
+// The same, but for the 32-bit multi-buffer kernels, which take SEED_LAYOUT_SOA32 blocks and keep
+// their tail and target in the validator
+#define CRYPTO_BATCH_HASH_TARGET_KERNEL(name, match_func)                                         \
+    static int CryptoBatch_##name(uint32_t* matches, const unsigned char* seeds, size_t count,    \
+                                  void* args) {                                                   \
+        HashValidator* v = (HashValidator*)args;                                                  \
+                                                                                                  \
+        if (v == NULL) {                                                                          \
+            *matches = 0;                                                                         \
+            return 1;                                                                             \
+        }                                                                                         \
+                                                                                                  \
+        *matches = match_func((const uint32_t*)seeds, count, v->mb_tail, &v->mb_target);         \
+                                                                                                  \
+        return 0;                                                                                 \
+    }
+
+CRYPTO_BATCH_HASH_TARGET_KERNEL(md5_mb, md5MbMatch)
+CRYPTO_BATCH_HASH_TARGET_KERNEL(sha1_mb, sha1MbMatch)
+CRYPTO_BATCH_HASH_TARGET_KERNEL(sha224_mb, sha224MbMatch)
+CRYPTO_BATCH_HASH_TARGET_KERNEL(sha256_mb, sha256MbMatch)
+// The 64-bit ones take SEED_LAYOUT_SOA64 blocks
+CRYPTO_BATCH_HASH_KERNEL(sha384_mb, uint64_t, mb_tail64, sha384MbMatch)
+CRYPTO_BATCH_HASH_KERNEL(sha512_mb, uint64_t, mb_tail64, sha512MbMatch)
+// While the SHA-NI kernels take SEED_LAYOUT_AOS blocks
+CRYPTO_BATCH_HASH_KERNEL(sha1_ni, unsigned char, mb_tail, sha1NiMatch)
+CRYPTO_BATCH_HASH_KERNEL(sha224_ni, unsigned char, mb_tail, sha224NiMatch)
+CRYPTO_BATCH_HASH_KERNEL(sha256_ni, unsigned char, mb_tail, sha256NiMatch)
+#endif
+
+// Pick a validator's specialized instantiations based on whether it has a salt
+#define HASH_BATCH_SALTED(name) \
+    crypto_batch->func = v->salt_size > 0 ? CryptoBatch_##name##_salted : CryptoBatch_##name
+
+// Prefer a multi-buffer kernel if the salt fits in its block
+#define HASH_BATCH_MB(name, batch_lanes, batch_layout) \
+    crypto_batch->func = CryptoBatch_##name##_mb;      \
+    crypto_batch->lanes = (batch_lanes);               \
+    crypto_batch->layout = (batch_layout)
+
+#define HASH_BATCH_MB_CASE(nid, name, max_salt_size, batch_lanes, batch_layout) \
+    case nid:                                                                   \
+        HASH_BATCH_SALTED(name);                                                \
+        if (v->salt_size <= (max_salt_size)) {                                  \
+            HASH_BATCH_MB(name, batch_lanes, batch_layout);                     \
+        }                                                                       \
+        break;
+
+// Prefer a kernel if the salt fits in its block, picking AVX-512 multi-buffer first since it
+// outpaces SHA-NI, then SHA-NI, then whatever multi-buffer kernel the CPU can run
+#define HASH_BATCH_MB_NI_CASE(nid, name, max_salt_size)                   \
+    case nid:                                                             \
+        HASH_BATCH_SALTED(name);                                          \
+        if (v->salt_size > (max_salt_size)) {                             \
+            break;                                                        \
+        }                                                                 \
+        if (hashMbHasAvx512() || !hashMbHasShaNi()) {                     \
+            HASH_BATCH_MB(name, HASH_MB_AVX512_LANES, SEED_LAYOUT_SOA32); \
+        } else {                                                          \
+            crypto_batch->func = CryptoBatch_##name##_ni;                 \
+            crypto_batch->lanes = SEED_BATCH_MAX;                         \
+        }                                                                 \
+        break;
+
+// Prefer the parallel Keccak kernel if the salt fits in a single block and the digest can be
+// squeezed out of it
+#define HASH_BATCH_KECCAK_CASE(nid, name, rate)                                          \
+    case nid:                                                                            \
+        HASH_BATCH_SALTED(name);                                                         \
+        if (v->salt_size <= KECCAK_MB_MAX_SALT_SIZE(rate) && v->digest_size <= (rate)) { \
+            crypto_batch->func = CryptoBatch_##name##_mb;                                \
+            crypto_batch->lanes = SEED_BATCH_MAX;                                        \
+        }                                                                                \
+        break;
+
+void HashValidator_getBatch(CryptoBatch* crypto_batch, const HashValidator* v) {
+    crypto_batch->func = CryptoBatch_hash;
+    crypto_batch->lanes = CRYPTO_BATCH_SCALAR_LANES;
+    crypto_batch->layout = SEED_LAYOUT_AOS;
+
+    // Let the generic batch function report the missing validator
+    if (v == NULL) {
+        return;
+    }
+
+    switch (v->nid) {
+#ifndef ALWAYS_EVP_HASH
+        HASH_BATCH_MB_CASE(NID_md5, md5, MD5_MB_MAX_SALT_SIZE, HASH_MB_AVX512_LANES,
+                           SEED_LAYOUT_SOA32)
+        HASH_BATCH_MB_NI_CASE(NID_sha1, sha1, SHA256_MB_MAX_SALT_SIZE)
+        HASH_BATCH_MB_NI_CASE(NID_sha224, sha224, SHA256_MB_MAX_SALT_SIZE)
+        HASH_BATCH_MB_NI_CASE(NID_sha256, sha256, SHA256_MB_MAX_SALT_SIZE)
+        HASH_BATCH_MB_CASE(NID_sha384, sha384, SHA512_MB_MAX_SALT_SIZE, SEED_BATCH_MAX,
+                           SEED_LAYOUT_SOA64)
+        HASH_BATCH_MB_CASE(NID_sha512, sha512, SHA512_MB_MAX_SALT_SIZE, SEED_BATCH_MAX,
+                           SEED_LAYOUT_SOA64)
+#endif
+#ifndef ALWAYS_EVP_SHA3
+        HASH_BATCH_KECCAK_CASE(NID_sha3_224, sha3_224, SHA3_224_RATE)
+        HASH_BATCH_KECCAK_CASE(NID_sha3_256, sha3_256, SHA3_256_RATE)
+        HASH_BATCH_KECCAK_CASE(NID_sha3_384, sha3_384, SHA3_384_RATE)
+        HASH_BATCH_KECCAK_CASE(NID_sha3_512, sha3_512, SHA3_512_RATE)
+        HASH_BATCH_KECCAK_CASE(NID_shake128, shake128, SHAKE128_RATE)
+        HASH_BATCH_KECCAK_CASE(NID_shake256, shake256, SHAKE256_RATE)
+#endif
+        default:
+            break;
+    }
+}
+
 int CryptoFunc_kang12(const unsigned char* curr_seed, void* args) {
     Kang12Validator* v = (Kang12Validator*)args;
 
@@ -162,6 +802,37 @@ int CryptoCmp_kang12(void* args) {
     return memcmp(v->curr_digest, v->client_digest, v->digest_size) != 0;
 }
 
+CRYPTO_BATCH_SCALAR(kang12)
+
+/// A KangarooTwelve-only batch function, which takes its seeds in SEED_LAYOUT_AOS and runs the
+/// parallel Keccak kernel on them.
+static int CryptoBatch_kang12_mb(uint32_t* matches, const unsigned char* seeds, size_t count,
+                                 void* args) {
+    Kang12Validator* v = (Kang12Validator*)args;
+
+    if (v == NULL) {
+        *matches = 0;
+        return 1;
+    }
+
+    *matches = kang12MbMatch(seeds, count, &v->keccak_target);
+
+    return 0;
+}
+
+void Kang12Validator_getBatch(CryptoBatch* crypto_batch, const Kang12Validator* v) {
+    crypto_batch->func = CryptoBatch_kang12;
+    crypto_batch->lanes = CRYPTO_BATCH_SCALAR_LANES;
+    crypto_batch->layout = SEED_LAYOUT_AOS;
+
+    // Use the parallel kernel only if the salt fits in a single block and the digest can be
+    // squeezed out of it
+    if (v != NULL && v->salt_size <= KANG12_MB_MAX_SALT_SIZE && v->digest_size <= KANG12_RATE) {
+        crypto_batch->func = CryptoBatch_kang12_mb;
+        crypto_batch->lanes = SEED_BATCH_MAX;
+    }
+}
+
 CipherValidator* CipherValidator_create(const EVP_CIPHER* evp_cipher,
                                         const unsigned char* client_cipher,
                                         const unsigned char* msg, size_t msg_size,
@@ -221,10 +892,12 @@ void CipherValidator_destroy(CipherValidator* v) {
     free(v);
 }
 
-EcValidator* EcValidator_create(const EC_GROUP* group, const EC_POINT* client_point) {
-    EcValidator* v = malloc(sizeof(*v));
+EcValidator* EcValidator_create(const EC_GROUP* group, const EC_POINT* client_point,
+                                const unsigned char* host_seed, size_t subseed_length) {
+    EcValidator* v = calloc(1, sizeof(*v));
 
-    if (v == NULL || group == NULL || client_point == NULL) {
+    if (v == NULL || group == NULL || client_point == NULL || host_seed == NULL ||
+        subseed_length == 0 || subseed_length > SEED_SIZE * 8) {
         EcValidator_destroy(v);
 
         return NULL;
@@ -242,6 +915,44 @@ EcValidator* EcValidator_create(const EC_GROUP* group, const EC_POINT* client_po
         return NULL;
     }
 
+    // Only the bytes holding the subseed are ever corrupted, and every seed is near the host seed
+#if !defined(ALWAYS_EC_MUL) && !defined(ALWAYS_OPENSSL_EC)
+    if (EC_GROUP_get_curve_name(group) == NID_X9_62_prime256v1) {
+        if ((v->p256_step = P256Step_create((subseed_length + 7) / 8)) == NULL ||
+            getP256Affine(&(v->p256_client), group, client_point, v->ctx)) {
+            EcValidator_destroy(v);
+
+            return NULL;
+        }
+
+        P256Step_setBase(v->p256_step, host_seed);
+
+        return v;
+    }
+
+    if (EC_GROUP_get_curve_name(group) == NID_secp256k1) {
+        if ((v->k1_step = Secp256k1Step_create((subseed_length + 7) / 8)) == NULL ||
+            getSecp256k1Affine(&(v->k1_client), group, client_point, v->ctx)) {
+            EcValidator_destroy(v);
+
+            return NULL;
+        }
+
+        Secp256k1Step_setBase(v->k1_step, host_seed);
+
+        return v;
+    }
+#endif
+
+#ifndef ALWAYS_EC_MUL
+    if ((v->step = EcStep_create(v->group, SEED_SIZE, (subseed_length + 7) / 8)) == NULL ||
+        EcStep_setBase(v->step, v->ctx, host_seed)) {
+        EcValidator_destroy(v);
+
+        return NULL;
+    }
+#endif
+
     return v;
 }
 
@@ -258,9 +969,236 @@ void EcValidator_destroy(EcValidator* v) {
         EC_POINT_free(v->curr_point);
     }
 
+    Secp256k1Step_destroy(v->k1_step);
+    P256Step_destroy(v->p256_step);
+    EcStep_destroy(v->step);
+
+    free(v);
+}
+
+/// Set up the custom P-256 implementation for a validator, or the OpenSSL one otherwise.
+/// \return Returns 0 on success, or 1 on error.
+static int EcMitmValidator_createStep(EcMitmValidator* v, const unsigned char* host_seed) {
+    size_t window_size = (v->table->subseed_length + 7) / 8;
+
+#ifndef ALWAYS_OPENSSL_EC
+    if (EC_GROUP_get_curve_name(v->group) == NID_X9_62_prime256v1) {
+        v->p256_points = malloc(EC_MITM_QUERY_BATCH * sizeof(*(v->p256_points)));
+        v->p256_affine = malloc(EC_MITM_QUERY_BATCH * sizeof(*(v->p256_affine)));
+
+        if ((v->p256_step = P256Step_create(window_size)) == NULL || v->p256_points == NULL ||
+            v->p256_affine == NULL ||
+            getP256Affine(&(v->p256_target), v->group, v->target, v->ctx)) {
+            return 1;
+        }
+
+        P256Step_setBase(v->p256_step, host_seed);
+
+        return 0;
+    }
+#endif
+
+    for (size_t i = 0; i < EC_MITM_QUERY_BATCH; i++) {
+        if ((v->points[i] = EC_POINT_new(v->group)) == NULL) {
+            return 1;
+        }
+    }
+
+    return (v->curr_point = EC_POINT_new(v->group)) == NULL ||
+           (v->step = EcStep_create(v->group, SEED_SIZE, window_size)) == NULL ||
+           EcStep_setBase(v->step, v->ctx, host_seed);
+}
+
+EcMitmValidator* EcMitmValidator_create(const EC_GROUP* group, const EC_POINT* client_point,
+                                        const unsigned char* host_seed, const EcMitmTable* table) {
+    EcMitmValidator* v;
+    mpz_t cover;
+
+    if (group == NULL || client_point == NULL || host_seed == NULL || table == NULL ||
+        (v = calloc(1, sizeof(*v))) == NULL) {
+        return NULL;
+    }
+
+    v->group = group;
+    v->client_point = client_point;
+    v->table = table;
+    memcpy(v->host_seed, host_seed, SEED_SIZE);
+
+    v->target = EC_POINT_new(group);
+    v->check_point = EC_POINT_new(group);
+    v->x = BN_new();
+    v->ctx = BN_CTX_secure_new();
+
+    if (v->target == NULL || v->check_point == NULL || v->x == NULL || v->ctx == NULL ||
+        getEcPublicKey(v->target, v->ctx, group, host_seed, SEED_SIZE) ||
+        !EC_POINT_add(group, v->target, v->target, client_point, v->ctx) ||
+        !EC_POINT_make_affine(group, v->target, v->ctx) ||
+        EcMitmValidator_createStep(v, host_seed)) {
+        EcMitmValidator_destroy(v);
+
+        return NULL;
+    }
+
+    mpz_init(cover);
+
+    for (size_t i = 0; i <= table->subseed_length; i++) {
+        mpz_bin_uiui(cover, i, table->half);
+        v->covers[i] = (long long int)mpz_get_ui(cover);
+    }
+
+    mpz_clear(cover);
+
+    return v;
+}
+
+void EcMitmValidator_destroy(EcMitmValidator* v) {
+    if (v == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < EC_MITM_QUERY_BATCH; i++) {
+        EC_POINT_free(v->points[i]);
+    }
+
+    free(v->p256_affine);
+    free(v->p256_points);
+    P256Step_destroy(v->p256_step);
+    EcStep_destroy(v->step);
+    BN_CTX_free(v->ctx);
+    BN_free(v->x);
+    EC_POINT_free(v->check_point);
+    EC_POINT_free(v->curr_point);
+    EC_POINT_free(v->target);
+
     free(v);
 }
 
+void EcMitmValidator_setLastPerm(EcMitmValidator* v, const mpz_t last_perm) {
+    SeedIter iter;
+
+    if (v == NULL) {
+        return;
+    }
+
+    v->has_last_seed = !SeedIter_init(&iter, v->host_seed, SEED_SIZE, last_perm, last_perm);
+    v->pending = 0;
+    v->done = 0;
+
+    if (v->has_last_seed) {
+        memcpy(v->last_seed, SeedIter_get(&iter), SEED_SIZE);
+    }
+}
+
+X25519Validator* X25519Validator_create(const unsigned char* client_pub_key,
+                                        const unsigned char* host_seed, size_t subseed_length) {
+    X25519Validator* v = calloc(1, sizeof(*v));
+
+    if (v == NULL || client_pub_key == NULL || host_seed == NULL || subseed_length == 0 ||
+        subseed_length > SEED_SIZE * 8 || x25519EdwardsY(&(v->client_y), client_pub_key)) {
+        X25519Validator_destroy(v);
+
+        return NULL;
+    }
+
+#ifndef ALWAYS_EC_MUL
+    // Only the bytes holding the subseed are ever corrupted, and every seed is near the host seed
+    if ((v->step = X25519Step_create((subseed_length + 7) / 8)) == NULL) {
+        X25519Validator_destroy(v);
+
+        return NULL;
+    }
+
+    X25519Step_setBase(v->step, host_seed);
+#endif
+
+    return v;
+}
+
+void X25519Validator_destroy(X25519Validator* v) {
+    if (v == NULL) {
+        return;
+    }
+
+    X25519Step_destroy(v->step);
+
+    free(v);
+}
+
+#ifndef ALWAYS_EVP_HASH
+/// Build the tail, and the target for the 32-bit multi-buffer kernels, for the single-block kernel
+/// HashValidator_getBatch may pick for the validator's hash function, if there is one and the salt
+/// fits in its block.
+static void hashMbPrepare(HashValidator* v) {
+    int (*tail_func)(uint32_t*, const unsigned char*, size_t) = sha256MbTail;
+    void (*target_func)(HashMbTarget*, const uint32_t*, const unsigned char*);
+
+    switch (v->nid) {
+        case NID_md5:
+            tail_func = md5MbTail;
+            target_func = md5MbTarget;
+            break;
+        case NID_sha1:
+            target_func = sha1MbTarget;
+            break;
+        case NID_sha224:
+            target_func = sha224MbTarget;
+            break;
+        case NID_sha256:
+            target_func = sha256MbTarget;
+            break;
+        case NID_sha384:
+        case NID_sha512:
+            sha512MbTail(v->mb_tail64, v->salt, v->salt_size);
+            return;
+        default:
+            return;
+    }
+
+    if (!tail_func(v->mb_tail, v->salt, v->salt_size)) {
+        target_func(&v->mb_target, v->mb_tail, v->client_digest);
+    }
+}
+#endif
+
+#ifndef ALWAYS_EVP_SHA3
+/// Build the target for the parallel Keccak kernel HashValidator_getBatch may pick for the
+/// validator's hash function, if there is one and the salt and digest fit in its block.
+static void keccakMbPrepare(HashValidator* v) {
+    uint64_t tail[KECCAK_MB_TAIL_LANES];
+    size_t rate;
+    unsigned char suffix = SHA3_SUFFIX;
+
+    switch (v->nid) {
+        case NID_sha3_224:
+            rate = SHA3_224_RATE;
+            break;
+        case NID_sha3_256:
+            rate = SHA3_256_RATE;
+            break;
+        case NID_sha3_384:
+            rate = SHA3_384_RATE;
+            break;
+        case NID_sha3_512:
+            rate = SHA3_512_RATE;
+            break;
+        case NID_shake128:
+            rate = SHAKE128_RATE;
+            suffix = SHAKE_SUFFIX;
+            break;
+        case NID_shake256:
+            rate = SHAKE256_RATE;
+            suffix = SHAKE_SUFFIX;
+            break;
+        default:
+            return;
+    }
+
+    if (!keccakMbTail(tail, rate, suffix, v->salt, v->salt_size)) {
+        keccakMbTarget(&v->keccak_target, tail, rate, v->client_digest, v->digest_size);
+    }
+}
+#endif
+
 HashValidator* HashValidator_create(const EVP_MD* md, const unsigned char* client_digest,
                                     size_t digest_size, const unsigned char* salt,
                                     size_t salt_size) {
@@ -276,7 +1214,7 @@ HashValidator* HashValidator_create(const EVP_MD* md, const unsigned char* clien
     v->md = md;
     v->nid = EVP_MD_nid(md);
     v->is_xof = md == EVP_shake128() || md == EVP_shake256();
-    v->digest_size = v->is_xof ? EVP_MD_size(md) : digest_size;
+    v->digest_size = v->is_xof ? digest_size : (size_t)EVP_MD_size(md);
     v->client_digest = client_digest;
     v->salt = salt;
     v->salt_size = salt_size;
@@ -293,6 +1231,13 @@ HashValidator* HashValidator_create(const EVP_MD* md, const unsigned char* clien
         EVP_MD_CTX_set_flags(v->ctx, EVP_MD_CTX_FLAG_ONESHOT);
     }
 
+#ifndef ALWAYS_EVP_HASH
+    hashMbPrepare(v);
+#endif
+#ifndef ALWAYS_EVP_SHA3
+    keccakMbPrepare(v);
+#endif
+
     return v;
 }
 
@@ -315,6 +1260,7 @@ void HashValidator_destroy(HashValidator* v) {
 Kang12Validator* Kang12Validator_create(const unsigned char* client_digest, size_t digest_size,
                                         const unsigned char* salt, size_t salt_size) {
     Kang12Validator* v = malloc(sizeof(*v));
+    uint64_t tail[KECCAK_MB_TAIL_LANES];
 
     if (v == NULL || client_digest == NULL || digest_size == 0 ||
         (salt == NULL && salt_size != 0) || (salt != NULL && salt_size == 0)) {
@@ -329,6 +1275,10 @@ Kang12Validator* Kang12Validator_create(const unsigned char* client_digest, size
     v->salt_size = salt_size;
     v->curr_digest = malloc(v->digest_size * sizeof(*(v->curr_digest)));
 
+    if (!kang12MbTail(tail, salt, salt_size)) {
+        keccakMbTarget(&v->keccak_target, tail, KANG12_RATE, client_digest, digest_size);
+    }
+
     return v;
 }
 
@@ -344,27 +1294,52 @@ void Kang12Validator_destroy(Kang12Validator* v) {
     free(v);
 }
 
-int findMatchingSeed(unsigned char* client_seed, const unsigned char* host_seed,
-                     const mpz_t first_perm, const mpz_t last_perm, int all,
-                     long long int* validated_keys,
+/// Copy the seed behind a block's first match into client_seed.
+/// \param matches The block's mask of matching lanes, which must not be 0.
+static void loadMatchingSeed(unsigned char* client_seed, const unsigned char* seeds,
+                             uint32_t matches, const CryptoBatch* crypto_batch) {
+    if (crypto_batch->match_seed != NULL) {
+        memcpy(client_seed, crypto_batch->match_seed, SEED_SIZE);
+    } else {
+        SeedIter_loadLane(client_seed, seeds, (size_t)__builtin_ctz(matches), crypto_batch->lanes,
+                          crypto_batch->layout);
+    }
+}
+
 #ifdef USE_MPI
-                     int* signal, int verbose, int my_rank, int nprocs,
+#define SEARCH_SIGNAL_PARAMS int* signal, int verbose, int my_rank, int nprocs
+#define SEARCH_SIGNAL_ARGS signal, verbose, my_rank, nprocs
 #else
-                     const int* signal,
+#define SEARCH_SIGNAL_PARAMS const int* signal
+#define SEARCH_SIGNAL_ARGS signal
 #endif
-                     int (*crypto_func)(const unsigned char*, void*), int (*crypto_cmp)(void*),
-                     void* crypto_args) {
+
+/// The search loop behind findMatchingSeed. Always inlined, so that each instantiation gets func as
+/// a compile-time constant and can inline it into the loop.
+/// \param func The batch function to use instead of crypto_batch->func, or NULL to only iterate.
+static inline __attribute__((always_inline)) int searchSeeds(
+        unsigned char* client_seed, const unsigned char* host_seed, const mpz_t first_perm,
+        const mpz_t last_perm, int all, long long int* validated_keys, SEARCH_SIGNAL_PARAMS,
+        const CryptoBatch* crypto_batch, void* crypto_args, CryptoBatchFunc func) {
     // Declaration
-    int status = 0, cmp_status = 1;
+    int status = 0;
     SeedIter iter;
-    const unsigned char* curr_seed;
+    alignas(SEED_BATCH_ALIGN) unsigned char seeds[SEED_BATCH_MAX * SEED_SIZE];
+    size_t lanes = crypto_batch->lanes, produced;
+    uint32_t matches;
 #ifdef USE_MPI
     int probe_flag = 0;
     long long int iter_count = 0;
 
     MPI_Request* requests;
     MPI_Status* statuses;
+#endif
 
+    if (lanes == 0 || lanes > SEED_BATCH_MAX) {
+        return -1;
+    }
+
+#ifdef USE_MPI
     if ((requests = malloc(nprocs * sizeof(*(requests)))) == NULL) {
         return -1;
     }
@@ -378,27 +1353,30 @@ int findMatchingSeed(unsigned char* client_seed, const unsigned char* host_seed,
 
     SeedIter_init(&iter, host_seed, SEED_SIZE, first_perm, last_perm);
 
-    while (!SeedIter_end(&iter) && (all || !(*signal))) {
+    while ((all || !(*signal)) &&
+           (produced = SeedIter_nextN(&iter, seeds, lanes, crypto_batch->layout)) > 0) {
         if (validated_keys != NULL) {
-            ++(*validated_keys);
+            *validated_keys += (long long int)produced;
         }
-        curr_seed = SeedIter_get(&iter);
 
-        // If crypto_func fails for some reason, break prematurely.
-        if (crypto_func != NULL && crypto_func(curr_seed, crypto_args)) {
-            status = -1;
-            break;
+        if (func == NULL) {
+            continue;
         }
 
-        // If crypto_cmp fails for some reason, break prematurely.
-        if (crypto_cmp != NULL && (cmp_status = crypto_cmp(crypto_args)) < 0) {
+        // If func fails for some reason, break prematurely.
+        if (func(&matches, seeds, lanes, crypto_args)) {
             status = -1;
             break;
         }
 
+        // Ignore the padded lanes past the end of the iterator
+        if (produced < lanes) {
+            matches &= (UINT32_C(1) << produced) - 1;
+        }
+
         // If the new crypto output is the same as the passed in client crypto output, set status to
         // true and break
-        if (cmp_status == 0) {
+        if (matches) {
             status = 1;
 
 #ifdef USE_MPI
@@ -408,7 +1386,7 @@ int findMatchingSeed(unsigned char* client_seed, const unsigned char* host_seed,
                 fprintf(stderr, "INFO: Found by rank: %d, alerting ranks ...\n", my_rank);
             }
 
-            memcpy(client_seed, curr_seed, SEED_SIZE);
+            loadMatchingSeed(client_seed, seeds, matches, crypto_batch);
 
             if (!all) {
                 // alert all ranks that the key was found, including yourself
@@ -429,7 +1407,7 @@ int findMatchingSeed(unsigned char* client_seed, const unsigned char* host_seed,
             // This might happen more than once if the # of threads exceeds the number of possible
             // keys
 #pragma omp critical
-            memcpy(client_seed, curr_seed, SEED_SIZE);
+            loadMatchingSeed(client_seed, seeds, matches, crypto_batch);
             if (!all) {
                 break;
             }
@@ -445,8 +1423,6 @@ int findMatchingSeed(unsigned char* client_seed, const unsigned char* host_seed,
             }
         }
 #endif
-
-        SeedIter_next(&iter);
     }
 
 #ifdef USE_MPI
@@ -456,3 +1432,145 @@ int findMatchingSeed(unsigned char* client_seed, const unsigned char* host_seed,
 
     return status;
 }
+
+typedef int (*SearchFunc)(unsigned char* client_seed, const unsigned char* host_seed,
+                          const mpz_t first_perm, const mpz_t last_perm, int all,
+                          long long int* validated_keys, SEARCH_SIGNAL_PARAMS,
+                          const CryptoBatch* crypto_batch, void* crypto_args);
+
+// Instantiate a search loop with one batch function inlined into it
+#define SEARCH_SEEDS(name)                                                                        \
+    static int searchSeeds_##name(unsigned char* client_seed, const unsigned char* host_seed,     \
+                                  const mpz_t first_perm, const mpz_t last_perm, int all,         \
+                                  long long int* validated_keys, SEARCH_SIGNAL_PARAMS,            \
+                                  const CryptoBatch* crypto_batch, void* crypto_args) {           \
+        return searchSeeds(client_seed, host_seed, first_perm, last_perm, all, validated_keys,    \
+                           SEARCH_SIGNAL_ARGS, crypto_batch, crypto_args, CryptoBatch_##name);    \
+    }
+
+// Instantiate the search loops for an unsalted and a salted hash validator
+#define SEARCH_SEEDS_HASH(name) \
+    SEARCH_SEEDS(name)          \
+    SEARCH_SEEDS(name##_salted)
+
+SEARCH_SEEDS(aes256)
+SEARCH_SEEDS(cipher)
+SEARCH_SEEDS(chacha20)
+SEARCH_SEEDS(ec)
+#if !defined(ALWAYS_EC_MUL) && !defined(ALWAYS_OPENSSL_EC)
+SEARCH_SEEDS(p256)
+SEARCH_SEEDS(secp256k1)
+#endif
+SEARCH_SEEDS(ecMitm)
+SEARCH_SEEDS(x25519)
+SEARCH_SEEDS(hash)
+#ifndef ALWAYS_EVP_HASH
+SEARCH_SEEDS_HASH(md5)
+SEARCH_SEEDS_HASH(sha1)
+SEARCH_SEEDS_HASH(sha224)
+SEARCH_SEEDS_HASH(sha256)
+SEARCH_SEEDS_HASH(sha384)
+SEARCH_SEEDS_HASH(sha512)
+SEARCH_SEEDS(md5_mb)
+SEARCH_SEEDS(sha1_mb)
+SEARCH_SEEDS(sha224_mb)
+SEARCH_SEEDS(sha256_mb)
+SEARCH_SEEDS(sha384_mb)
+SEARCH_SEEDS(sha512_mb)
+SEARCH_SEEDS(sha1_ni)
+SEARCH_SEEDS(sha224_ni)
+SEARCH_SEEDS(sha256_ni)
+#endif
+#ifndef ALWAYS_EVP_SHA3
+SEARCH_SEEDS_HASH(sha3_224)
+SEARCH_SEEDS_HASH(sha3_256)
+SEARCH_SEEDS_HASH(sha3_384)
+SEARCH_SEEDS_HASH(sha3_512)
+SEARCH_SEEDS_HASH(shake128)
+SEARCH_SEEDS_HASH(shake256)
+SEARCH_SEEDS(sha3_224_mb)
+SEARCH_SEEDS(sha3_256_mb)
+SEARCH_SEEDS(sha3_384_mb)
+SEARCH_SEEDS(sha3_512_mb)
+SEARCH_SEEDS(shake128_mb)
+SEARCH_SEEDS(shake256_mb)
+#endif
+SEARCH_SEEDS(kang12)
+SEARCH_SEEDS(kang12_mb)
+
+#define SEARCH_FUNC(name) {CryptoBatch_##name, searchSeeds_##name}
+#define SEARCH_FUNC_HASH(name) SEARCH_FUNC(name), SEARCH_FUNC(name##_salted)
+
+// The specialized search loop for every batch function that the getBatch functions hand out
+static const struct {
+    CryptoBatchFunc batch_func;
+    SearchFunc search_func;
+} search_funcs[] = {
+        SEARCH_FUNC(aes256),
+        SEARCH_FUNC(cipher),
+        SEARCH_FUNC(chacha20),
+        SEARCH_FUNC(ec),
+#if !defined(ALWAYS_EC_MUL) && !defined(ALWAYS_OPENSSL_EC)
+        SEARCH_FUNC(p256),
+        SEARCH_FUNC(secp256k1),
+#endif
+        SEARCH_FUNC(ecMitm),
+        SEARCH_FUNC(x25519),
+        SEARCH_FUNC(hash),
+#ifndef ALWAYS_EVP_HASH
+        SEARCH_FUNC_HASH(md5),
+        SEARCH_FUNC_HASH(sha1),
+        SEARCH_FUNC_HASH(sha224),
+        SEARCH_FUNC_HASH(sha256),
+        SEARCH_FUNC_HASH(sha384),
+        SEARCH_FUNC_HASH(sha512),
+        SEARCH_FUNC(md5_mb),
+        SEARCH_FUNC(sha1_mb),
+        SEARCH_FUNC(sha224_mb),
+        SEARCH_FUNC(sha256_mb),
+        SEARCH_FUNC(sha384_mb),
+        SEARCH_FUNC(sha512_mb),
+        SEARCH_FUNC(sha1_ni),
+        SEARCH_FUNC(sha224_ni),
+        SEARCH_FUNC(sha256_ni),
+#endif
+#ifndef ALWAYS_EVP_SHA3
+        SEARCH_FUNC_HASH(sha3_224),
+        SEARCH_FUNC_HASH(sha3_256),
+        SEARCH_FUNC_HASH(sha3_384),
+        SEARCH_FUNC_HASH(sha3_512),
+        SEARCH_FUNC_HASH(shake128),
+        SEARCH_FUNC_HASH(shake256),
+        SEARCH_FUNC(sha3_224_mb),
+        SEARCH_FUNC(sha3_256_mb),
+        SEARCH_FUNC(sha3_384_mb),
+        SEARCH_FUNC(sha3_512_mb),
+        SEARCH_FUNC(shake128_mb),
+        SEARCH_FUNC(shake256_mb),
+#endif
+        SEARCH_FUNC(kang12),
+        SEARCH_FUNC(kang12_mb),
+};
+
+int findMatchingSeed(unsigned char* client_seed, const unsigned char* host_seed,
+                     const mpz_t first_perm, const mpz_t last_perm, int all,
+                     long long int* validated_keys,
+#ifdef USE_MPI
+                     int* signal, int verbose, int my_rank, int nprocs,
+#else
+                     const int* signal,
+#endif
+                     const CryptoBatch* crypto_batch, void* crypto_args) {
+    // Look up the specialized loop once per search instead of calling through a pointer per block
+    for (size_t i = 0; i < sizeof(search_funcs) / sizeof(*search_funcs); ++i) {
+        if (search_funcs[i].batch_func == crypto_batch->func) {
+            return search_funcs[i].search_func(client_seed, host_seed, first_perm, last_perm, all,
+                                               validated_keys, SEARCH_SIGNAL_ARGS, crypto_batch,
+                                               crypto_args);
+        }
+    }
+
+    // Batch functions from elsewhere, and plain iteration, take the generic loop
+    return searchSeeds(client_seed, host_seed, first_perm, last_perm, all, validated_keys,
+                       SEARCH_SIGNAL_ARGS, crypto_batch, crypto_args, crypto_batch->func);
+}
@@ -8,9 +8,41 @@
 #include <gmp.h>
 #include <openssl/ec.h>
 #include <openssl/evp.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 #include "crypto/aes256-ni_enc.h"
+#include "crypto/chacha20.h"
+#include "crypto/ec.h"
+#include "crypto/hash_mb.h"
+#include "crypto/keccak_mb.h"
+#include "crypto/x25519.h"
+#include "ec_mitm.h"
+#include "seed_iter.h"
+
+/// Validate a whole block of candidate seeds at once, fusing the cryptographic function with the
+/// comparison against the client's output.
+/// \param matches The output bitmask, where bit j is set if lane j matched.
+/// \param seeds The block of candidate seeds, as filled by SeedIter_nextN.
+/// \param count How many lanes the block has.
+/// \param args The validator, e.g. a CipherValidator.
+/// \return Returns 0 on success, or 1 on error.
+typedef int (*CryptoBatchFunc)(uint32_t* matches, const unsigned char* seeds, size_t count,
+                               void* args);
+
+typedef struct CryptoBatch {
+    // If NULL, then only seed iteration is performed
+    CryptoBatchFunc func;
+    // How many seeds to validate at once, up to SEED_BATCH_MAX
+    size_t lanes;
+    SeedLayout layout;
+    // Where func leaves the seed behind a match, for validators whose matches aren't any lane's
+    // seed. func then only sets bit 0 of its mask. If NULL, the seed is the matching lane's.
+    const unsigned char* match_seed;
+} CryptoBatch;
+
+// Block size used by the scalar fallbacks, which only amortizes the loop overhead
+#define CRYPTO_BATCH_SCALAR_LANES 8
 
 typedef struct CipherValidator {
     const EVP_CIPHER* evp_cipher;
@@ -25,8 +57,67 @@ typedef struct EcValidator {
     const EC_POINT* client_point;
     EC_POINT* curr_point;
     BN_CTX* ctx;
+    // Steps curr_point from the last seed's public key to the next one's
+    EcStep* step;
+    // The same for the custom P-256 implementation, which is used instead if p256_step is set
+    P256Step* p256_step;
+    // The public key each lane of P256Step_getLanes worked out last
+    P256Point p256_lanes[P256_STEP_LANES];
+    P256Affine p256_client;
+    // The same for the custom secp256k1 implementation, which is used instead if k1_step is set
+    Secp256k1Step* k1_step;
+    Secp256k1Point k1_point;
+    Secp256k1Affine k1_client;
 } EcValidator;
 
+// How many lanes EcMitmValidator holds back to make affine at once, sharing a single inversion
+#define EC_MITM_QUERY_BATCH (SEED_BATCH_MAX * 16)
+
+/// Walks the ways to corrupt the rest of the positions of an EcMitmTable, looking up what is left
+/// of the client's public key for each.
+typedef struct EcMitmValidator {
+    const EC_GROUP* group;
+    const EC_POINT* client_point;
+    const EcMitmTable* table;
+    unsigned char host_seed[SEED_SIZE];
+    // The client's public key plus the host's, which less the public key of a lane leaves what the
+    // table's positions have to add
+    EC_POINT* target;
+    EC_POINT* curr_point;
+    // The lanes held back since the last lookup, which are looked up once the batch is full or the
+    // walk reaches its last seed, after which any more lanes only pad out the walk's last block
+    EC_POINT* points[EC_MITM_QUERY_BATCH];
+    unsigned char seeds[EC_MITM_QUERY_BATCH * SEED_SIZE];
+    size_t pending;
+    unsigned char last_seed[SEED_SIZE];
+    int has_last_seed, done;
+    BIGNUM* x;
+    BN_CTX* ctx;
+    EcStep* step;
+    // The same for the custom P-256 implementation, which is used instead if p256_step is set
+    P256Step* p256_step;
+    P256Point p256_lanes[P256_STEP_LANES];
+    P256Affine p256_target;
+    P256Point* p256_points;
+    P256Affine* p256_affine;
+    // The public key of a seed a lookup confirms
+    EC_POINT* check_point;
+    // The whole seed behind the last match, since a lane only holds the rest of its positions
+    unsigned char client_seed[SEED_SIZE];
+    // How many seeds the lanes so far stand for, and covers[i] how many a lane whose lowest
+    // position is i stands for, which is every way to corrupt the table's positions below i
+    long long int covered;
+    long long int covers[SEED_SIZE * 8 + 1];
+} EcMitmValidator;
+
+typedef struct X25519Validator {
+    // Steps point from the last seed's public key to the next one's
+    X25519Step* step;
+    X25519Point point;
+    // The Edwards y-coordinate of the client's public key, which stands for it as u does
+    X25519Fe client_y;
+} X25519Validator;
+
 typedef struct HashValidator {
     const EVP_MD* md;
     int is_xof;
@@ -35,19 +126,34 @@ typedef struct HashValidator {
     EVP_MD_CTX* ctx;
     const unsigned char *client_digest, *salt;
     unsigned char* curr_digest;
+    // The rest of the block after the seed and the target worked back from client_digest, which
+    // the 32-bit multi-buffer kernels only need built once per search. The SHA-NI kernels share
+    // the tail.
+    uint32_t mb_tail[SHA256_MB_TAIL_WORDS];
+    HashMbTarget mb_target;
+    // The same tail for the 64-bit multi-buffer kernels
+    uint64_t mb_tail64[SHA512_MB_TAIL_WORDS];
+    // The same for the parallel Keccak kernel, with the constant lanes absorbed ahead of time
+    KeccakMbTarget keccak_target;
 } HashValidator;
 
 typedef struct Kang12Validator {
     size_t digest_size, salt_size;
     const unsigned char *client_digest, *salt;
     unsigned char* curr_digest;
+    // What the parallel Keccak kernel hashes the seeds against, built once per search
+    KeccakMbTarget keccak_target;
 } Kang12Validator;
 
 int CryptoFunc_aes256(const unsigned char* curr_seed, void* args);
 int CryptoCmp_aes256(void* args);
+int CryptoBatch_aes256(uint32_t* matches, const unsigned char* seeds, size_t count, void* args);
 
 int CryptoFunc_cipher(const unsigned char* curr_seed, void* args);
 int CryptoCmp_cipher(void* args);
+int CryptoBatch_cipher(uint32_t* matches, const unsigned char* seeds, size_t count, void* args);
+/// A ChaCha20-only batch function, which takes its seeds in SEED_LAYOUT_SOA32.
+int CryptoBatch_chacha20(uint32_t* matches, const unsigned char* seeds, size_t count, void* args);
 
 CipherValidator* CipherValidator_create(const EVP_CIPHER* evp_cipher,
                                         const unsigned char* client_cipher,
@@ -57,12 +163,57 @@ void CipherValidator_destroy(CipherValidator* v);
 
 int CryptoFunc_ec(const unsigned char* curr_seed, void* args);
 int CryptoCmp_ec(void* args);
+int CryptoBatch_ec(uint32_t* matches, const unsigned char* seeds, size_t count, void* args);
+/// Pick CryptoBatch_ec, or the batch function for the custom P-256 implementation if the
+/// validator uses it, along with the lanes and layout it expects.
+/// \param crypto_batch The batch description to fill in.
+/// \param v The validator that will be passed as the batch function's arguments.
+void EcValidator_getBatch(CryptoBatch* crypto_batch, const EcValidator* v);
 
 /// \param EC_GROUP The EC group to use
 /// \param EC_POINT The client EC public key
-EcValidator* EcValidator_create(const EC_GROUP* group, const EC_POINT* client_point);
+/// \param host_seed The original host seed, which the public keys are stepped from.
+/// \param subseed_length How many of the seed's leading bits can be corrupted.
+EcValidator* EcValidator_create(const EC_GROUP* group, const EC_POINT* client_point,
+                                const unsigned char* host_seed, size_t subseed_length);
 void EcValidator_destroy(EcValidator* v);
 
+/// Hold each lane back until EC_MITM_QUERY_BATCH of them or the last of the walk's seeds are in,
+/// then look them all up at once. Since a lookup only finds a match blocks after its lane, a match
+/// sets bit 0 and leaves the whole seed in the validator's client_seed.
+int CryptoBatch_ecMitm(uint32_t* matches, const unsigned char* seeds, size_t count, void* args);
+/// Fill in CryptoBatch_ecMitm along with the lanes it expects, and where it leaves a match.
+/// \param crypto_batch The batch description to fill in.
+/// \param v The validator that will be passed as the batch function's arguments.
+void EcMitmValidator_getBatch(CryptoBatch* crypto_batch, const EcMitmValidator* v);
+
+/// \param group The EC group to use.
+/// \param client_point The client EC public key.
+/// \param host_seed The original host seed.
+/// \param table The filled table to look up.
+EcMitmValidator* EcMitmValidator_create(const EC_GROUP* group, const EC_POINT* client_point,
+                                        const unsigned char* host_seed, const EcMitmTable* table);
+void EcMitmValidator_destroy(EcMitmValidator* v);
+
+/// Set the last permutation the walk is going to hand the validator, so that it knows when the
+/// last lane is in. Must be called before the first batch, which fails otherwise.
+/// \param v The validator.
+/// \param last_perm The last permutation of the walk.
+void EcMitmValidator_setLastPerm(EcMitmValidator* v, const mpz_t last_perm);
+
+/// Work out the public key of every seed in a block after clamping it, stepping from the last
+/// seed's on the Edwards curve, and compare it against the client's.
+int CryptoBatch_x25519(uint32_t* matches, const unsigned char* seeds, size_t count, void* args);
+
+/// \param client_pub_key The client's X25519_KEY_SIZE byte public key.
+/// \param host_seed The original host seed, which the public keys are stepped from.
+/// \param subseed_length How many of the seed's leading bits can be corrupted.
+/// \return A new X25519Validator, or NULL on error, including if client_pub_key is u = -1, which no
+/// private key has.
+X25519Validator* X25519Validator_create(const unsigned char* client_pub_key,
+                                        const unsigned char* host_seed, size_t subseed_length);
+void X25519Validator_destroy(X25519Validator* v);
+
 HashValidator* HashValidator_create(const EVP_MD* md, const unsigned char* client_digest,
                                     size_t digest_size, const unsigned char* salt,
                                     size_t salt_size);
@@ -70,6 +221,12 @@ void HashValidator_destroy(HashValidator* v);
 
 int CryptoFunc_hash(const unsigned char* curr_seed, void* args);
 int CryptoCmp_hash(void* args);
+int CryptoBatch_hash(uint32_t* matches, const unsigned char* seeds, size_t count, void* args);
+/// Pick the batch function specialized for the validator's hash function and salt, along with the
+/// lanes and layout it expects, falling back to CryptoBatch_hash for those that go through EVP.
+/// \param crypto_batch The batch description to fill in.
+/// \param v The validator that will be passed as the batch function's arguments.
+void HashValidator_getBatch(CryptoBatch* crypto_batch, const HashValidator* v);
 
 Kang12Validator* Kang12Validator_create(const unsigned char* client_digest, size_t digest_size,
                                         const unsigned char* salt, size_t salt_size);
@@ -77,9 +234,16 @@ void Kang12Validator_destroy(Kang12Validator* v);
 
 int CryptoFunc_kang12(const unsigned char* curr_seed, void* args);
 int CryptoCmp_kang12(void* args);
+int CryptoBatch_kang12(uint32_t* matches, const unsigned char* seeds, size_t count, void* args);
+/// Pick the batch function for the validator's salt and digest size, along with the lanes and
+/// layout it expects, falling back to CryptoBatch_kang12 if they don't fit in a single block.
+/// \param crypto_batch The batch description to fill in.
+/// \param v The validator that will be passed as the batch function's arguments.
+void Kang12Validator_getBatch(CryptoBatch* crypto_batch, const Kang12Validator* v);
 
 /// Given a starting permutation, iterate forward through every possible permutation until one
-/// that's matching last_perm is found, or until a matching crytographic output is found.
+/// that's matching last_perm is found, or until a matching crytographic output is found. Seeds are
+/// validated in blocks of crypto_batch->lanes.
 /// \param client_seed The output (potentially) corrupted client seed.
 /// \param host_seed The original host seed.
 /// \param first_perm The permutation to start iterating from.
@@ -91,6 +255,8 @@ int CryptoCmp_kang12(void* args);
 /// \param verbose (MPI only) A boolean on whether to print verbose output or not
 /// \param my_rank (MPI only) This process's MPI rank
 /// \param nprocs (MPI only) How many total MPI ranks there are
+/// \param crypto_batch How to validate each block of seeds.
+/// \param crypto_args The validator passed along to crypto_batch->func.
 /// \return Returns a 1 if found or a 0 if not. Returns a -1 if an error has
 /// occurred.
 int findMatchingSeed(unsigned char* client_seed, const unsigned char* host_seed,
@@ -101,7 +267,6 @@ int findMatchingSeed(unsigned char* client_seed, const unsigned char* host_seed,
 #else
                      const int* signal,
 #endif
-                     int (*crypto_func)(const unsigned char*, void*), int (*crypto_cmp)(void*),
-                     void* crypto_args);
+                     const CryptoBatch* crypto_batch, void* crypto_args);
 
 #endif  // RBC_VALIDATOR_VALIDATOR_H_
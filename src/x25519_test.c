@@ -0,0 +1,170 @@
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "crypto/x25519.h"
+
+/// Work out a public key with OpenSSL's X25519.
+/// \param pub_key The output X25519_KEY_SIZE byte public key.
+/// \param priv_key The X25519_KEY_SIZE byte private key.
+/// \return Returns 0 on success, or 1 on error.
+int evpX25519PublicKey(unsigned char* pub_key, const unsigned char* priv_key) {
+    EVP_PKEY* pkey;
+    size_t len = X25519_KEY_SIZE;
+    int status;
+
+    if ((pkey = EVP_PKEY_new_raw_private_key(EVP_PKEY_X25519, NULL, priv_key, X25519_KEY_SIZE)) ==
+        NULL) {
+        fprintf(stderr, "ERROR: EVP_PKEY_new_raw_private_key failed.\nOpenSSL Error: %s\n",
+                ERR_error_string(ERR_get_error(), NULL));
+
+        return 1;
+    }
+
+    status = !EVP_PKEY_get_raw_public_key(pkey, pub_key, &len) || len != X25519_KEY_SIZE;
+    EVP_PKEY_free(pkey);
+
+    return status;
+}
+
+/// Check a point against OpenSSL's public key for a private key, both as bytes and through its
+/// Edwards y-coordinate.
+/// \return Returns 0 if the point matched, 1 if it didn't, or -1 on error.
+int x25519PointCmp(const X25519Point* point, const unsigned char* priv_key) {
+    unsigned char pub_key[X25519_KEY_SIZE], expected_pub_key[X25519_KEY_SIZE];
+    X25519Fe y;
+
+    if (evpX25519PublicKey(expected_pub_key, priv_key) || x25519EdwardsY(&y, expected_pub_key)) {
+        return -1;
+    }
+
+    x25519PointToBytes(pub_key, point);
+
+    return memcmp(pub_key, expected_pub_key, X25519_KEY_SIZE) != 0 ||
+           !x25519PointEqualsY(point, &y);
+}
+
+/// Work out the public keys of a few private keys with x25519PublicKey and check them against
+/// OpenSSL's.
+/// \param private_key A private key to derive the others from.
+/// \return Returns 0 if every public key matched, 1 if one didn't, or -1 on error.
+int x25519PublicKeyTest(const unsigned char* private_key) {
+    unsigned char key[X25519_KEY_SIZE], pub_key[X25519_KEY_SIZE];
+    unsigned char expected_pub_key[X25519_KEY_SIZE];
+    // All zeros and all ones only keep the bits clamping sets, and the rest fill every byte
+    const unsigned char fills[] = {0x00, 0xff, 0x80, 0x55};
+    int status = 0;
+
+    for (size_t i = 0; i <= sizeof(fills) / sizeof(*fills) && !status; i++) {
+        if (i < sizeof(fills) / sizeof(*fills)) {
+            memset(key, fills[i], X25519_KEY_SIZE);
+        } else {
+            memcpy(key, private_key, X25519_KEY_SIZE);
+        }
+
+        x25519PublicKey(pub_key, key);
+
+        if (evpX25519PublicKey(expected_pub_key, key)) {
+            status = -1;
+        } else if ((status = memcmp(pub_key, expected_pub_key, X25519_KEY_SIZE) != 0)) {
+            fprintf(stderr, "ERROR: x25519PublicKey was wrong for key %zu.\n", i);
+        }
+    }
+
+    return status;
+}
+
+/// Step through a few private keys that each corrupt a base key, some of them in bits clamping
+/// fixes, and check every public key X25519Step_get works out against OpenSSL's.
+/// \param private_key The base private key.
+/// \return Returns 0 if every public key matched, 1 if one didn't, or -1 on error.
+int x25519StepTest(const unsigned char* private_key) {
+    // Each entry is a list of the bits to flip from the base key, ending in -1. The window is the
+    // lowest 32 bits of the scalar, so the fourth key has to start over from a multiplication, as
+    // does the second, which is too far from both the base and the last key. The fifth and last
+    // only flip bits that clamping fixes.
+    const int flips[][X25519_STEP_MAX_FLIPS + 2] = {
+            {3, 9, 31, -1},
+            {4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, -1},
+            {3, 10, -1},
+            {3, 200, -1},
+            {0, 1, 2, 254, 255, -1},
+            {0, 3, 255, -1},
+            {1, -1},
+    };
+    unsigned char key[X25519_KEY_SIZE];
+    X25519Point point;
+    X25519Step* step;
+    int status = 0;
+
+    if ((step = X25519Step_create(4)) == NULL) {
+        return -1;
+    }
+
+    X25519Step_setBase(step, private_key);
+
+    for (size_t i = 0; i < sizeof(flips) / sizeof(*flips) && !status; i++) {
+        memcpy(key, private_key, X25519_KEY_SIZE);
+
+        for (const int* bit = flips[i]; *bit >= 0; bit++) {
+            // Bit 0 of the scalar is the lowest bit of the first byte
+            key[*bit / 8] ^= 1 << (*bit % 8);
+        }
+
+        X25519Step_get(step, &point, key);
+
+        if ((status = x25519PointCmp(&point, key)) > 0) {
+            fprintf(stderr, "ERROR: X25519Step_get was wrong for key %zu.\n", i);
+        }
+    }
+
+    X25519Step_destroy(step);
+
+    return status;
+}
+
+int main() {
+    // Alice's private key and public key from Sec. 6.1 of RFC 7748
+    const unsigned char private_key[X25519_KEY_SIZE] = {
+            0x77, 0x07, 0x6d, 0x0a, 0x73, 0x18, 0xa5, 0x7d, 0x3c, 0x16, 0xc1,
+            0x72, 0x51, 0xb2, 0x66, 0x45, 0xdf, 0x4c, 0x2f, 0x87, 0xeb, 0xc0,
+            0x99, 0x2a, 0xb1, 0x77, 0xfb, 0xa5, 0x1d, 0xb9, 0x2c, 0x2a,
+    };
+    const unsigned char expected_public_key[X25519_KEY_SIZE] = {
+            0x85, 0x20, 0xf0, 0x09, 0x89, 0x30, 0xa7, 0x54, 0x74, 0x8b, 0x7d,
+            0xdc, 0xb4, 0x3e, 0xf7, 0x5a, 0x0d, 0xbf, 0x3a, 0x0d, 0x26, 0x38,
+            0x1a, 0xf4, 0xeb, 0xa4, 0xa9, 0x8e, 0xaa, 0x9b, 0x4e, 0x6a,
+    };
+    unsigned char public_key[X25519_KEY_SIZE];
+    int status = EXIT_SUCCESS;
+
+    x25519PublicKey(public_key, private_key);
+
+    printf("Public Key Generation: Test ");
+    if (memcmp(public_key, expected_public_key, X25519_KEY_SIZE) == 0) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+        status = EXIT_FAILURE;
+    }
+
+    printf("Public Keys Against OpenSSL: Test ");
+    if (x25519PublicKeyTest(private_key) == 0) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+        status = EXIT_FAILURE;
+    }
+
+    printf("Stepped Public Keys: Test ");
+    if (x25519StepTest(private_key) == 0) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+        status = EXIT_FAILURE;
+    }
+
+    return status;
+}